@@ -0,0 +1,143 @@
+#define _GNU_SOURCE
+#include <stdio.h>
+#include <stdlib.h>
+#include "affinity.h"
+
+#define NODE_CPULIST_PATH "/sys/devices/system/node/node%zu/cpulist"
+
+/* Zwraca 'n'-ty (licząc od zera, cyklicznie) procesor ze zbioru 'set',
+ * lub -1 gdy zbiór jest pusty. */
+static int nth_cpu(const cpu_set_t *set, size_t n) {
+    int count = CPU_COUNT(set);
+
+    if (count == 0) {
+        return -1;
+    }
+
+    n %= (size_t) count;
+
+    for (int cpu = 0; cpu < CPU_SETSIZE; cpu++) {
+        if (CPU_ISSET(cpu, set) && n-- == 0) {
+            return cpu;
+        }
+    }
+
+    return -1;
+}
+
+/* Wczytuje listę procesorów węzła NUMA w formacie sysfs (np. "0-3,8-11").
+ * Zwraca false, jeżeli węzeł nie istnieje. */
+static bool read_node_cpus(size_t node, cpu_set_t *set) {
+    char path[64];
+    FILE *file;
+    unsigned long first, last;
+
+    snprintf(path, sizeof path, NODE_CPULIST_PATH, node);
+
+    if ((file = fopen(path, "r")) == NULL) {
+        return false;
+    }
+
+    CPU_ZERO(set);
+
+    while (fscanf(file, "%lu", &first) == 1) {
+        last = first;
+
+        if (fscanf(file, "-%lu", &last) == EOF) {
+            last = first;
+        }
+
+        for (unsigned long cpu = first; cpu <= last && cpu < CPU_SETSIZE; cpu++) {
+            CPU_SET(cpu, set);
+        }
+
+        if (fgetc(file) != ',') {
+            break;
+        }
+    }
+
+    fclose(file);
+
+    return true;
+}
+
+// Zwraca liczbę węzłów NUMA, które mają przynajmniej jeden dozwolony procesor.
+static size_t usable_nodes(const cpu_set_t *allowed) {
+    cpu_set_t node_cpus;
+    size_t count = 0;
+
+    for (size_t node = 0; read_node_cpus(node, &node_cpus); node++) {
+        CPU_AND(&node_cpus, &node_cpus, allowed);
+
+        if (CPU_COUNT(&node_cpus) > 0) {
+            count++;
+        }
+    }
+
+    return count;
+}
+
+/* Zapisuje pod 'set' procesory 'n'-tego (cyklicznie) węzła NUMA spośród
+ * tych, które mają dozwolone procesory. */
+static void nth_node_cpus(const cpu_set_t *allowed, size_t n, cpu_set_t *set) {
+    cpu_set_t node_cpus;
+    size_t nodes = usable_nodes(allowed);
+
+    if (nodes == 0) {
+        *set = *allowed;
+        return;
+    }
+
+    n %= nodes;
+
+    for (size_t node = 0; read_node_cpus(node, &node_cpus); node++) {
+        CPU_AND(&node_cpus, &node_cpus, allowed);
+
+        if (CPU_COUNT(&node_cpus) > 0 && n-- == 0) {
+            *set = node_cpus;
+            return;
+        }
+    }
+}
+
+bool affinity_worker_set(size_t index, const actor_system_config_t *config, cpu_set_t *set) {
+    cpu_set_t allowed;
+    int cpu;
+
+    if (config->affinity == AFFINITY_NONE) {
+        return false;
+    }
+
+    CPU_ZERO(set);
+
+    if (sched_getaffinity(0, sizeof allowed, &allowed) != 0) {
+        return false;
+    }
+
+    /* Przypięcie do procesora spoza dozwolonych zakończyłoby tworzenie wątku
+     * błędem EINVAL, więc taki wątek zostaje nieprzypięty. */
+    if (config->affinity == AFFINITY_CPU && config->cpus != NULL && config->ncpus > 0) {
+        cpu = config->cpus[index % config->ncpus];
+
+        if (cpu < 0 || cpu >= CPU_SETSIZE || !CPU_ISSET(cpu, &allowed)) {
+            return false;
+        }
+
+        CPU_SET(cpu, set);
+
+        return true;
+    }
+
+    if (config->affinity == AFFINITY_CPU) {
+        if ((cpu = nth_cpu(&allowed, index)) < 0) {
+            return false;
+        }
+
+        CPU_SET(cpu, set);
+    }
+    else {
+        nth_node_cpus(&allowed, index, set);
+    }
+
+    return true;
+}
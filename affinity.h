@@ -0,0 +1,19 @@
+#ifndef CACTI_AFFINITY_H
+#define CACTI_AFFINITY_H
+
+#include <sched.h>
+#include <stdbool.h>
+#include "cacti.h"
+
+/* Wyznaczanie procesorów, na których mają działać wątki puli, zgodnie z polem
+ * 'affinity' ustawień systemu. Węzły NUMA są odczytywane z sysfs, więc nie
+ * jest potrzebna biblioteka libnuma. Gdy informacja o węzłach jest niedostępna,
+ * wszystkie procesory traktujemy jak jeden węzeł. Plik włączający ten nagłówek
+ * musi zdefiniować _GNU_SOURCE przed pierwszym nagłówkiem systemowym. */
+
+/* Zapisuje pod 'set' zbiór procesorów dla wątku o numerze 'index', zawsze
+ * zawarty w procesorach dozwolonych dla procesu. Zwraca false, jeżeli wątek
+ * nie powinien być przypinany, także gdy jego procesor z 'cpus' nie jest dozwolony. */
+bool affinity_worker_set(size_t index, const actor_system_config_t *config, cpu_set_t *set);
+
+#endif //CACTI_AFFINITY_H
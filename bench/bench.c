@@ -0,0 +1,637 @@
+/* Mikrobenchmarki systemu aktorów. Każdy benchmark wypisuje jedną linię JSON
+ * z liczbą komunikatów na sekundę, opóźnieniami p50/p99 i szczytowym RSS
+ * (cast dodatkowo z przyrostem RSS samej obsady).
+ *
+ * Użycie: cacti_bench [nazwa[=liczba]]...
+ * Dostępne nazwy: pingpong, fanin, spawn, ring, cast, restart, restart_cold.
+ * Bez argumentów uruchamia wszystkie z domyślną liczbą komunikatów. */
+#include <stdbool.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <stdint.h>
+#include <time.h>
+#include <unistd.h>
+#include <sys/resource.h>
+#include "cacti.h"
+
+#define FANIN_PRODUCERS (4)
+#define RING_SIZE (100)
+
+typedef struct bench_result {
+    const char *name;
+    size_t messages;
+    uint64_t start_ns;
+    uint64_t end_ns;
+    uint64_t *latencies; // Opóźnienia kolejnych komunikatów (lub rund) w ns.
+    size_t samples;
+    long max_rss_kb; // Szczytowy RSS zmierzony na końcu pomiaru, 0 = przy bench_end.
+    long rss_delta_kb; // Przyrost bieżącego RSS w trakcie pomiaru, -1 = nie mierzony.
+} bench_result_t;
+
+static bench_result_t result;
+
+// Bieżący RSS z /proc/self/statm, 0 gdy nie da się go odczytać.
+static long current_rss_kb() {
+    FILE *statm = fopen("/proc/self/statm", "r");
+    long pages = 0;
+
+    if (statm != NULL) {
+        if (fscanf(statm, "%*s %ld", &pages) != 1) {
+            pages = 0;
+        }
+
+        fclose(statm);
+    }
+
+    return pages * (sysconf(_SC_PAGESIZE) / 1024);
+}
+
+static uint64_t now_ns() {
+    struct timespec ts;
+
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+
+    return (uint64_t) ts.tv_sec * 1000000000ull + (uint64_t) ts.tv_nsec;
+}
+
+static void record_latency(uint64_t latency) {
+    if (result.samples < result.messages) {
+        result.latencies[result.samples++] = latency;
+    }
+}
+
+static int compare_u64(const void *a, const void *b) {
+    uint64_t x = *(const uint64_t *) a;
+    uint64_t y = *(const uint64_t *) b;
+
+    return (x > y) - (x < y);
+}
+
+static uint64_t percentile(double p) {
+    if (result.samples == 0) {
+        return 0;
+    }
+
+    size_t index = (size_t) (p * (double) (result.samples - 1));
+
+    return result.latencies[index];
+}
+
+static void bench_begin(const char *name, size_t messages) {
+    result.name = name;
+    result.messages = messages;
+    result.samples = 0;
+    result.max_rss_kb = 0;
+    result.rss_delta_kb = -1;
+    result.latencies = malloc(sizeof (uint64_t) * messages);
+
+    if (result.latencies == NULL) {
+        fprintf(stderr, "Out of memory\n");
+        exit(1);
+    }
+
+    result.start_ns = now_ns();
+}
+
+static void bench_end() {
+    struct rusage usage;
+    double seconds = (double) (result.end_ns - result.start_ns) / 1e9;
+
+    getrusage(RUSAGE_SELF, &usage);
+    qsort(result.latencies, result.samples, sizeof (uint64_t), compare_u64);
+
+    printf("{\"bench\": \"%s\", \"messages\": %zu, \"seconds\": %.6f, \"msgs_per_sec\": %.0f, "
+           "\"p50_ns\": %llu, \"p99_ns\": %llu, \"max_rss_kb\": %ld",
+           result.name, result.samples, seconds, seconds > 0 ? (double) result.samples / seconds : 0.0,
+           (unsigned long long) percentile(0.50), (unsigned long long) percentile(0.99),
+           result.max_rss_kb != 0 ? result.max_rss_kb : usage.ru_maxrss);
+
+    if (result.rss_delta_kb >= 0) {
+        printf(", \"rss_delta_kb\": %ld", result.rss_delta_kb);
+    }
+
+    printf("}\n");
+    fflush(stdout);
+
+    free(result.latencies);
+    result.latencies = NULL;
+}
+
+static void run_system(role_t *role) {
+    actor_system_config_t config = {.queue_limit = QUEUE_UNLIMITED};
+    actor_id_t first;
+
+    if (actor_system_create_ex(&first, role, &config) != 0) {
+        fprintf(stderr, "Actor system creation failed\n");
+        exit(1);
+    }
+
+    actor_system_join(first);
+}
+
+static void godie(actor_id_t actor) {
+    send_message(actor, (message_t){.message_type = MSG_GODIE});
+}
+
+// ---------------- PING-PONG -----------------
+/* Dwóch aktorów odbija jedną wiadomość, mierzymy czas pełnej rundy. */
+#define MSG_PP_READY (1)
+#define MSG_PP_PONG (2)
+#define MSG_PP_PING (1)
+
+typedef struct pingpong_state {
+    actor_id_t ponger;
+    size_t rounds;
+    uint64_t sent_ns;
+} pingpong_state_t;
+
+static pingpong_state_t pingpong;
+
+static void pinger_hello(void **stateptr, size_t nbytes, void *data);
+static void pinger_ready(void **stateptr, size_t nbytes, void *data);
+static void pinger_pong(void **stateptr, size_t nbytes, void *data);
+static void ponger_hello(void **stateptr, size_t nbytes, void *data);
+static void ponger_ping(void **stateptr, size_t nbytes, void *data);
+
+static act_t pinger_acts[] = {&pinger_hello, &pinger_ready, &pinger_pong};
+static act_t ponger_acts[] = {&ponger_hello, &ponger_ping};
+static role_t pinger_role = {.nprompts = 3, .prompts = pinger_acts};
+static role_t ponger_role = {.nprompts = 2, .prompts = ponger_acts};
+
+static void pinger_hello(void **stateptr, size_t nbytes, void *data) {
+    (void) stateptr; (void) nbytes; (void) data;
+
+    send_message(actor_id_self(), (message_t){.message_type = MSG_SPAWN, .data = &ponger_role});
+}
+
+static void pinger_ready(void **stateptr, size_t nbytes, void *data) {
+    (void) stateptr; (void) nbytes;
+
+    pingpong.ponger = (actor_id_t) data;
+    pingpong.rounds = 0;
+    // Pomiar zaczyna się od pierwszej rundy, bez tworzenia systemu i odbijającego.
+    pingpong.sent_ns = now_ns();
+    result.start_ns = pingpong.sent_ns;
+    send_message(pingpong.ponger, (message_t){.message_type = MSG_PP_PING});
+}
+
+static void pinger_pong(void **stateptr, size_t nbytes, void *data) {
+    (void) stateptr; (void) nbytes; (void) data;
+
+    uint64_t now = now_ns();
+
+    record_latency(now - pingpong.sent_ns);
+
+    if (++pingpong.rounds < result.messages) {
+        pingpong.sent_ns = now;
+        send_message(pingpong.ponger, (message_t){.message_type = MSG_PP_PING});
+    }
+    else {
+        result.end_ns = now;
+        godie(pingpong.ponger);
+        godie(actor_id_self());
+    }
+}
+
+static void ponger_hello(void **stateptr, size_t nbytes, void *data) {
+    (void) nbytes;
+
+    *stateptr = data;
+    send_message((actor_id_t) data, (message_t){.message_type = MSG_PP_READY, .data = (void *) actor_id_self()});
+}
+
+static void ponger_ping(void **stateptr, size_t nbytes, void *data) {
+    (void) nbytes; (void) data;
+
+    send_message((actor_id_t) *stateptr, (message_t){.message_type = MSG_PP_PONG});
+}
+
+static void bench_pingpong(size_t rounds) {
+    bench_begin("pingpong", rounds);
+    run_system(&pinger_role);
+    bench_end();
+}
+
+// ---------------- FAN-IN -----------------
+/* FANIN_PRODUCERS producentów wysyła komunikaty do jednego konsumenta,
+ * opóźnienie to czas od wysłania do obsłużenia komunikatu. */
+#define MSG_FI_DATA (1)
+
+static size_t fanin_received;
+static size_t fanin_per_producer;
+
+static void consumer_hello(void **stateptr, size_t nbytes, void *data);
+static void consumer_data(void **stateptr, size_t nbytes, void *data);
+static void producer_hello(void **stateptr, size_t nbytes, void *data);
+
+static act_t consumer_acts[] = {&consumer_hello, &consumer_data};
+static act_t producer_acts[] = {&producer_hello};
+static role_t consumer_role = {.nprompts = 2, .prompts = consumer_acts};
+static role_t producer_role = {.nprompts = 1, .prompts = producer_acts};
+
+static void consumer_hello(void **stateptr, size_t nbytes, void *data) {
+    (void) stateptr; (void) nbytes; (void) data;
+
+    for (int i = 0; i < FANIN_PRODUCERS; i++) {
+        send_message(actor_id_self(), (message_t){.message_type = MSG_SPAWN, .data = &producer_role});
+    }
+}
+
+static void consumer_data(void **stateptr, size_t nbytes, void *data) {
+    (void) stateptr; (void) nbytes;
+
+    uint64_t now = now_ns();
+
+    record_latency(now - message_value(uint64_t, data));
+
+    if (++fanin_received == fanin_per_producer * FANIN_PRODUCERS) {
+        result.end_ns = now;
+        godie(actor_id_self());
+    }
+}
+
+static void producer_hello(void **stateptr, size_t nbytes, void *data) {
+    (void) stateptr; (void) nbytes;
+
+    actor_id_t consumer = (actor_id_t) data;
+
+    for (size_t i = 0; i < fanin_per_producer; i++) {
+        uint64_t sent = now_ns();
+
+        send_value(consumer, MSG_FI_DATA, sent);
+    }
+
+    godie(actor_id_self());
+}
+
+static void bench_fanin(size_t messages) {
+    fanin_per_producer = messages / FANIN_PRODUCERS;
+    fanin_received = 0;
+
+    bench_begin("fanin", fanin_per_producer * FANIN_PRODUCERS);
+    run_system(&consumer_role);
+    bench_end();
+}
+
+// ---------------- SPAWN CHAIN -----------------
+/* Każdy aktor tworzy następnego i ginie, tak jak w silnia.c. Opóźnienie
+ * to czas od wysłania MSG_SPAWN do obsłużenia MSG_HELLO przez nowego aktora. */
+static size_t spawn_depth;
+static uint64_t spawn_sent_ns;
+
+static void chain_hello(void **stateptr, size_t nbytes, void *data);
+
+static act_t chain_acts[] = {&chain_hello};
+static role_t chain_role = {.nprompts = 1, .prompts = chain_acts};
+
+static void chain_hello(void **stateptr, size_t nbytes, void *data) {
+    (void) stateptr; (void) nbytes;
+
+    uint64_t now = now_ns();
+
+    // Pierwszy aktor dostaje MSG_HELLO od systemu, a nie od ojca.
+    if (spawn_depth > 0) {
+        record_latency(now - spawn_sent_ns);
+        godie((actor_id_t) data);
+    }
+
+    if (++spawn_depth < result.messages) {
+        spawn_sent_ns = now_ns();
+        send_message(actor_id_self(), (message_t){.message_type = MSG_SPAWN, .data = &chain_role});
+    }
+    else {
+        result.end_ns = now;
+        godie(actor_id_self());
+    }
+}
+
+static void bench_spawn(size_t depth) {
+    if (depth >= CAST_LIMIT) {
+        depth = CAST_LIMIT - 1;
+    }
+
+    spawn_depth = 0;
+
+    bench_begin("spawn", depth);
+    run_system(&chain_role);
+    bench_end();
+}
+
+// ---------------- RING -----------------
+/* RING_SIZE aktorów tworzy pierścień, po którym krąży jeden żeton.
+ * Opóźnienie to czas jednego przeskoku żetonu. */
+#define MSG_RING_READY (1)
+#define MSG_RING_DONE (2)
+#define MSG_RING_NEXT (1)
+#define MSG_RING_TOKEN (2)
+
+typedef struct token {
+    size_t remaining;
+    uint64_t sent_ns;
+} token_t;
+
+static actor_id_t ring_root;
+static actor_id_t ring[RING_SIZE];
+static size_t ring_joined;
+
+static void ring_root_hello(void **stateptr, size_t nbytes, void *data);
+static void ring_root_ready(void **stateptr, size_t nbytes, void *data);
+static void ring_root_done(void **stateptr, size_t nbytes, void *data);
+static void ring_hello(void **stateptr, size_t nbytes, void *data);
+static void ring_next(void **stateptr, size_t nbytes, void *data);
+static void ring_token(void **stateptr, size_t nbytes, void *data);
+
+static act_t ring_root_acts[] = {&ring_root_hello, &ring_root_ready, &ring_root_done};
+static act_t ring_acts[] = {&ring_hello, &ring_next, &ring_token};
+static role_t ring_root_role = {.nprompts = 3, .prompts = ring_root_acts};
+static role_t ring_role = {.nprompts = 3, .prompts = ring_acts};
+
+static void ring_root_hello(void **stateptr, size_t nbytes, void *data) {
+    (void) stateptr; (void) nbytes; (void) data;
+
+    ring_root = actor_id_self();
+    ring_joined = 0;
+
+    for (int i = 0; i < RING_SIZE; i++) {
+        send_message(actor_id_self(), (message_t){.message_type = MSG_SPAWN, .data = &ring_role});
+    }
+}
+
+static void ring_root_ready(void **stateptr, size_t nbytes, void *data) {
+    (void) stateptr; (void) nbytes;
+
+    ring[ring_joined++] = (actor_id_t) data;
+
+    if (ring_joined < RING_SIZE) {
+        return;
+    }
+
+    for (int i = 0; i < RING_SIZE; i++) {
+        send_value(ring[i], MSG_RING_NEXT, ring[(i + 1) % RING_SIZE]);
+    }
+
+    // Pomiar zaczyna się od wypuszczenia żetonu, bez budowania pierścienia.
+    token_t token = {.remaining = result.messages, .sent_ns = now_ns()};
+
+    result.start_ns = token.sent_ns;
+    send_value(ring[0], MSG_RING_TOKEN, token);
+}
+
+static void ring_root_done(void **stateptr, size_t nbytes, void *data) {
+    (void) stateptr; (void) nbytes; (void) data;
+
+    send_message_multicast(ring, RING_SIZE, (message_t){.message_type = MSG_GODIE});
+    godie(actor_id_self());
+}
+
+static void ring_hello(void **stateptr, size_t nbytes, void *data) {
+    (void) nbytes;
+
+    actor_id_t root = (actor_id_t) data;
+
+    *stateptr = (void *) root;
+    send_message(root, (message_t){.message_type = MSG_RING_READY, .data = (void *) actor_id_self()});
+}
+
+static void ring_next(void **stateptr, size_t nbytes, void *data) {
+    (void) nbytes;
+
+    // Od teraz stan aktora to jego następnik w pierścieniu.
+    *stateptr = (void *) message_value(actor_id_t, data);
+}
+
+static void ring_token(void **stateptr, size_t nbytes, void *data) {
+    (void) nbytes;
+
+    token_t token = message_value(token_t, data);
+    uint64_t now = now_ns();
+
+    record_latency(now - token.sent_ns);
+
+    if (--token.remaining == 0) {
+        result.end_ns = now;
+        send_message(ring_root, (message_t){.message_type = MSG_RING_DONE});
+    }
+    else {
+        token.sent_ns = now;
+        send_value((actor_id_t) *stateptr, MSG_RING_TOKEN, token);
+    }
+}
+
+static void bench_ring(size_t hops) {
+    bench_begin("ring", hops);
+    run_system(&ring_root_role);
+    bench_end();
+}
+
+// ---------------- CAST -----------------
+/* Korzeń tworzy podaną liczbę aktorów, którzy żyją aż do końca pomiaru,
+ * co najwyżej CAST_WINDOW naraz w trakcie tworzenia. Opóźnienie to czas od
+ * startu do obsłużenia MSG_HELLO przez nowego aktora, a przyrost RSS między
+ * startem a zebraniem całej obsady pokazuje koszt pamięci samych aktorów. */
+#define CAST_WINDOW (1024)
+#define MSG_CAST_READY (1)
+
+static size_t cast_spawned;
+static size_t cast_ready;
+static actor_id_t *cast_members;
+static long cast_rss_before_kb;
+
+static void cast_root_hello(void **stateptr, size_t nbytes, void *data);
+static void cast_root_ready(void **stateptr, size_t nbytes, void *data);
+static void cast_hello(void **stateptr, size_t nbytes, void *data);
+
+static act_t cast_root_acts[] = {&cast_root_hello, &cast_root_ready};
+static act_t cast_acts[] = {&cast_hello};
+static role_t cast_root_role = {.nprompts = 2, .prompts = cast_root_acts};
+static role_t cast_role = {.nprompts = 1, .prompts = cast_acts};
+
+static void cast_spawn_next() {
+    if (cast_spawned < result.messages) {
+        cast_spawned++;
+        send_message(actor_id_self(), (message_t){.message_type = MSG_SPAWN, .data = &cast_role});
+    }
+}
+
+static void cast_root_hello(void **stateptr, size_t nbytes, void *data) {
+    (void) stateptr; (void) nbytes; (void) data;
+
+    for (size_t i = 0; i < CAST_WINDOW; i++) {
+        cast_spawn_next();
+    }
+}
+
+static void cast_root_ready(void **stateptr, size_t nbytes, void *data) {
+    (void) stateptr; (void) nbytes;
+
+    cast_members[cast_ready] = (actor_id_t) data;
+
+    if (++cast_ready < result.messages) {
+        cast_spawn_next();
+        return;
+    }
+
+    struct rusage usage;
+
+    result.end_ns = now_ns();
+
+    // Pamięć mierzymy przed rozesłaniem MSG_GODIE, które samo zajmuje koperty.
+    getrusage(RUSAGE_SELF, &usage);
+    result.max_rss_kb = usage.ru_maxrss;
+    result.rss_delta_kb = current_rss_kb() - cast_rss_before_kb;
+
+    for (size_t i = 0; i < cast_ready; i++) {
+        godie(cast_members[i]);
+    }
+
+    godie(actor_id_self());
+}
+
+static void cast_hello(void **stateptr, size_t nbytes, void *data) {
+    (void) stateptr; (void) nbytes;
+
+    record_latency(now_ns() - result.start_ns);
+    send_message((actor_id_t) data, (message_t){.message_type = MSG_CAST_READY, .data = (void *) actor_id_self()});
+}
+
+static void bench_cast(size_t actors) {
+    if (actors >= CAST_LIMIT) {
+        actors = CAST_LIMIT - 1;
+    }
+
+    cast_spawned = 0;
+    cast_ready = 0;
+    cast_members = malloc(sizeof (actor_id_t) * actors);
+
+    if (cast_members == NULL) {
+        fprintf(stderr, "Out of memory\n");
+        exit(1);
+    }
+
+    bench_begin("cast", actors);
+
+    // Tablice wyników zapełniamy z góry, żeby przyrost RSS obejmował tylko system.
+    memset(result.latencies, 0, sizeof (uint64_t) * actors);
+    memset(cast_members, 0, sizeof (actor_id_t) * actors);
+    cast_rss_before_kb = current_rss_kb();
+    result.start_ns = now_ns();
+
+    run_system(&cast_root_role);
+    bench_end();
+
+    free(cast_members);
+    cast_members = NULL;
+}
+
+// ---------------- RESTART -----------------
+/* Kolejne puste systemy: jedyny aktor od razu umiera. Opóźnienie to czas
+ * utworzenia i dołączenia jednego systemu. Wariant "restart" korzysta z wątków
+ * zachowanych po poprzednim systemie, a "restart_cold" kończy je po każdym. */
+static void empty_hello(void **stateptr, size_t nbytes, void *data);
+
+static act_t empty_acts[] = {&empty_hello};
+static role_t empty_role = {.nprompts = 1, .prompts = empty_acts};
+
+static void empty_hello(void **stateptr, size_t nbytes, void *data) {
+    (void) stateptr; (void) nbytes; (void) data;
+
+    godie(actor_id_self());
+}
+
+static void run_restarts(const char *name, size_t systems, bool warm) {
+    actor_id_t first;
+
+    if (warm) {
+        cacti_threads_warm(POOL_SIZE);
+    }
+
+    bench_begin(name, systems);
+
+    for (size_t i = 0; i < systems; i++) {
+        uint64_t start = now_ns();
+
+        if (actor_system_create(&first, &empty_role) != 0) {
+            fprintf(stderr, "Actor system creation failed\n");
+            exit(1);
+        }
+
+        actor_system_join(first);
+
+        if (!warm) {
+            cacti_threads_release();
+        }
+
+        record_latency(now_ns() - start);
+    }
+
+    result.end_ns = now_ns();
+    bench_end();
+}
+
+static void bench_restart(size_t systems) {
+    run_restarts("restart", systems, true);
+}
+
+static void bench_restart_cold(size_t systems) {
+    run_restarts("restart_cold", systems, false);
+}
+
+// ---------------- MAIN -----------------
+typedef struct bench {
+    const char *name;
+    void (*run)(size_t messages);
+    size_t default_messages;
+} bench_t;
+
+static const bench_t benches[] = {
+    {"pingpong", &bench_pingpong, 100000},
+    {"fanin", &bench_fanin, 200000},
+    {"spawn", &bench_spawn, 100000},
+    {"ring", &bench_ring, 100000},
+    {"cast", &bench_cast, 1000000},
+    {"restart", &bench_restart, 10000},
+    {"restart_cold", &bench_restart_cold, 10000},
+};
+
+#define BENCHES_NUM (sizeof benches / sizeof benches[0])
+
+static int run_bench(const char *arg) {
+    const char *eq = strchr(arg, '=');
+    size_t name_len = eq != NULL ? (size_t) (eq - arg) : strlen(arg);
+
+    for (size_t i = 0; i < BENCHES_NUM; i++) {
+        if (strlen(benches[i].name) == name_len && strncmp(benches[i].name, arg, name_len) == 0) {
+            size_t messages = eq != NULL ? strtoull(eq + 1, NULL, 10) : benches[i].default_messages;
+
+            if (messages == 0) {
+                fprintf(stderr, "Invalid message count: %s\n", arg);
+                return 1;
+            }
+
+            benches[i].run(messages);
+            return 0;
+        }
+    }
+
+    fprintf(stderr, "Unknown benchmark: %s\n", arg);
+    return 1;
+}
+
+int main(int argc, char **argv) {
+    if (argc == 1) {
+        for (size_t i = 0; i < BENCHES_NUM; i++) {
+            benches[i].run(benches[i].default_messages);
+        }
+
+        return 0;
+    }
+
+    for (int i = 1; i < argc; i++) {
+        if (run_bench(argv[i]) != 0) {
+            return 1;
+        }
+    }
+
+    return 0;
+}
@@ -0,0 +1,187 @@
+#include <errno.h>
+#include <stdbool.h>
+#include <stdlib.h>
+#include <time.h>
+#include <pthread.h>
+#include "blocking_pool.h"
+#include "generic_queue.h"
+#include "cacti.h"
+#include "err.h"
+
+struct blocking_pool {
+    pthread_mutex_t mutex;
+    pthread_cond_t work_cond;  // Na niej czekają bezczynne wątki.
+    pthread_cond_t exit_cond;  // Sygnalizowana, gdy kończy się ostatni wątek.
+    generic_queue *jobs;
+    size_t threads_num;
+    size_t idle_num;
+    size_t max_threads;
+    bool stopping;
+    void (*run)(void *job);
+    void (*thread_done)();
+};
+
+static void pool_lock(blocking_pool_t *pool) {
+    int res;
+
+    if ((res = pthread_mutex_lock(&pool->mutex)) != 0) {
+        syserr(res, "Blocking pool mutex failed!\n");
+    }
+}
+
+static void pool_unlock(blocking_pool_t *pool) {
+    int res;
+
+    if ((res = pthread_mutex_unlock(&pool->mutex)) != 0) {
+        syserr(res, "Blocking pool mutex failed!\n");
+    }
+}
+
+/* Czeka na zadanie co najwyżej BLOCKING_IDLE_MS milisekund. Zwraca false,
+ * jeżeli wątek powinien się zakończyć. Wymaga mutexa puli. */
+static bool wait_for_job(blocking_pool_t *pool) {
+    struct timespec deadline;
+    int res;
+
+    clock_gettime(CLOCK_MONOTONIC, &deadline);
+    deadline.tv_sec += BLOCKING_IDLE_MS / 1000;
+    deadline.tv_nsec += (BLOCKING_IDLE_MS % 1000) * 1000000L;
+
+    if (deadline.tv_nsec >= 1000000000L) {
+        deadline.tv_sec++;
+        deadline.tv_nsec -= 1000000000L;
+    }
+
+    pool->idle_num++;
+
+    while (is_empty(pool->jobs) && !pool->stopping) {
+        if ((res = pthread_cond_timedwait(&pool->work_cond, &pool->mutex, &deadline)) == ETIMEDOUT) {
+            break;
+        }
+        else if (res != 0) {
+            syserr(res, "Blocking pool wait failed!\n");
+        }
+    }
+
+    pool->idle_num--;
+
+    return !is_empty(pool->jobs);
+}
+
+static void *blocking_worker(void *arg) {
+    blocking_pool_t *pool = arg;
+    void *job;
+    int res;
+
+    pool_lock(pool);
+
+    while (wait_for_job(pool)) {
+        queue_try_pop(pool->jobs, &job);
+        pool_unlock(pool);
+
+        pool->run(job);
+
+        pool_lock(pool);
+    }
+
+    pool_unlock(pool);
+
+    if (pool->thread_done != NULL) {
+        pool->thread_done();
+    }
+
+    pool_lock(pool);
+
+    if (--pool->threads_num == 0 && (res = pthread_cond_signal(&pool->exit_cond)) != 0) {
+        syserr(res, "Blocking pool signal failed!\n");
+    }
+
+    pool_unlock(pool);
+
+    return NULL;
+}
+
+blocking_pool_t *blocking_pool_create(size_t max_threads, void (*run)(void *job), void (*thread_done)()) {
+    blocking_pool_t *pool = malloc(sizeof (blocking_pool_t));
+    pthread_condattr_t attr;
+    int res;
+
+    if (pool == NULL || (pool->jobs = create_queue(NULL)) == NULL) {
+        fatal("Blocking pool initialization failure!\n");
+    }
+
+    pool->threads_num = 0;
+    pool->idle_num = 0;
+    pool->max_threads = max_threads;
+    pool->stopping = false;
+    pool->run = run;
+    pool->thread_done = thread_done;
+
+    if ((res = pthread_mutex_init(&pool->mutex, NULL)) != 0) {
+        syserr(res, "Blocking pool mutex initialization failure!\n");
+    }
+
+    if ((res = pthread_condattr_init(&attr)) != 0 ||
+        (res = pthread_condattr_setclock(&attr, CLOCK_MONOTONIC)) != 0 ||
+        (res = pthread_cond_init(&pool->work_cond, &attr)) != 0 ||
+        (res = pthread_cond_init(&pool->exit_cond, NULL)) != 0) {
+        syserr(res, "Blocking pool conditional initialization failure!\n");
+    }
+
+    pthread_condattr_destroy(&attr);
+
+    return pool;
+}
+
+void blocking_pool_submit(blocking_pool_t *pool, void *job) {
+    pthread_attr_t attr;
+    pthread_t thread;
+    int res;
+
+    pool_lock(pool);
+
+    queue_add(pool->jobs, job);
+
+    // Nowy wątek tworzymy tylko wtedy, gdy bezczynnych jest mniej niż czekających zadań.
+    if (pool->idle_num < queue_size(pool->jobs) && pool->threads_num < pool->max_threads) {
+        if ((res = pthread_attr_init(&attr)) != 0 ||
+            (res = pthread_attr_setdetachstate(&attr, PTHREAD_CREATE_DETACHED)) != 0 ||
+            (res = pthread_create(&thread, &attr, blocking_worker, pool)) != 0) {
+            syserr(res, "Blocking thread creation failed!\n");
+        }
+
+        pthread_attr_destroy(&attr);
+        pool->threads_num++;
+    }
+    else if ((res = pthread_cond_signal(&pool->work_cond)) != 0) {
+        syserr(res, "Blocking pool signal failed!\n");
+    }
+
+    pool_unlock(pool);
+}
+
+void blocking_pool_destroy(blocking_pool_t *pool) {
+    int res;
+
+    pool_lock(pool);
+
+    pool->stopping = true;
+
+    if ((res = pthread_cond_broadcast(&pool->work_cond)) != 0) {
+        syserr(res, "Blocking pool broadcast failed!\n");
+    }
+
+    while (pool->threads_num > 0) {
+        if ((res = pthread_cond_wait(&pool->exit_cond, &pool->mutex)) != 0) {
+            syserr(res, "Blocking pool wait failed!\n");
+        }
+    }
+
+    pool_unlock(pool);
+
+    free_queue(pool->jobs);
+    pthread_cond_destroy(&pool->work_cond);
+    pthread_cond_destroy(&pool->exit_cond);
+    pthread_mutex_destroy(&pool->mutex);
+    free(pool);
+}
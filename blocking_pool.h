@@ -0,0 +1,25 @@
+#ifndef CACTI_BLOCKING_POOL_H
+#define CACTI_BLOCKING_POOL_H
+
+#include <stddef.h>
+
+/* Elastyczna pula wątków do zadań, które mogą długo blokować (sen, wejście/wyjście),
+ * żeby nie zajmowały wątków puli głównej. Wątek jest tworzony, gdy przychodzi
+ * zadanie, a wszystkie istniejące wątki są zajęte (do limitu 'max_threads'),
+ * i kończy się po BLOCKING_IDLE_MS milisekundach bez pracy. */
+
+struct blocking_pool;
+
+typedef struct blocking_pool blocking_pool_t;
+
+/* Tworzy pustą pulę. Każde zadanie jest wykonywane przez wywołanie 'run',
+ * a każdy kończący się wątek wywołuje przed wyjściem 'thread_done' (o ile nie NULL). */
+blocking_pool_t *blocking_pool_create(size_t max_threads, void (*run)(void *job), void (*thread_done)());
+
+// Zleca wykonanie zadania 'job'. Zadania są rozpoczynane w kolejności zlecenia.
+void blocking_pool_submit(blocking_pool_t *pool, void *job);
+
+// Czeka na wykonanie zleconych zadań i zakończenie wszystkich wątków, po czym zwalnia pulę.
+void blocking_pool_destroy(blocking_pool_t *pool);
+
+#endif //CACTI_BLOCKING_POOL_H
@@ -1,15 +1,35 @@
+#define _GNU_SOURCE
 #include <pthread.h>
 #include <stddef.h>
 #include <stdbool.h>
+#include <stdint.h>
+#include <stdio.h>
 #include <stdlib.h>
+#include <string.h>
 #include <signal.h>
+#include <semaphore.h>
+#include <errno.h>
+#include <stdatomic.h>
+#include <unistd.h>
+#include <time.h>
 #include "generic_queue.h"
+#include "mpsc_queue.h"
+#include "envelope_pool.h"
+#include "affinity.h"
+#include "latency.h"
+#include "trace.h"
+#include "blocking_pool.h"
+#include "timer.h"
+#include "thread_cache.h"
 #include "err.h"
 
 #include "cacti.h"
 
 #define INIT_SYSTEM_ERROR (-3)
 #define NO_ACTIVE_SYSTEM (-4)
+#define PAYLOAD_TOO_BIG (-5)
+#define STATS_DISABLED (-6)
+#define CACHE_LINE (64)
 #define INIT_SIGACTION (0)
 #define RESTORE_SIGACTION (1)
 
@@ -17,27 +37,73 @@ struct thread_pool;
 
 typedef struct thread_pool tpool_t;
 
-size_t how_many_messages(actor_id_t actor_id);
+struct vector;
 
-void execute_commands(actor_id_t actor_id, size_t how_many);
+typedef struct vector vector;
 
-void try_to_add_actor(actor_id_t actor_id, tpool_t *tp);
+size_t actor_budget(cacti_system_t *sys, actor_id_t actor_id);
 
-void act_lock_mutex(actor_id_t actor_id);
+size_t execute_commands(cacti_system_t *sys, actor_id_t actor_id, size_t budget, bool *preempted);
 
-void act_unlock_mutex(actor_id_t actor_id);
+struct actor_state;
 
-void act_lock_mutex_unsafe(actor_id_t actor_id);
+void try_to_add_actor(struct actor_state *actor_state, tpool_t *tp);
 
-void act_unlock_mutex_unsafe(actor_id_t actor_id);
+void run_offloaded(void *job);
 
-void destroy_actor_system();
+void destroy_actor_system(cacti_system_t *sys);
+
+/* Stan jednego systemu aktorów. Każdy system ma własną pulę wątków, tablicę
+ * aktorów, zegary i ustawienia, więc w jednym procesie może działać kilka
+ * niezależnych systemów, np. na osobnych rdzeniach. */
+struct cacti_system {
+    pthread_mutex_t mutex;
+    pthread_cond_t join;
+    atomic_bool alive;
+    atomic_size_t budget;
+    size_t queue_limit; // Limit skrzynki aktora, 0 = brak limitu.
+    overflow_t overflow;
+    unsigned long long send_timeout_us;
+    atomic_ullong dropped;
+    // Wątki spoza systemu, które właśnie wysyłają wiadomość, zob. find_receiver.
+    atomic_size_t outside_senders;
+    bool stats;
+    latency_table_t *latency; // Histogramy opóźnień ról, NULL gdy wyłączone.
+    trace_t *trace;           // Ślad szeregowania, NULL gdy wyłączony.
+    unsigned long long slow_handler_ns;
+    slow_handler_t slow_handler;
+    tpool_t *tp;
+    vector *actors;
+    timer_wheel_t *timers;
+    // Liczniki wątków zniszczonej puli, dostępne po zakończeniu systemu.
+    worker_stats_t *retired_stats;
+    size_t retired_stats_num;
+    cacti_system_t *next; // Lista działających systemów, chroniona 'systems_mutex'.
+};
 
 static __thread actor_id_t self_actor_id;
-pthread_cond_t system_join = PTHREAD_COND_INITIALIZER;
-pthread_mutex_t system_mutex = PTHREAD_MUTEX_INITIALIZER;
-bool signaled = false;
-bool is_system_alive;
+/* Numer kolejki wątku roboczego, -1 dla wątków spoza puli */
+static __thread long worker_index = -1;
+// System, którego aktora przetwarza wątek, NULL dla wątków spoza systemów.
+static __thread cacti_system_t *current_system = NULL;
+// SIGINT kończy wszystkie systemy w procesie.
+atomic_bool signaled = false;
+/* Działające systemy. Obsługę SIGINT i zapis śladu włącza pierwszy z nich,
+ * a wyłącza ostatni zakończony. */
+pthread_mutex_t systems_mutex = PTHREAD_MUTEX_INITIALIZER;
+cacti_system_t *systems = NULL;
+size_t systems_running = 0; // Systemy utworzone, a jeszcze nie dołączone.
+// System funkcji bez uchwytu, wywołanych spoza wątków systemu.
+_Atomic(cacti_system_t *) default_system = NULL;
+
+// Zwraca czas zegara monotonicznego w nanosekundach.
+unsigned long long now_ns() {
+    struct timespec ts;
+
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+
+    return (unsigned long long) ts.tv_sec * 1000000000ull + (unsigned long long) ts.tv_nsec;
+}
 
 void *safe_malloc(size_t size) {
     void *space = malloc(size);
@@ -49,65 +115,186 @@ void *safe_malloc(size_t size) {
     return space;
 }
 
+/* Bity słowa stanu aktora. Bity od ACTOR_REF w górę liczą nadawców, którzy
+ * właśnie wstawiają wiadomość do skrzynki aktora. Miejsce martwego aktora
+ * wraca do puli dopiero, gdy stan wynosi dokładnie ACTOR_DEAD, czyli nikt
+ * go nie przetwarza, nikt do niego nie wysyła, a skrzynka jest pusta. */
+#define ACTOR_DEAD      (1u << 0)
+#define ACTOR_SCHEDULED (1u << 1) // Aktor jest na kolejce, lub jest właśnie przetwarzany.
+#define ACTOR_FREE      (1u << 2) // Miejsce aktora czeka na ponowne użycie.
+#define ACTOR_REF       (1u << 3)
+
+/* Numer aktora to pokolenie * CAST_LIMIT + numer miejsca w tablicy aktorów.
+ * Pokolenie rośnie przy każdym ponownym użyciu miejsca, więc numer zmarłego
+ * aktora nigdy nie wskaże jego następcy. Aktorzy pierwszego pokolenia mają
+ * numery równe numerom miejsc. */
+static inline size_t actor_index(actor_id_t id) {
+    return (size_t) id % CAST_LIMIT;
+}
+
+/* Stan aktora mieści się w jednej linii pamięci podręcznej, a pola używane
+ * przy każdej wiadomości leżą na jej początku. Zamiast mutexa aktor ma jedno
+ * atomowe słowo stanu. Wszystko, co nie jest potrzebne przy wysyłce
+ * i przetwarzaniu wiadomości, trzymamy poza nim (zob. actor_metrics_t). */
 typedef struct actor_state {
-    actor_id_t id;
-    role_t     *role;
-    generic_queue *q;
-    pthread_mutex_t mutex;
-    bool is_dead;
-    bool is_already_on_queue;
-    void *stateptr;
+    _Alignas(CACHE_LINE) mpsc_queue q;
+    atomic_uint state;
+    atomic_int  home_worker; // Wątek, który ostatnio przetwarzał aktora (lub go utworzył).
+    role_t      *role;
+    void        *stateptr;
+    _Atomic(actor_id_t) id;
 } actor_state_t;
 
-void safe_destroy_actor(actor_state_t *actor) {
-    int res;
+_Static_assert(sizeof (actor_state_t) == CACHE_LINE, "actor_state_t should fit in one cache line");
+
+/* Liczniki i histogramy aktora, alokowane tylko przy włączonych statystykach
+ * lub histogramach opóźnień. */
+typedef struct actor_metrics {
+    atomic_ullong enqueued;
+    atomic_ullong dropped;
+    atomic_ullong max_depth;
+    atomic_ullong handler_ns;
+    latency_histogram_t *latency; // Histogramy roli aktora, NULL gdy wyłączone.
+} actor_metrics_t;
+
+/* Skrzynki aktora poza zwykłą 'q', trzymane obok stanu aktora, jak liczniki.
+ * Komunikaty sterujące (MSG_HELLO, MSG_SPAWN, MSG_GODIE) trafiają na stos
+ * 'control', z którego konsument przenosi je naraz, w kolejności wysłania,
+ * do listy 'ready'. Wiadomości o priorytecie wyższym niż PRIORITY_NORMAL
+ * trafiają do kolejek 'lanes', alokowanych przy pierwszej takiej wiadomości. */
+typedef struct actor_lanes {
+    _Atomic(mpsc_node_t *) control; // Ostatnio wysłany komunikat sterujący.
+    _Atomic(mpsc_node_t *) ready;   // Najstarszy komunikat sterujący, należy do konsumenta.
+    _Atomic(mpsc_queue *) lanes;    // Kolejki priorytetów od 1 do PRIORITY_LEVELS - 1.
+    atomic_size_t control_size;     // Liczba komunikatów na stosie i na liście 'ready'.
+} actor_lanes_t;
+
+/* Inicjalizuje stan aktora w miejscu, we fragmencie tablicy aktorów. Przy
+ * ponownym użyciu miejsca zachowujemy licznik nadawców, którzy mogą jeszcze
+ * trzymać numer poprzednika; zobaczą nowy numer i wycofają się. */
+void init_actor(actor_state_t *actor, actor_id_t id, role_t *role, bool reused) {
+    mpsc_init(&actor->q);
+    atomic_init(&actor->home_worker, (int) worker_index);
+    actor->role = role;
+    actor->stateptr = NULL;
+
+    if (reused) {
+        atomic_store(&actor->id, id);
+        atomic_fetch_and(&actor->state, ~(ACTOR_DEAD | ACTOR_FREE));
+    }
+    else {
+        atomic_init(&actor->id, id);
+        atomic_init(&actor->state, 0);
+    }
+}
 
-    if (actor != NULL) {
-        if (actor->q != NULL) {
-            free_queue(actor->q);
-        }
+void init_metrics(actor_metrics_t *metrics, role_t *role, latency_table_t *latency) {
+    atomic_init(&metrics->enqueued, 0);
+    atomic_init(&metrics->dropped, 0);
+    atomic_init(&metrics->max_depth, 0);
+    atomic_init(&metrics->handler_ns, 0);
+    metrics->latency = latency != NULL ? latency_role_histograms(latency, role) : NULL;
+}
 
-        if ((res = pthread_mutex_destroy(&actor->mutex)) != 0) {
-            syserr(res, "Destroying actor mutex failed!\n");
-        }
+void init_lanes(actor_lanes_t *lanes) {
+    atomic_init(&lanes->control, NULL);
+    atomic_init(&lanes->ready, NULL);
+    atomic_init(&lanes->lanes, NULL);
+    atomic_init(&lanes->control_size, 0);
+}
 
-        free(actor);
-    }
+/* Router to aktor, którego rola leży na początku tej struktury. Wiadomości do
+ * routera nie trafiają do jego skrzynki: nadawca sam wybiera aktora puli
+ * i wstawia wiadomość do jego skrzynki (zob. route_message). Rozpoznajemy go
+ * po tablicy obsług 'router_prompts', a zwalniamy razem z jego miejscem. */
+typedef struct router {
+    role_t role;
+    router_strategy_t strategy;
+    router_key_t key;
+    atomic_size_t next;  // Licznik wysyłek, dla równego rozkładu.
+    size_t size;
+    actor_id_t routees[];
+} router_t;
+
+static act_t router_prompts[] = {NULL};
+
+bool is_router(const role_t *role) {
+    return role->prompts == router_prompts;
+}
+
+bool is_control_message(message_type_t message_type) {
+    return message_type == MSG_HELLO || message_type == MSG_SPAWN || message_type == MSG_GODIE;
+}
+
+bool actor_is_dead(actor_state_t *actor) {
+    return atomic_load(&actor->state) & ACTOR_DEAD;
+}
+
+overflow_t actor_overflow(cacti_system_t *sys, actor_state_t *actor) {
+    return actor->role->overflow != OVERFLOW_DEFAULT ? actor->role->overflow : sys->overflow;
 }
 
-actor_state_t* create_actor(actor_id_t id, role_t *role) {
-    actor_state_t *new_actor = safe_malloc(sizeof (actor_state_t));
+// Limit skrzynki aktora, 0 = brak limitu.
+size_t actor_limit(cacti_system_t *sys, actor_state_t *actor) {
+    return actor_overflow(sys, actor) == OVERFLOW_UNBOUNDED ? 0 : sys->queue_limit;
+}
 
-    new_actor->id = id;
-    new_actor->role = role;
-    new_actor->q = create_queue((void *) ACTOR_QUEUE_LIMIT);
-    new_actor->is_dead = false;
-    new_actor->stateptr = NULL;
-    new_actor->is_already_on_queue = false;
-    pthread_mutex_init(&new_actor->mutex, NULL);
+/* Limit, który pilnuje skrzynka przy dodawaniu. Przy OVERFLOW_DROP_OLDEST limit
+ * pilnuje aktor, usuwając nadmiar przed wykonaniem komunikatu. */
+size_t mailbox_limit(cacti_system_t *sys, actor_state_t *actor) {
+    return actor_overflow(sys, actor) == OVERFLOW_DROP_OLDEST ? 0 : actor_limit(sys, actor);
+}
 
-    return new_actor;
+/* Limit stosu sterującego dla komunikatu 'message_type'. Stosu nie da się
+ * przycinać ani na nim czekać, więc nadmiar jest odrzucany przy każdym
+ * zachowaniu. MSG_GODIE jest przyjmowany zawsze, żeby aktora z pełną
+ * skrzynką dało się zatrzymać. */
+size_t control_limit(cacti_system_t *sys, actor_state_t *actor, message_type_t message_type) {
+    return message_type == MSG_GODIE ? 0 : actor_limit(sys, actor);
 }
 
 // ---------------- VECTOR IMPLEMENTATION -----------------
-typedef struct vector {
-    actor_state_t   **elements;
-    size_t     max_size;
-    size_t     curr_size; // Ilosc zajetych komórek.
-    size_t     how_many_dead;
+/* Tablica aktorów jest dwupoziomowa: stała tablica wskaźników na fragmenty,
+ * z których każdy mieści VECTOR_CHUNK_SIZE aktorów, ułożonych w nim wprost
+ * (bez osobnej alokacji na aktora). Fragmenty są alokowane przy pierwszym
+ * użyciu i nigdy nie są przenoszone, więc odczyt aktora nie wymaga mutexa.
+ * Mutex tablicy chroni jedynie tworzenie i uśmiercanie aktorów. */
+#define VECTOR_CHUNK_SIZE 1024
+#define VECTOR_CHUNKS_NUM ((CAST_LIMIT + VECTOR_CHUNK_SIZE - 1) / VECTOR_CHUNK_SIZE)
+
+struct vector {
+    _Atomic(actor_state_t *) chunks[VECTOR_CHUNKS_NUM];
+    actor_metrics_t *metrics[VECTOR_CHUNKS_NUM]; // Liczniki aktorów, NULL gdy wyłączone.
+    actor_lanes_t *lanes[VECTOR_CHUNKS_NUM];
+    bool       with_metrics;
+    latency_table_t *latency; // Histogramy opóźnień systemu, NULL gdy wyłączone.
+    atomic_size_t   curr_size; // Ilosc zajetych komórek.
+    atomic_size_t   live;      // Liczba żyjących aktorów.
+    size_t     *free_slots;    // Stos zwolnionych miejsc, gotowych do ponownego użycia.
+    size_t     free_num;
+    size_t     free_capacity;
     pthread_mutex_t vec_mutex;
-} vector;
+};
 
-vector* create_vector() {
+vector* create_vector(bool with_metrics, latency_table_t *latency) {
     vector *new_vec;
     int res;
 
     new_vec = safe_malloc(sizeof (vector));
+    new_vec->with_metrics = with_metrics || latency != NULL;
+    new_vec->latency = latency;
+
+    for (size_t i = 0; i < VECTOR_CHUNKS_NUM; i++) {
+        atomic_init(&new_vec->chunks[i], NULL);
+        new_vec->metrics[i] = NULL;
+        new_vec->lanes[i] = NULL;
+    }
 
-    new_vec->max_size = 1024;
-    new_vec->curr_size = 0;
-    new_vec->how_many_dead = 0;
-    new_vec->elements = safe_malloc(sizeof(actor_state_t *) * new_vec->max_size);
+    atomic_init(&new_vec->curr_size, 0);
+    atomic_init(&new_vec->live, 0);
+    new_vec->free_slots = NULL;
+    new_vec->free_num = 0;
+    new_vec->free_capacity = 0;
 
     if ((res = pthread_mutex_init(&(new_vec->vec_mutex), NULL)) != 0) {
         syserr(res, "Mutex init failed!");
@@ -116,466 +303,1926 @@ vector* create_vector() {
     return new_vec;
 }
 
-void destroy_vector(vector *vec) {
-    if (vec != NULL) {
-        if (vec->elements != NULL) {
-            for (size_t i = 0; i < vec->curr_size; i++) {
-                safe_destroy_actor(vec->elements[i]);
-            }
+// Usuwa wiadomości z listy połączonej polami 'next'.
+void destroy_list(mpsc_node_t *node) {
+    while (node != NULL) {
+        mpsc_node_t *next = atomic_load_explicit(&node->next, memory_order_relaxed);
+
+        envelope_destroy(node);
+        node = next;
+    }
+}
+
+// Opróżnia i zwalnia dodatkowe skrzynki aktora. Nie może działać współbieżnie z nadawcami.
+void clear_lanes(actor_lanes_t *lanes) {
+    mpsc_queue *prio = atomic_load(&lanes->lanes);
+
+    destroy_list(atomic_load(&lanes->ready));
+    destroy_list(atomic_load(&lanes->control));
 
-            free(vec->elements);
+    if (prio != NULL) {
+        for (size_t i = 0; i < PRIORITY_LEVELS - 1; i++) {
+            mpsc_clear(&prio[i], envelope_destroy);
         }
 
-        free(vec);
+        free(prio);
     }
 }
 
-/* Podawaja rozmiar danego wektora */
-void v_size_up(vector *vec) {
-    void *tmp_elements;
+void destroy_vector(vector *vec) {
+    int res;
+
+    if (vec != NULL) {
+        size_t size = atomic_load(&vec->curr_size);
 
-    vec->max_size *= 2;
+        for (size_t i = 0; i < VECTOR_CHUNKS_NUM; i++) {
+            actor_state_t *chunk = atomic_load(&vec->chunks[i]);
 
-    if (vec->max_size <= vec->curr_size) {
-        fatal("Something went wrong with expanding vector!\n");
-    }
+            if (chunk == NULL) {
+                break;
+            }
+
+            for (size_t j = 0; j < VECTOR_CHUNK_SIZE && i * VECTOR_CHUNK_SIZE + j < size; j++) {
+                mpsc_clear(&chunk[j].q, envelope_destroy);
+                clear_lanes(&vec->lanes[i][j]);
+
+                // Router zwolnionego miejsca został już zwolniony w vector_reclaim.
+                if (!(atomic_load(&chunk[j].state) & ACTOR_FREE) && is_router(chunk[j].role)) {
+                    free(chunk[j].role);
+                }
+            }
+
+            free(chunk);
+            free(vec->metrics[i]);
+            free(vec->lanes[i]);
+        }
+
+        free(vec->free_slots);
 
-    tmp_elements = realloc(vec->elements, vec->max_size * sizeof (actor_state_t *));
+        if ((res = pthread_mutex_destroy(&vec->vec_mutex)) != 0) {
+            syserr(res, "Destroying vector mutex failed!\n");
+        }
 
-    if (tmp_elements == NULL) {
-        fatal("Realloc failed\n");
+        free(vec);
     }
+}
 
-    vec->elements = tmp_elements;
+/* Zwraca liczbę zajętych kiedykolwiek miejsc wektora */
+size_t vector_size(vector *vec) {
+    return atomic_load_explicit(&vec->curr_size, memory_order_acquire);
 }
 
-/* Dodaje nowego aktora, o danej roli, do danego wektora.
- * Zwraca numer utworzonego tak aktora. */
+/* Dodaje nowego aktora, o danej roli, do danego wektora, w miarę możliwości
+ * w miejscu po zmarłym aktorze. Zwraca numer utworzonego tak aktora. */
 actor_id_t add_act(vector *vec, role_t *role) {
     int res;
     actor_id_t act_id;
+    actor_state_t *chunk;
+    size_t index;
 
     if ((res = pthread_mutex_lock(&vec->vec_mutex)) != 0) {
         syserr(res, "Locking mutex failed! (Add_act)\n");
     }
 
-    if (vec->curr_size == CAST_LIMIT) {
-        fatal("CAST ACTOR LIMIT EXCEEDED!\n");
-    }
-    if (vec->curr_size == vec->max_size) {
-        v_size_up(vec);
-    }
+    if (vec->free_num > 0) {
+        index = vec->free_slots[--vec->free_num];
+        chunk = atomic_load_explicit(&vec->chunks[index / VECTOR_CHUNK_SIZE], memory_order_relaxed);
+        act_id = atomic_load(&chunk[index % VECTOR_CHUNK_SIZE].id) + CAST_LIMIT;
 
-    act_id = vec->curr_size;
-    vec->elements[act_id] = create_actor(act_id, role);
-    vec->curr_size++;
+        if (act_id < 0) {
+            fatal("ACTOR ID SPACE EXHAUSTED!\n");
+        }
 
-    if ((res = pthread_mutex_unlock(&vec->vec_mutex)) != 0) {
-        syserr(res, "Unlocking mutex failed! (Add_act)\n");
+        init_actor(&chunk[index % VECTOR_CHUNK_SIZE], act_id, role, true);
     }
+    else {
+        index = atomic_load_explicit(&vec->curr_size, memory_order_relaxed);
+        act_id = (actor_id_t) index;
 
-    return act_id;
-}
+        if (index == CAST_LIMIT) {
+            fatal("CAST ACTOR LIMIT EXCEEDED!\n");
+        }
 
+        chunk = atomic_load_explicit(&vec->chunks[index / VECTOR_CHUNK_SIZE], memory_order_relaxed);
 
-/* Wyciagamy element z vektora o podanym id. (BIERZEMY MUTEX!) */
-actor_state_t *vector_get(vector *vec, size_t id) {
-    int res;
-    actor_state_t *tmp;
+        if (chunk == NULL) {
+            chunk = aligned_alloc(CACHE_LINE, sizeof (actor_state_t) * VECTOR_CHUNK_SIZE);
 
-    if ((res = pthread_mutex_lock(&vec->vec_mutex)) != 0) {
-        syserr(res, "Locking mutex failed! (Add_act)\n");
+            if (chunk == NULL) {
+                fatal("Malloc failed!\n");
+            }
+
+            if (vec->with_metrics) {
+                vec->metrics[index / VECTOR_CHUNK_SIZE] = safe_malloc(sizeof (actor_metrics_t) * VECTOR_CHUNK_SIZE);
+            }
+
+            vec->lanes[index / VECTOR_CHUNK_SIZE] = safe_malloc(sizeof (actor_lanes_t) * VECTOR_CHUNK_SIZE);
+
+            atomic_store_explicit(&vec->chunks[index / VECTOR_CHUNK_SIZE], chunk, memory_order_release);
+        }
+
+        init_actor(&chunk[index % VECTOR_CHUNK_SIZE], act_id, role, false);
+        // Zwolnione miejsce ma puste skrzynki, więc inicjalizujemy je tylko raz.
+        init_lanes(&vec->lanes[index / VECTOR_CHUNK_SIZE][index % VECTOR_CHUNK_SIZE]);
     }
 
-    if (id <= vec->curr_size) {
-        tmp = vec->elements[id];
+    // Router nie wykonuje komunikatów, więc nie potrzebuje histogramów.
+    if (vec->metrics[index / VECTOR_CHUNK_SIZE] != NULL) {
+        init_metrics(&vec->metrics[index / VECTOR_CHUNK_SIZE][index % VECTOR_CHUNK_SIZE], role,
+                     is_router(role) ? NULL : vec->latency);
     }
-    else {
-        tmp = NULL;
+
+    atomic_fetch_add(&vec->live, 1);
+
+    /* Nowe miejsce staje się widoczne dla innych wątków dopiero po zwiększeniu
+     * licznika, więc wszystkie zapisy powyżej są już wtedy widoczne. */
+    if (index == atomic_load_explicit(&vec->curr_size, memory_order_relaxed)) {
+        atomic_store_explicit(&vec->curr_size, index + 1, memory_order_release);
     }
 
     if ((res = pthread_mutex_unlock(&vec->vec_mutex)) != 0) {
-        syserr(res, "Locking mutex failed! (Add_act)\n");
+        syserr(res, "Unlocking mutex failed! (Add_act)\n");
     }
 
-    return tmp;
+    return act_id;
 }
 
-/* Wyciagamy element z vektora o podanym id, przy czym nie
- * zabezpieczamy tej operacji mutexem */
-actor_state_t *vector_get_no_mutex(vector *vec, size_t id) {
-    if (id <= vec->curr_size) {
-        return vec->elements[id];
+
+/* Wyciagamy z wektora miejsce aktora o podanym id, lub NULL gdy takiego nie ma.
+ * Miejsce może już należeć do innego pokolenia, co sprawdza wywołujący.
+ * Nie bierzemy mutexa, odczyt jest bezczekający. */
+actor_state_t *vector_get(vector *vec, actor_id_t id) {
+    size_t index = actor_index(id);
+
+    if (id >= 0 && index < vector_size(vec)) {
+        actor_state_t *chunk = atomic_load_explicit(&vec->chunks[index / VECTOR_CHUNK_SIZE],
+                                                    memory_order_acquire);
+
+        return &chunk[index % VECTOR_CHUNK_SIZE];
     }
     else {
         return NULL;
     }
 }
 
+/* Zwraca liczniki aktora o podanym id, lub NULL gdy są wyłączone.
+ * Aktor musi już być w wektorze. */
+actor_metrics_t *vector_metrics(vector *vec, actor_id_t id) {
+    actor_metrics_t *metrics = vec->metrics[actor_index(id) / VECTOR_CHUNK_SIZE];
 
-// Ustawia stan podanego aktora na martwy.
-void actor_turn_dead(vector *vec, actor_id_t act_id) {
-    int res;
+    return metrics != NULL ? &metrics[actor_index(id) % VECTOR_CHUNK_SIZE] : NULL;
+}
 
-    act_lock_mutex_unsafe(act_id);
+// Zwraca dodatkowe skrzynki aktora o podanym id. Aktor musi już być w wektorze.
+actor_lanes_t *vector_lanes(vector *vec, actor_id_t id) {
+    return &vec->lanes[actor_index(id) / VECTOR_CHUNK_SIZE][actor_index(id) % VECTOR_CHUNK_SIZE];
+}
 
-    if ((res = pthread_mutex_lock(&vec->vec_mutex)) != 0) {
-        syserr(res, "Locking mutex failed! (Add_act)\n");
+// Sprawdza, czy wszystkie skrzynki aktora są puste.
+bool mailbox_is_empty(vector *vec, actor_state_t *actor) {
+    if (!mpsc_is_empty(&actor->q)) {
+        return false;
     }
 
-    actor_state_t *actor_state = vector_get_no_mutex(vec, act_id);
-
-    actor_state->is_dead = true;
-
-    vec->how_many_dead++;
+    actor_lanes_t *lanes = vector_lanes(vec, atomic_load_explicit(&actor->id, memory_order_relaxed));
+    mpsc_queue *prio = atomic_load(&lanes->lanes);
 
-    if(vec->how_many_dead == vec->curr_size) {
-        is_system_alive = false;
+    if (atomic_load(&lanes->control) != NULL || atomic_load(&lanes->ready) != NULL) {
+        return false;
     }
 
-    if ((res = pthread_mutex_unlock(&vec->vec_mutex)) != 0) {
-        syserr(res, "Unlocking mutex failed! (Add_act)\n");
+    for (size_t i = 0; prio != NULL && i < PRIORITY_LEVELS - 1; i++) {
+        if (!mpsc_is_empty(&prio[i])) {
+            return false;
+        }
     }
 
-    act_unlock_mutex_unsafe(act_id);
+    return true;
 }
 
-//---------------- END OF VECTOR IMPLEMENTATION ------------------------
+// Zwraca łączną liczbę wiadomości we wszystkich skrzynkach aktora.
+size_t mailbox_size(vector *vec, actor_state_t *actor) {
+    actor_lanes_t *lanes = vector_lanes(vec, atomic_load_explicit(&actor->id, memory_order_relaxed));
+    mpsc_queue *prio = atomic_load(&lanes->lanes);
+    size_t size = mpsc_size(&actor->q) + atomic_load_explicit(&lanes->control_size, memory_order_relaxed);
 
-//----------------- THREAD POOL IMPLEMENTATION --------------------------
-struct thread_pool {
-    pthread_mutex_t mutex;
-    pthread_cond_t work_cond;
-    size_t active_threads_num;
-    size_t threads_num;
-    bool still_running;
-    generic_queue *work_q;
-    pthread_t *threads;
-};
+    for (size_t i = 0; prio != NULL && i < PRIORITY_LEVELS - 1; i++) {
+        size += mpsc_size(&prio[i]);
+    }
 
-void *tpool_worker(void *arg) {
-    int res;
-    tpool_t *tp = arg;
+    return size;
+}
 
-    if ((res = pthread_mutex_lock(&system_mutex)) != 0) {
-        syserr(res, "Thread 'SYSTEM' mutex failed!\n");
+/* Zwraca kolejkę aktora dla wiadomości o priorytecie 'priority', alokując
+ * kolejki priorytetów przy pierwszym użyciu. */
+mpsc_queue *mailbox_lane(vector *vec, actor_state_t *actor, int priority) {
+    if (priority == PRIORITY_NORMAL) {
+        return &actor->q;
     }
 
-    if ((res = pthread_mutex_unlock(&system_mutex)) != 0) {
-        syserr(res, "Thread 'SYSTEM' mutex failed!\n");
-    }
+    actor_lanes_t *lanes = vector_lanes(vec, atomic_load_explicit(&actor->id, memory_order_relaxed));
+    mpsc_queue *prio = atomic_load(&lanes->lanes);
 
-    while (1) {
-        /* W pętli nieskończonej wątek najpierw patrzy czy jest praca do wykonania, czyli
-         * czy znajduje sie jakiś aktor na kolejce, który czeka na przetworzenie, jezeli nie ma pracy,
-         * a system dalej dziala to wieszamy się na zmiennej warunkowej, jeżeli jest praca
-         * to pobieramy id kolejnego aktora z kolejki i przetwarzamy k komunikatow z jego kolejki,
-         * gdzie k określa ile komunikatów było na jego kolejce w momencie rozpoczęcia przetwarzania,
-         * ostatni watek ktory skonczy pracę iniciuje sprzątanie systemu, przy czym nie rusza struktury
-         * puli wątków. */
-        if ((res = pthread_mutex_lock(&tp->mutex)) != 0) {
-            syserr(res, "Thread mutex failed!\n");
+    if (prio == NULL) {
+        mpsc_queue *created = safe_malloc(sizeof (mpsc_queue) * (PRIORITY_LEVELS - 1));
+
+        for (size_t i = 0; i < PRIORITY_LEVELS - 1; i++) {
+            mpsc_init(&created[i]);
         }
 
-        while (is_empty(tp->work_q) && tp->still_running && is_system_alive && !signaled) {
-            if((res = pthread_cond_wait(&tp->work_cond, &tp->mutex)) != 0) {
-                syserr(res, "Thread conditional wait failed!\n");
-            }
+        // Kolejki mógł już założyć inny nadawca, wtedy używamy jego.
+        if (atomic_compare_exchange_strong(&lanes->lanes, &prio, created)) {
+            prio = created;
+        }
+        else {
+            free(created);
         }
+    }
 
-        if ((!is_system_alive || signaled) && is_empty(tp->work_q)) {
-            tp->still_running = false;
+    return &prio[priority - 1];
+}
 
-            if ((res = pthread_cond_broadcast(&tp->work_cond)) != 0) {
-                syserr(res, "Thread broadcast failed!\n");
-            }
+/* Odkłada komunikat sterujący na stos aktora, o ile leży na nim mniej niż
+ * 'limit' komunikatów (0 = brak limitu). Zwraca 0, lub -1 gdy stos jest pełny.
+ * Bezpieczne dla wielu nadawców. */
+int mailbox_push_control(vector *vec, actor_state_t *actor, mpsc_node_t *node, size_t limit) {
+    actor_lanes_t *lanes = vector_lanes(vec, atomic_load_explicit(&actor->id, memory_order_relaxed));
+    size_t size = atomic_load_explicit(&lanes->control_size, memory_order_relaxed);
 
-            break;
+    do {
+        if (limit > 0 && size >= limit) {
+            return -1;
         }
+    } while (!atomic_compare_exchange_weak(&lanes->control_size, &size, size + 1));
 
-        actor_id_t act_id = (actor_id_t) queue_pop(tp->work_q);
+    mpsc_node_t *top = atomic_load_explicit(&lanes->control, memory_order_relaxed);
 
-        int nprompts = how_many_messages(act_id);
+    do {
+        atomic_store_explicit(&node->next, top, memory_order_relaxed);
+    } while (!atomic_compare_exchange_weak(&lanes->control, &top, node));
 
-        self_actor_id = act_id;
+    return 0;
+}
 
-        if ((res = pthread_mutex_unlock(&tp->mutex)) != 0) {
-            syserr(res, "Thread mutex failed!\n");
-        }
+/* Zdejmuje następną wiadomość aktora: najpierw komunikat sterujący, potem
+ * wiadomość o najwyższym priorytecie, a na końcu ze zwykłej skrzynki. Zwraca
+ * NULL, gdy skrzynki są puste. Może być wołane tylko przez konsumenta. */
+mpsc_node_t *mailbox_pop(vector *vec, actor_state_t *actor, actor_id_t id) {
+    actor_lanes_t *lanes = vector_lanes(vec, id);
+    mpsc_node_t *node = atomic_load_explicit(&lanes->ready, memory_order_relaxed);
+    mpsc_queue *prio;
 
-        execute_commands(act_id, nprompts);
-        try_to_add_actor(act_id, tp);
-    }
+    if (node == NULL && atomic_load_explicit(&lanes->control, memory_order_relaxed) != NULL) {
+        mpsc_node_t *stack = atomic_exchange_explicit(&lanes->control, NULL, memory_order_acquire);
 
-    tp->active_threads_num--;
+        // Stos ma najnowszy komunikat na szczycie, więc odwracamy kolejność.
+        while (stack != NULL) {
+            mpsc_node_t *next = atomic_load_explicit(&stack->next, memory_order_relaxed);
 
-    if (tp->active_threads_num == 0) {
-        if ((res = pthread_mutex_unlock(&tp->mutex)) != 0) {
-            syserr(res, "Thread mutex failed!\n");
+            atomic_store_explicit(&stack->next, node, memory_order_relaxed);
+            node = stack;
+            stack = next;
         }
+    }
 
-        destroy_actor_system();
+    if (node != NULL) {
+        atomic_store_explicit(&lanes->ready, atomic_load_explicit(&node->next, memory_order_relaxed),
+                              memory_order_relaxed);
+        atomic_fetch_sub_explicit(&lanes->control_size, 1, memory_order_relaxed);
+        return node;
     }
-    else {
-        if ((res = pthread_mutex_unlock(&tp->mutex)) != 0) {
-            syserr(res, "Thread mutex failed!\n");
+
+    if ((prio = atomic_load_explicit(&lanes->lanes, memory_order_acquire)) != NULL) {
+        for (size_t i = PRIORITY_LEVELS - 1; i-- > 0;) {
+            if ((node = mpsc_pop(&prio[i])) != NULL) {
+                return node;
+            }
         }
     }
 
-    return NULL;
+    return mpsc_pop(&actor->q);
 }
 
-tpool_t *tpool_create(size_t active_threads_num) {
-    tpool_t *new_tp = safe_malloc(sizeof (tpool_t));
+/* Zwraca miejsce martwego aktora do puli, o ile nikt go już nie używa. Miejsce
+ * zwalnia ten, komu uda się zmienić stan z ACTOR_DEAD na ACTOR_FREE, więc
+ * dzieje się to dokładnie raz. Nadawca, który nadal zna numer aktora, widzi
+ * potem ACTOR_FREE albo inny numer, więc nie dotknie skrzynki następcy. */
+void vector_reclaim(vector *vec, actor_state_t *actor) {
+    unsigned expected = ACTOR_DEAD;
     int res;
 
-    if (!new_tp) {
-        exit(1);
+    if (!mailbox_is_empty(vec, actor) ||
+        !atomic_compare_exchange_strong(&actor->state, &expected, ACTOR_DEAD | ACTOR_FREE)) {
+        return;
     }
 
-    new_tp->work_q = create_queue(NULL);
+    if (is_router(actor->role)) {
+        free(actor->role);
+    }
 
-    if (!new_tp->work_q){
-        fatal("Thread pool initialization failure!\n");
-        exit(1);
+    if ((res = pthread_mutex_lock(&vec->vec_mutex)) != 0) {
+        syserr(res, "Locking mutex failed! (Reclaim)\n");
     }
 
-    new_tp->active_threads_num = active_threads_num;
-    new_tp->threads_num = active_threads_num;
-    new_tp->still_running = true;
-    new_tp->threads = safe_malloc(sizeof(pthread_t) * active_threads_num);
+    if (vec->free_num == vec->free_capacity) {
+        vec->free_capacity = vec->free_capacity == 0 ? VECTOR_CHUNK_SIZE : vec->free_capacity * 2;
+        vec->free_slots = realloc(vec->free_slots, sizeof (size_t) * vec->free_capacity);
 
-    if ((res = pthread_mutex_init(&new_tp->mutex, NULL)) != 0) {
-        syserr(res, "Thread pool mutex initalization failure!\n");
+        if (vec->free_slots == NULL) {
+            fatal("Malloc failed!\n");
+        }
     }
 
-    if ((res = pthread_cond_init(&new_tp->work_cond, NULL)) != 0) {
-        syserr(res, "Thread pool conditional initialization failure!\n");
-    }
+    vec->free_slots[vec->free_num++] = actor_index(actor->id);
 
-    for (size_t i = 0; i < active_threads_num; i++) {
-        pthread_create(&new_tp->threads[i], NULL, tpool_worker, new_tp);
+    if ((res = pthread_mutex_unlock(&vec->vec_mutex)) != 0) {
+        syserr(res, "Unlocking mutex failed! (Reclaim)\n");
     }
-
-    return new_tp;
 }
 
-void tpool_destroy(tpool_t *tp) {
+// Ustawia stan podanego aktora na martwy. Zwraca true, jeżeli był to ostatni żyjący aktor.
+bool actor_turn_dead(vector *vec, actor_id_t act_id) {
+    bool last = false;
     int res;
 
-    if (tp != NULL) {
-        if (tp->work_q != NULL) {
-            free_queue(tp->work_q);
-        }
-
-        if (tp->threads != NULL) {
-            for (size_t i = 0; i < tp->threads_num; i++) {
-                if ((res = pthread_join(tp->threads[i], NULL)) != 0) {
-                    syserr(res, "Thread join failed!\n");
-                }
-            }
-
-            free(tp->threads);
-        }
+    if ((res = pthread_mutex_lock(&vec->vec_mutex)) != 0) {
+        syserr(res, "Locking mutex failed! (Add_act)\n");
+    }
 
-        if ((res = pthread_mutex_destroy(&tp->mutex)) != 0) {
-            syserr(res, "Destroying thread pool mutex failed!\n");
-        }
+    actor_state_t *actor_state = vector_get(vec, act_id);
 
-        if ((res = pthread_cond_destroy(&tp->work_cond)) != 0) {
-            syserr(res, "Destroying thread pool cond failed!\n");
-        }
+    if (!(atomic_fetch_or(&actor_state->state, ACTOR_DEAD) & ACTOR_DEAD) &&
+        atomic_fetch_sub(&vec->live, 1) == 1) {
+        last = true;
+    }
 
-        free(tp);
+    if ((res = pthread_mutex_unlock(&vec->vec_mutex)) != 0) {
+        syserr(res, "Unlocking mutex failed! (Add_act)\n");
     }
+
+    return last;
 }
 
-//----------------- END OF THREAD POOL IMPLEMENTATION --------------------------
+//---------------- END OF VECTOR IMPLEMENTATION ------------------------
 
-tpool_t *thread_pool = NULL;
-vector *actors = NULL;
+//----------------- THREAD POOL IMPLEMENTATION --------------------------
+/* Każdy wątek roboczy ma własną kolejkę aktorów gotowych do przetworzenia.
+ * Wątek najpierw obsługuje swoją kolejkę, a gdy ta jest pusta, podkrada
+ * aktorów z kolejek pozostałych wątków. Globalny mutex puli jest potrzebny
+ * jedynie do usypiania i budzenia bezczynnych wątków. */
+struct thread_pool {
+    pthread_mutex_t mutex;
+    size_t active_threads_num;
+    size_t threads_num;
+    bool still_running;
+    generic_queue **work_qs;    // Kolejki aktorów, po jednej na wątek.
+    atomic_size_t pending;      // Liczba aktorów czekających we wszystkich kolejkach.
+    atomic_size_t sleeping;     // Liczba wątków, które zasypiają lub śpią.
+    size_t *parked;             // Stos numerów uśpionych wątków (chroniony 'mutex').
+    size_t parked_num;
+    size_t idle_spins;          // Ile razy bezczynny wątek sprawdza pracę w aktywnej pętli.
+    size_t idle_yields;         // Ile razy potem oddaje procesor, zanim zaśnie.
+    atomic_size_t next_q;       // Licznik rozdzielający pracę zleconą spoza puli.
+    bool placement;             // Czy szeregować aktorów do wątku, który ostatnio ich przetwarzał.
+    /* Liczba aktorów, których blokująca obsługa wykonuje się w puli 'blocking'.
+     * Zmniejszana pod 'mutex', a dopóki jest dodatnia, wątki puli nie kończą pracy. */
+    atomic_size_t offloaded;
+    blocking_pool_t *blocking;
+    thread_ticket_t *threads; // Zadania wątków z pamięci podręcznej wątków.
+    struct worker_arg *workers;
+    cacti_system_t *system;     // System, którego aktorów przetwarza pula.
+};
 
-void catch_signal() {
-    signaled = true;
-    pthread_cond_broadcast(&thread_pool->work_cond);
+/* Liczniki wątku roboczego. Każdy wątek zapisuje tylko swoje liczniki,
+ * a inne wątki mogą je jedynie odczytywać. Liczniki leżą na początku
+ * struktury wątku, wyrównanej do linii pamięci podręcznej, więc wątki
+ * nie unieważniają sobie nawzajem linii przy każdym zwiększeniu. */
+typedef struct worker_counters {
+    atomic_ullong activations;
+    atomic_ullong messages;
+    atomic_ullong preemptions;
+    atomic_ullong max_batch;
+    atomic_ullong steals;
+    atomic_ullong parks;
+    atomic_ullong wakeups;
+} worker_counters_t;
+
+typedef struct worker_arg {
+    _Alignas(CACHE_LINE) worker_counters_t counters;
+    tpool_t *tp;
+    size_t index;
+    pthread_cond_t park_cond; // Na tej zmiennej śpi wątek, gdy nie ma pracy.
+    bool parked;              // Czy wątek jest na stosie uśpionych.
+    bool notified;            // Czy wątek został obudzony przez tpool_wake_one.
+} worker_arg_t;
+
+// Wstrzymanie procesora na chwilę w trakcie aktywnego czekania.
+static inline void cpu_relax() {
+#if defined(__x86_64__) || defined(__i386__)
+    __builtin_ia32_pause();
+#elif defined(__aarch64__) || defined(__arm__)
+    __asm__ __volatile__("yield");
+#endif
 }
 
+// Zwiększa licznik, do którego pisze tylko jeden wątek.
+void counter_add(atomic_ullong *counter, unsigned long long value) {
+    atomic_store_explicit(counter, atomic_load_explicit(counter, memory_order_relaxed) + value,
+                          memory_order_relaxed);
+}
 
-/* Zwalnia pamięć odpowiedzalną za system aktorów, bez niszczenia struktury puli wątków */
-void destroy_actor_system() {
-    int res;
-    if ((res = pthread_mutex_lock(&system_mutex)) != 0) {
-        syserr(res, "Destroy system mutex failed!\n");
+void counter_max(atomic_ullong *counter, unsigned long long value) {
+    if (atomic_load_explicit(counter, memory_order_relaxed) < value) {
+        atomic_store_explicit(counter, value, memory_order_relaxed);
     }
+}
 
-    destroy_vector(actors);
-    actors = NULL;
-    if ((res =  pthread_cond_signal(&system_join)) != 0) {
-        syserr(res, "Destroy system signal failed!\n");
-    }
+void worker_counters_reset(worker_counters_t *counters) {
+    atomic_store(&counters->activations, 0);
+    atomic_store(&counters->messages, 0);
+    atomic_store(&counters->preemptions, 0);
+    atomic_store(&counters->max_batch, 0);
+    atomic_store(&counters->steals, 0);
+    atomic_store(&counters->parks, 0);
+    atomic_store(&counters->wakeups, 0);
+}
 
-    if ((res = pthread_mutex_unlock(&system_mutex)) != 0) {
-        syserr(res, "Destroy system mutex failed!\n");
+void worker_counters_read(worker_counters_t *from, worker_stats_t *stats) {
+    stats->activations = atomic_load_explicit(&from->activations, memory_order_relaxed);
+    stats->messages = atomic_load_explicit(&from->messages, memory_order_relaxed);
+    stats->preemptions = atomic_load_explicit(&from->preemptions, memory_order_relaxed);
+    stats->max_batch = atomic_load_explicit(&from->max_batch, memory_order_relaxed);
+    stats->steals = atomic_load_explicit(&from->steals, memory_order_relaxed);
+    stats->parks = atomic_load_explicit(&from->parks, memory_order_relaxed);
+    stats->wakeups = atomic_load_explicit(&from->wakeups, memory_order_relaxed);
+}
+
+// Dolicza statystyki 'from' do 'total'.
+void worker_stats_add(worker_stats_t *total, const worker_stats_t *from) {
+    total->activations += from->activations;
+    total->messages += from->messages;
+    total->preemptions += from->preemptions;
+    total->steals += from->steals;
+    total->parks += from->parks;
+    total->wakeups += from->wakeups;
+
+    if (total->max_batch < from->max_batch) {
+        total->max_batch = from->max_batch;
     }
 }
 
-/* Blokuje mutex aktora o podanym id. (PODNOSI MUTEX GLOBALNEJ TABLICY AKTOROW!) */
-void act_lock_mutex(actor_id_t actor_id) {
-    int res;
-    actor_state_t *actor_state = vector_get(actors, actor_id);
+/* Próbuje pobrać aktora do przetworzenia, najpierw z własnej kolejki,
+ * a następnie z kolejek pozostałych wątków. Zwraca true, jeżeli się udało. */
+bool tpool_take_work(tpool_t *tp, worker_arg_t *worker, actor_id_t *act_id) {
+    void *item;
 
-    if ((res = pthread_mutex_lock(&actor_state->mutex)) != 0) {
-        syserr(res, "Actor mutex failed!\n");
+    if (atomic_load(&tp->pending) == 0) {
+        return false;
     }
-}
 
+    for (size_t i = 0; i < tp->threads_num; i++) {
+        size_t victim = (worker->index + i) % tp->threads_num;
 
-/* Zwalnia mutex aktora o podanym id. (PODNOSI MUTEX GLOBALNEJ TABLICY AKTOROW!) */
-void act_unlock_mutex(actor_id_t actor_id) {
-    int res;
-    actor_state_t *actor_state = vector_get(actors, actor_id);
+        if (queue_try_pop(tp->work_qs[victim], &item) == 0) {
+            atomic_fetch_sub(&tp->pending, 1);
+
+            if (i > 0) {
+                counter_add(&worker->counters.steals, 1);
+            }
+
+            *act_id = (actor_id_t) item;
 
-    if ((res = pthread_mutex_unlock(&actor_state->mutex)) != 0) {
-        syserr(res, "Actor mutex failed!\n");
+            return true;
+        }
     }
+
+    return false;
 }
 
+void tpool_wake_one_locked(tpool_t *tp);
 
-/* Blokuje mutex aktora o podanym id, bez podnoszenia mutexa globalnej tablicy aktorow */
-void act_lock_mutex_unsafe(actor_id_t actor_id) {
+/* Budzi jeden uśpiony wątek, o ile taki istnieje. Wątki są budzone pojedynczo,
+ * każdy na własnej zmiennej warunkowej, a mutex puli bierzemy tylko wtedy,
+ * gdy jakiś wątek zasypia lub śpi. */
+void tpool_wake_one(tpool_t *tp) {
     int res;
-    actor_state_t *actor_state = vector_get_no_mutex(actors, actor_id);
 
-    if ((res = pthread_mutex_lock(&actor_state->mutex)) != 0) {
-        syserr(res, "Actor mutex failed!\n");
+    if (atomic_load(&tp->sleeping) == 0) {
+        return;
+    }
+
+    if ((res = pthread_mutex_lock(&tp->mutex)) != 0) {
+        syserr(res, "Thread mutex failed!\n");
+    }
+
+    tpool_wake_one_locked(tp);
+
+    if ((res = pthread_mutex_unlock(&tp->mutex)) != 0) {
+        syserr(res, "Thread mutex failed!\n");
     }
 }
 
-/* Zwalnia mutex aktora o podanym id, bez podnoszenia mutexa globalnej tablicy aktorow */
-void act_unlock_mutex_unsafe(actor_id_t actor_id) {
+// Budzi jeden uśpiony wątek, o ile taki istnieje. Wymaga posiadania mutexa puli.
+void tpool_wake_one_locked(tpool_t *tp) {
     int res;
-    actor_state_t *actor_state = vector_get_no_mutex(actors, actor_id);
 
-    if ((res = pthread_mutex_unlock(&actor_state->mutex)) != 0) {
-        syserr(res, "Actor mutex failed!\n");
+    if (tp->parked_num > 0) {
+        worker_arg_t *worker = &tp->workers[tp->parked[--tp->parked_num]];
+
+        worker->parked = false;
+        worker->notified = true;
+
+        if (tp->system->trace != NULL) {
+            trace_instant(tp->system->trace, TRACE_WAKE, -1, (long) worker->index);
+        }
+
+        if ((res = pthread_cond_signal(&worker->park_cond)) != 0) {
+            syserr(res, "Thread signal failed!\n");
+        }
     }
 }
 
-/* Zaznacza, że aktor o podanym id, może już trafić spowrotem na kolejkę */
-void actor_end_work(actor_id_t actor_id) {
-    actor_state_t *actor_state = vector_get(actors, actor_id);
+// Budzi wszystkie uśpione wątki. Wymaga posiadania mutexa puli.
+void tpool_wake_all_locked(tpool_t *tp) {
+    int res;
 
-    act_lock_mutex(actor_id);
+    while (tp->parked_num > 0) {
+        worker_arg_t *worker = &tp->workers[tp->parked[--tp->parked_num]];
 
-    actor_state->is_already_on_queue = false;
+        worker->parked = false;
 
-    act_unlock_mutex(actor_id);
+        if ((res = pthread_cond_signal(&worker->park_cond)) != 0) {
+            syserr(res, "Thread signal failed!\n");
+        }
+    }
 }
 
-/* Jezeli jest to mozliwe, dodaje aktora do kolejki, aby kolejny watek
- * mogl zaczac na nim pracowac, dodatkowo sygnalizuje zmienną warunkową
- * na której czekają wątki pracujące */
-void try_to_add_actor(actor_id_t actor_id, tpool_t *tp) {
+/* Kończy system, którego ostatni aktor umarł poza wątkami puli, i budzi uśpione
+ * wątki, żeby to zauważyły. Flagę zmieniamy pod mutexem puli, a wątki kończą
+ * pracę dopiero po jego wzięciu, więc pula nie zniknie przed pobudką. */
+void tpool_finish(tpool_t *tp) {
     int res;
-    actor_state_t *actor_state = vector_get(actors, actor_id);
 
-    act_lock_mutex(actor_id);
+    if ((res = pthread_mutex_lock(&tp->mutex)) != 0) {
+        syserr(res, "Thread mutex failed!\n");
+    }
 
-    if (!is_empty(actor_state->q) && !actor_state->is_already_on_queue) {
-        actor_state->is_already_on_queue = true;
+    tp->system->alive = false;
+    tpool_wake_all_locked(tp);
 
-        if ((res = pthread_mutex_lock(&tp->mutex)) != 0) {
-            syserr(res, "Actor mutex failed!\n");
+    if ((res = pthread_mutex_unlock(&tp->mutex)) != 0) {
+        syserr(res, "Thread mutex failed!\n");
+    }
+}
+
+/* Bezczynny wątek przez chwilę czeka na pracę aktywnie, potem oddając procesor,
+ * a dopiero na końcu zasypia. Dzięki temu przy częstej wymianie komunikatów
+ * wątki nie zasypiają i nie są budzone przy każdej wiadomości. Zwraca true,
+ * jeżeli w międzyczasie pojawiła się praca. */
+bool tpool_spin(tpool_t *tp) {
+    for (size_t i = 0; i < tp->idle_spins; i++) {
+        if (atomic_load_explicit(&tp->pending, memory_order_relaxed) > 0) {
+            return true;
         }
 
-        queue_add(tp->work_q, (void *) actor_state->id);
+        cpu_relax();
+    }
 
-        if ((res = pthread_cond_signal(&tp->work_cond)) != 0) {
-            syserr(res, "Thread signal failed!\n");
+    for (size_t i = 0; i < tp->idle_yields; i++) {
+        if (atomic_load_explicit(&tp->pending, memory_order_relaxed) > 0) {
+            return true;
         }
 
-        if ((res = pthread_mutex_unlock(&tp->mutex)) != 0) {
-            syserr(res, "Actor mutex failed!\n");
-        }
+        sched_yield();
     }
 
-    act_unlock_mutex(actor_id);
+    return false;
 }
 
-/* Zwraca liczbę wiadomości, które są zakolejkowane u aktora o danym id */
-size_t how_many_messages(actor_id_t actor_id) {
-    actor_state_t *actor_state = vector_get(actors, actor_id);
+/* Usypia wątek na jego zmiennej warunkowej, odkładając go na stos uśpionych.
+ * Wymaga posiadania mutexa puli. */
+void tpool_park(tpool_t *tp, worker_arg_t *worker) {
+    int res;
 
-    return queue_size(actor_state->q);
-}
+    if (!worker->parked) {
+        worker->parked = true;
+        tp->parked[tp->parked_num++] = worker->index;
+    }
 
-void execute_command(actor_id_t actor_id) {
-    actor_state_t *actorState = vector_get(actors, actor_id);
+    counter_add(&worker->counters.parks, 1);
 
-    message_t *msg = (message_t *)queue_pop(actorState->q);
-    actor_id_t new_actor;
+    if ((res = pthread_cond_wait(&worker->park_cond, &tp->mutex)) != 0) {
+        syserr(res, "Thread conditional wait failed!\n");
+    }
+}
 
-    switch (msg->message_type) {
-        case MSG_SPAWN :
-            if (!signaled) {
-                new_actor = add_act(actors, (role_t *) msg->data);
+// Zdejmuje wątek ze stosu uśpionych, jeżeli nadal na nim jest. Wymaga mutexa puli.
+void tpool_unpark(tpool_t *tp, worker_arg_t *worker) {
+    if (worker->parked) {
+        for (size_t i = 0; i < tp->parked_num; i++) {
+            if (tp->parked[i] == worker->index) {
+                tp->parked[i] = tp->parked[--tp->parked_num];
+                break;
+            }
+        }
 
-                message_t hello_message = {.message_type = MSG_HELLO,
-                        .nbytes = sizeof(actor_id_t),
-                        .data = (void *) actorState->id};
+        worker->parked = false;
+    }
 
-                send_message(new_actor, hello_message);
-            }
-            break;
-        case MSG_GODIE :
-            actor_turn_dead(actors, actor_id);
-            break;
-        default:
-            actorState->role->prompts[msg->message_type](&actorState->stateptr, msg->nbytes, msg->data);
-            break;
+    if (worker->notified) {
+        counter_add(&worker->counters.wakeups, 1);
     }
 
-    free(msg);
+    worker->notified = false;
 }
 
-// Wykonuje 'how_many' komunikatow z kolejki aktora o id 'actor_id'
-void execute_commands(actor_id_t actor_id, size_t how_many) {
-    for (size_t i = 0; i < how_many; i++){
-        execute_command(actor_id);
-    }
+// Blokująca obsługa wiadomości, zlecona puli blokującej.
+typedef struct offload_job {
+    cacti_system_t *system;
+    actor_id_t actor_id;
+    envelope_t *env;
+} offload_job_t;
+
+/* Przekazuje obsługę wiadomości 'env' przez aktora do puli blokującej. Aktor
+ * pozostaje oznaczony jako przetwarzany, więc do zakończenia obsługi żaden
+ * wątek go nie weźmie. */
+void tpool_offload(tpool_t *tp, actor_id_t act_id, envelope_t *env) {
+    offload_job_t *job = safe_malloc(sizeof (offload_job_t));
+
+    job->system = tp->system;
+    job->actor_id = act_id;
+    job->env = env;
+
+    atomic_fetch_add(&tp->offloaded, 1);
+    blocking_pool_submit(tp->blocking, job);
+}
+
+// Kończy blokującą obsługę aktora i budzi wątek, który może czekać na koniec systemu.
+void tpool_offload_done(tpool_t *tp) {
+    int res;
+
+    if ((res = pthread_mutex_lock(&tp->mutex)) != 0) {
+        syserr(res, "Thread mutex failed!\n");
+    }
+
+    atomic_fetch_sub(&tp->offloaded, 1);
+    tpool_wake_one_locked(tp);
+
+    if ((res = pthread_mutex_unlock(&tp->mutex)) != 0) {
+        syserr(res, "Thread mutex failed!\n");
+    }
+}
+
+/* Wstawia aktora do kolejki wątku 'preferred' (jeżeli jest to numer wątku
+ * puli), w.p.p. do kolejki wątku wywołującego (lub, dla wątków spoza puli,
+ * do kolejnej kolejki w kolejności cyklicznej) i budzi jeden uśpiony wątek,
+ * o ile taki istnieje. */
+void tpool_push(tpool_t *tp, actor_id_t act_id, long preferred) {
+    size_t target;
+
+    if (preferred >= 0 && (size_t) preferred < tp->threads_num) {
+        target = (size_t) preferred;
+    }
+    else if (worker_index >= 0) {
+        target = (size_t) worker_index;
+    }
+    else {
+        target = atomic_fetch_add(&tp->next_q, 1) % tp->threads_num;
+    }
+
+    queue_add(tp->work_qs[target], (void *) act_id);
+    atomic_fetch_add(&tp->pending, 1);
+
+    tpool_wake_one(tp);
+}
+
+void *tpool_worker(void *arg) {
+    int res;
+    worker_arg_t *worker = arg;
+    tpool_t *tp = worker->tp;
+    cacti_system_t *sys = tp->system;
+    actor_id_t act_id;
+
+    /* Wątek mógł przyjść z pamięci podręcznej po innym systemie, więc przed
+     * pierwszą obsługą nie może widzieć jego aktora. */
+    worker_index = (long) worker->index;
+    current_system = sys;
+    self_actor_id = 0;
+
+    if (sys->trace != NULL) {
+        trace_register_worker(sys->trace, worker->index);
+    }
+
+    if ((res = pthread_mutex_lock(&sys->mutex)) != 0) {
+        syserr(res, "Thread 'SYSTEM' mutex failed!\n");
+    }
+
+    if ((res = pthread_mutex_unlock(&sys->mutex)) != 0) {
+        syserr(res, "Thread 'SYSTEM' mutex failed!\n");
+    }
+
+    while (1) {
+        /* W pętli nieskończonej wątek najpierw szuka pracy we własnej kolejce, a potem
+         * w kolejkach pozostałych wątków. Jeżeli znajdzie aktora, to przetwarza komunikaty
+         * z jego kolejki, co najwyżej tyle, ile wynosi budżet aktora. Jeżeli pracy nie ma,
+         * a system dalej dziala, to chwilę czekamy aktywnie, a potem wieszamy się na
+         * zmiennej warunkowej. Ostatni watek ktory skonczy pracę iniciuje sprzątanie
+         * systemu, przy czym nie rusza struktury puli wątków. */
+        if (tpool_take_work(tp, worker, &act_id)) {
+            size_t budget = actor_budget(sys, act_id);
+            size_t executed;
+            bool preempted;
+            unsigned long long start = sys->trace != NULL ? now_ns() : 0;
+
+            self_actor_id = act_id;
+
+            executed = execute_commands(sys, act_id, budget, &preempted);
+
+            if (start != 0) {
+                trace_complete(sys->trace, TRACE_ACTIVATION, act_id, (long) executed, start);
+            }
+
+            counter_add(&worker->counters.activations, 1);
+            counter_add(&worker->counters.messages, executed);
+            counter_max(&worker->counters.max_batch, executed);
+
+            if (preempted) {
+                counter_add(&worker->counters.preemptions, 1);
+            }
+
+            continue;
+        }
+
+        if (sys->alive && !signaled && tpool_spin(tp)) {
+            continue;
+        }
+
+        if ((res = pthread_mutex_lock(&tp->mutex)) != 0) {
+            syserr(res, "Thread mutex failed!\n");
+        }
+
+        atomic_fetch_add(&tp->sleeping, 1);
+
+        unsigned long long idle_start = sys->trace != NULL ? now_ns() : 0;
+        unsigned long long parks = atomic_load_explicit(&worker->counters.parks, memory_order_relaxed);
+
+        while (atomic_load(&tp->pending) == 0 && tp->still_running && !worker->notified
+               && ((sys->alive && !signaled) || atomic_load(&tp->offloaded) > 0)) {
+            tpool_park(tp, worker);
+        }
+
+        if (idle_start != 0 && atomic_load_explicit(&worker->counters.parks, memory_order_relaxed) != parks) {
+            trace_complete(sys->trace, TRACE_IDLE, -1, worker->notified, idle_start);
+        }
+
+        tpool_unpark(tp, worker);
+        atomic_fetch_sub(&tp->sleeping, 1);
+
+        if ((!sys->alive || signaled) && atomic_load(&tp->pending) == 0
+            && atomic_load(&tp->offloaded) == 0) {
+            tp->still_running = false;
+            tpool_wake_all_locked(tp);
+
+            break;
+        }
+
+        if ((res = pthread_mutex_unlock(&tp->mutex)) != 0) {
+            syserr(res, "Thread mutex failed!\n");
+        }
+    }
+
+    tp->active_threads_num--;
+
+    if (tp->active_threads_num == 0) {
+        if ((res = pthread_mutex_unlock(&tp->mutex)) != 0) {
+            syserr(res, "Thread mutex failed!\n");
+        }
+
+        destroy_actor_system(sys);
+    }
+    else {
+        if ((res = pthread_mutex_unlock(&tp->mutex)) != 0) {
+            syserr(res, "Thread mutex failed!\n");
+        }
+    }
+
+    envelope_pool_flush();
+
+    // Wątek wraca do pamięci podręcznej wątków i może trafić do innego systemu.
+    worker_index = -1;
+    current_system = NULL;
+    self_actor_id = 0;
+
+    return NULL;
+}
+
+tpool_t *tpool_create(cacti_system_t *sys, size_t active_threads_num, const actor_system_config_t *config) {
+    tpool_t *new_tp = safe_malloc(sizeof (tpool_t));
+    cpu_set_t cpus;
+    int res;
+
+    if (!new_tp) {
+        exit(1);
+    }
+
+    new_tp->work_qs = safe_malloc(sizeof(generic_queue *) * active_threads_num);
+
+    for (size_t i = 0; i < active_threads_num; i++) {
+        new_tp->work_qs[i] = create_queue(NULL);
+
+        if (!new_tp->work_qs[i]) {
+            fatal("Thread pool initialization failure!\n");
+        }
+    }
+
+    new_tp->active_threads_num = active_threads_num;
+    new_tp->threads_num = active_threads_num;
+    new_tp->still_running = true;
+    new_tp->system = sys;
+    new_tp->placement = config->affinity != AFFINITY_NONE;
+    new_tp->idle_spins = config->idle_spins == 0 ? IDLE_SPINS : config->idle_spins;
+    new_tp->idle_yields = config->idle_yields == 0 ? IDLE_YIELDS : config->idle_yields;
+    new_tp->idle_spins = new_tp->idle_spins == IDLE_NONE ? 0 : new_tp->idle_spins;
+    new_tp->idle_yields = new_tp->idle_yields == IDLE_NONE ? 0 : new_tp->idle_yields;
+    new_tp->parked = safe_malloc(sizeof (size_t) * active_threads_num);
+    new_tp->parked_num = 0;
+    atomic_init(&new_tp->pending, 0);
+    atomic_init(&new_tp->sleeping, 0);
+    atomic_init(&new_tp->next_q, 0);
+    atomic_init(&new_tp->offloaded, 0);
+    new_tp->blocking = blocking_pool_create(config->blocking_threads == 0 ? BLOCKING_THREADS : config->blocking_threads,
+                                            run_offloaded, envelope_pool_flush);
+    new_tp->threads = safe_malloc(sizeof(thread_ticket_t) * active_threads_num);
+    new_tp->workers = aligned_alloc(CACHE_LINE, sizeof(worker_arg_t) * active_threads_num);
+
+    if (new_tp->workers == NULL) {
+        fatal("Thread pool initialization failure!\n");
+    }
+
+    if ((res = pthread_mutex_init(&new_tp->mutex, NULL)) != 0) {
+        syserr(res, "Thread pool mutex initalization failure!\n");
+    }
+
+    for (size_t i = 0; i < active_threads_num; i++) {
+        new_tp->workers[i].parked = false;
+        new_tp->workers[i].notified = false;
+
+        if ((res = pthread_cond_init(&new_tp->workers[i].park_cond, NULL)) != 0) {
+            syserr(res, "Thread pool conditional initialization failure!\n");
+        }
+    }
+
+    // Wątki bierzemy z pamięci podręcznej, więc kolejne systemy ich nie tworzą.
+    for (size_t i = 0; i < active_threads_num; i++) {
+        new_tp->workers[i].tp = new_tp;
+        new_tp->workers[i].index = i;
+        worker_counters_reset(&new_tp->workers[i].counters);
+
+        new_tp->threads[i] = thread_cache_run(tpool_worker, &new_tp->workers[i],
+                                              affinity_worker_set(i, config, &cpus) ? &cpus : NULL);
+    }
+
+    return new_tp;
+}
+
+void tpool_destroy(tpool_t *tp) {
+    int res;
+
+    if (tp != NULL) {
+        cacti_system_t *sys = tp->system;
+
+        if (tp->threads != NULL) {
+            for (size_t i = 0; i < tp->threads_num; i++) {
+                thread_cache_wait(tp->threads[i]);
+            }
+
+            free(tp->threads);
+        }
+
+        // Wątki puli kończą pracę dopiero, gdy nie ma już zleconych blokujących obsług.
+        blocking_pool_destroy(tp->blocking);
+
+        if (tp->work_qs != NULL) {
+            for (size_t i = 0; i < tp->threads_num; i++) {
+                free_queue(tp->work_qs[i]);
+            }
+
+            free(tp->work_qs);
+        }
+
+        for (size_t i = 0; i < tp->threads_num; i++) {
+            if ((res = pthread_cond_destroy(&tp->workers[i].park_cond)) != 0) {
+                syserr(res, "Destroying thread pool cond failed!\n");
+            }
+        }
+
+        // Zachowujemy liczniki wątków, żeby statystyki były dostępne po zakończeniu systemu.
+        free(sys->retired_stats);
+        sys->retired_stats = safe_malloc(sizeof (worker_stats_t) * tp->threads_num);
+        sys->retired_stats_num = tp->threads_num;
+
+        for (size_t i = 0; i < tp->threads_num; i++) {
+            worker_counters_read(&tp->workers[i].counters, &sys->retired_stats[i]);
+        }
+
+        free(tp->workers);
+        free(tp->parked);
+
+        if ((res = pthread_mutex_destroy(&tp->mutex)) != 0) {
+            syserr(res, "Destroying thread pool mutex failed!\n");
+        }
+
+        free(tp);
+    }
+}
+
+//----------------- END OF THREAD POOL IMPLEMENTATION --------------------------
+
+
+/* Obsługa SIGINT tylko ustawia flagę i podnosi semafor, bo z procedury obsługi
+ * sygnału nie wolno brać mutexów. Pule budzi dopiero osobny wątek. */
+static sem_t signal_sem;
+static pthread_once_t signal_watcher_once = PTHREAD_ONCE_INIT;
+
+void catch_signal() {
+    int saved_errno = errno;
+
+    signaled = true;
+    sem_post(&signal_sem);
+
+    errno = saved_errno;
+}
+
+// Po każdym SIGINT budzi pule wszystkich działających systemów.
+void *signal_watcher(void *arg) {
+    sigset_t all;
+    int res;
+
+    (void) arg;
+
+    sigfillset(&all);
+    pthread_sigmask(SIG_BLOCK, &all, NULL);
+
+    while (true) {
+        if (sem_wait(&signal_sem) != 0) {
+            continue; // EINTR
+        }
+
+        if ((res = pthread_mutex_lock(&systems_mutex)) != 0) {
+            syserr(res, "Systems mutex failed!\n");
+        }
+
+        for (cacti_system_t *sys = systems; sys != NULL; sys = sys->next) {
+            if ((res = pthread_mutex_lock(&sys->tp->mutex)) != 0) {
+                syserr(res, "Thread pool mutex failed!\n");
+            }
+
+            tpool_wake_all_locked(sys->tp);
+
+            if ((res = pthread_mutex_unlock(&sys->tp->mutex)) != 0) {
+                syserr(res, "Thread pool mutex failed!\n");
+            }
+        }
+
+        if ((res = pthread_mutex_unlock(&systems_mutex)) != 0) {
+            syserr(res, "Systems mutex failed!\n");
+        }
+    }
+
+    return NULL;
+}
+
+/* Wątek obserwujący sygnały powstaje raz, przy pierwszym systemie, i do końca
+ * procesu czeka na semaforze. */
+void start_signal_watcher() {
+    pthread_t thread;
+    int res;
+
+    if (sem_init(&signal_sem, 0, 0) != 0) {
+        fatal("Semaphore init failed!\n");
+    }
+
+    if ((res = pthread_create(&thread, NULL, signal_watcher, NULL)) != 0) {
+        syserr(res, "Signal watcher create failed!\n");
+    }
+
+    if ((res = pthread_detach(thread)) != 0) {
+        syserr(res, "Signal watcher detach failed!\n");
+    }
+}
+
+
+/* Zwalnia pamięć odpowiedzalną za system aktorów, bez niszczenia struktury puli wątków */
+void destroy_actor_system(cacti_system_t *sys) {
+    int res;
+
+    // Zegary mogą wysyłać wiadomości, więc zatrzymujemy je przed zniszczeniem aktorów.
+    timer_shutdown(sys->timers);
+
+    // Nowi nadawcy spoza systemu zobaczą koniec systemu, a trwający muszą skończyć.
+    sys->alive = false;
+
+    while (atomic_load(&sys->outside_senders) > 0) {
+        sched_yield();
+    }
+
+    if ((res = pthread_mutex_lock(&sys->mutex)) != 0) {
+        syserr(res, "Destroy system mutex failed!\n");
+    }
+
+    destroy_vector(sys->actors);
+    sys->actors = NULL;
+    if ((res =  pthread_cond_signal(&sys->join)) != 0) {
+        syserr(res, "Destroy system signal failed!\n");
+    }
+
+    if ((res = pthread_mutex_unlock(&sys->mutex)) != 0) {
+        syserr(res, "Destroy system mutex failed!\n");
+    }
+}
+
+/* Jezeli jest to mozliwe, dodaje aktora do kolejki, aby kolejny watek
+ * mogl zaczac na nim pracowac, dodatkowo budzi jeden z uśpionych wątków */
+void try_to_add_actor(actor_state_t *actor_state, tpool_t *tp) {
+    /* Flagę ustawia tylko ten, kto zmienił ją z false na true, więc aktor
+     * trafia na kolejkę co najwyżej raz. Zdjęcie flagi w actor_end_work
+     * poprzedza ponowne sprawdzenie skrzynki, więc żadna wiadomość nie utknie. */
+    if (!mailbox_is_empty(tp->system->actors, actor_state) &&
+        !(atomic_fetch_or(&actor_state->state, ACTOR_SCHEDULED) & ACTOR_SCHEDULED)) {
+        long preferred = tp->placement ? atomic_load_explicit(&actor_state->home_worker,
+                                                              memory_order_relaxed) : -1;
+
+        tpool_push(tp, actor_state->id, preferred);
+
+        if (tp->system->trace != NULL) {
+            trace_instant(tp->system->trace, TRACE_SCHEDULE, actor_state->id, worker_index);
+        }
+    }
+}
+
+/* Zaznacza, że aktor może już trafić spowrotem na kolejkę i dodaje go do niej,
+ * jeżeli w międzyczasie dostał wiadomości. Martwego aktora z pustą skrzynką
+ * zwalnia, więc potem nie wolno już używać jego stanu. */
+void actor_end_work(cacti_system_t *sys, actor_state_t *actor_state) {
+    unsigned state = atomic_fetch_and(&actor_state->state, ~ACTOR_SCHEDULED) & ~ACTOR_SCHEDULED;
+
+    if (!mailbox_is_empty(sys->actors, actor_state)) {
+        try_to_add_actor(actor_state, sys->tp);
+    }
+    else if (state == ACTOR_DEAD) {
+        vector_reclaim(sys->actors, actor_state);
+    }
+}
+
+/* Oddaje odwołanie nadawcy wzięte w find_receiver. Ostatni nadawca martwego
+ * aktora, który nie jest już przetwarzany, zwalnia jego miejsce. */
+void actor_release(cacti_system_t *sys, actor_state_t *actor_state) {
+    if (atomic_fetch_sub(&actor_state->state, ACTOR_REF) - ACTOR_REF == ACTOR_DEAD) {
+        vector_reclaim(sys->actors, actor_state);
+    }
+
+    if (current_system != sys) {
+        atomic_fetch_sub(&sys->outside_senders, 1);
+    }
+}
+
+/* Zwraca budżet przetwarzania aktora o danym id, czyli budżet jego roli,
+ * a jeżeli rola go nie ustala, to domyślny budżet systemu. */
+size_t actor_budget(cacti_system_t *sys, actor_id_t actor_id) {
+    actor_state_t *actor_state = vector_get(sys->actors, actor_id);
+
+    if (actor_state->role->budget != BUDGET_DEFAULT) {
+        return actor_state->role->budget;
+    }
+
+    return atomic_load_explicit(&sys->budget, memory_order_relaxed);
+}
+
+// Zgłasza zbyt długą obsługę komunikatu.
+void report_slow_handler(cacti_system_t *sys, actor_id_t actor, message_type_t message_type, unsigned long long ns) {
+    if (sys->slow_handler != NULL) {
+        sys->slow_handler(actor, message_type, ns);
+    }
+    else {
+        fprintf(stderr, "cacti: slow handler: actor %ld, message %ld, %llu us\n",
+                actor, message_type, ns / 1000);
+    }
+}
+
+/* Wywołuje obsługę komunikatu 'msg' przez aktora. Czas obsługi jest mierzony
+ * tylko wtedy, gdy włączono statystyki, histogramy lub próg wolnych obsług. */
+void dispatch_message(cacti_system_t *sys, actor_state_t *act, message_t *msg) {
+    act_t prompt = act->role->prompts[msg->message_type];
+
+    if (!sys->stats && sys->latency == NULL && sys->slow_handler_ns == 0) {
+        prompt(&act->stateptr, msg->nbytes, msg->data);
+        return;
+    }
+
+    unsigned long long start = now_ns();
+
+    prompt(&act->stateptr, msg->nbytes, msg->data);
+
+    unsigned long long elapsed = now_ns() - start;
+    bool slow = sys->slow_handler_ns != 0 && elapsed >= sys->slow_handler_ns;
+    actor_metrics_t *metrics = vector_metrics(sys->actors, act->id);
+
+    if (sys->stats) {
+        // Aktora przetwarza naraz tylko jeden wątek, więc wystarczy zwykły zapis.
+        counter_add(&metrics->handler_ns, elapsed);
+    }
+
+    if (metrics != NULL && metrics->latency != NULL) {
+        latency_record(&metrics->latency[msg->message_type], elapsed, slow);
+    }
+
+    if (slow) {
+        report_slow_handler(sys, act->id, msg->message_type, elapsed);
+    }
+}
+
+/* Zlicza wiadomości odrzucone z powodu pełnej skrzynki aktora. Licznik
+ * aktora jest prowadzony tylko przy włączonych statystykach. */
+void actor_count_dropped(cacti_system_t *sys, actor_state_t *act, size_t how_many) {
+    if (how_many > 0) {
+        actor_metrics_t *metrics = vector_metrics(sys->actors, act->id);
+
+        if (metrics != NULL) {
+            atomic_fetch_add_explicit(&metrics->dropped, how_many, memory_order_relaxed);
+        }
+
+        atomic_fetch_add_explicit(&sys->dropped, how_many, memory_order_relaxed);
+    }
+}
+
+// Usuwa najstarsze wiadomości z kolejki 'q' aktora, dopóki jest ich więcej niż 'limit'.
+void trim_lane(cacti_system_t *sys, actor_state_t *act, mpsc_queue *q, size_t limit) {
+    while (mpsc_size(q) > limit) {
+        envelope_drop((envelope_t *) mpsc_pop(q));
+        actor_count_dropped(sys, act, 1);
+    }
+}
+
+/* Przycina każdą kolejkę priorytetu aktora z zachowaniem OVERFLOW_DROP_OLDEST
+ * do limitu skrzynki. Może ją wywołać tylko wątek przetwarzający aktora. */
+void trim_mailbox(cacti_system_t *sys, actor_state_t *act) {
+    size_t limit = actor_limit(sys, act);
+    mpsc_queue *prio = atomic_load(&vector_lanes(sys->actors, act->id)->lanes);
+
+    if (limit == 0) {
+        return;
+    }
+
+    trim_lane(sys, act, &act->q, limit);
+
+    for (size_t i = 0; prio != NULL && i < PRIORITY_LEVELS - 1; i++) {
+        trim_lane(sys, act, &prio[i], limit);
+    }
+}
+
+typedef enum command_result {
+    COMMAND_EMPTY,     // Kolejka aktora była pusta.
+    COMMAND_EXECUTED,
+    COMMAND_OFFLOADED  // Komunikat przekazano do puli blokującej.
+} command_result_t;
+
+// Sprawdza, czy rola oznaczyła obsługę komunikatu jako blokującą.
+bool is_blocking(role_t *role, message_type_t message_type) {
+    return role->blocking != NULL && role->blocking[message_type];
+}
+
+/* Wykonuje następny komunikat aktora o id 'actor_id' (zob. mailbox_pop). Blokujące
+ * obsługi są przekazywane do puli blokującej, która sama kończy pracę z aktorem. */
+command_result_t execute_command(cacti_system_t *sys, actor_id_t actor_id) {
+    actor_state_t *actorState = vector_get(sys->actors, actor_id);
+    bool consumed = true; // Czy dane wiadomości przejęła obsługa lub system.
+
+    actor_id_t new_actor;
+
+    if (actor_overflow(sys, actorState) == OVERFLOW_DROP_OLDEST) {
+        trim_mailbox(sys, actorState);
+    }
+
+    envelope_t *env = (envelope_t *) mailbox_pop(sys->actors, actorState, actor_id);
+
+    if (env == NULL) {
+        return COMMAND_EMPTY;
+    }
+
+    message_t *msg = &env->message;
+
+    switch (msg->message_type) {
+        case MSG_SPAWN :
+            if (!signaled) {
+                new_actor = add_act(sys->actors, (role_t *) msg->data);
+
+                message_t hello_message = {.message_type = MSG_HELLO,
+                        .nbytes = sizeof(actor_id_t),
+                        .data = (void *) actorState->id};
+
+                cacti_send_message(sys, new_actor, hello_message);
+
+                if (sys->trace != NULL) {
+                    trace_instant(sys->trace, TRACE_SPAWN, actor_id, new_actor);
+                }
+            }
+            else {
+                consumed = false;
+            }
+            break;
+        case MSG_GODIE :
+            if (sys->trace != NULL) {
+                trace_instant(sys->trace, TRACE_GODIE, actor_id, 0);
+            }
+
+            if (actor_turn_dead(sys->actors, actor_id)) {
+                sys->alive = false;
+            }
+
+            consumed = false;
+            break;
+        default:
+            if (is_blocking(actorState->role, msg->message_type)) {
+                tpool_offload(sys->tp, actor_id, env);
+
+                return COMMAND_OFFLOADED;
+            }
+
+            dispatch_message(sys, actorState, msg);
+            break;
+    }
+
+    if (consumed) {
+        envelope_free(env);
+    }
+    else {
+        envelope_drop(env);
+    }
+
+    return COMMAND_EXECUTED;
+}
+
+/* Wykonuje co najwyżej 'budget' komunikatow z kolejki aktora o id 'actor_id',
+ * wliczając te, które dotrą w trakcie, i kończy pracę z aktorem. Zwraca liczbę
+ * wykonanych komunikatów, a pod 'preempted' to, czy budżet przerwał przetwarzanie.
+ * Przetwarzanie kończy się wcześniej, gdy obsługa komunikatu trafi do puli blokującej. */
+size_t execute_commands(cacti_system_t *sys, actor_id_t actor_id, size_t budget, bool *preempted) {
+    actor_state_t *act = vector_get(sys->actors, actor_id);
+    size_t executed = 0;
+    command_result_t result = COMMAND_EXECUTED;
+
+    atomic_store_explicit(&act->home_worker, (int) worker_index, memory_order_relaxed);
+    *preempted = false;
+
+    while (executed < budget && (result = execute_command(sys, actor_id)) != COMMAND_EMPTY) {
+        executed++;
+
+        if (result == COMMAND_OFFLOADED) {
+            return executed;
+        }
+    }
+
+    *preempted = executed == budget && !mailbox_is_empty(sys->actors, act);
+    actor_end_work(sys, act);
+
+    return executed;
+}
+
+/* Wykonuje w wątku puli blokującej obsługę wiadomości przekazanej przez
+ * execute_command, po czym oddaje aktora z powrotem do puli głównej. */
+void run_offloaded(void *job) {
+    offload_job_t *offload = job;
+    cacti_system_t *sys = offload->system;
+    actor_id_t actor_id = offload->actor_id;
+    actor_state_t *act = vector_get(sys->actors, actor_id);
+    envelope_t *env = offload->env;
+    unsigned long long start = sys->trace != NULL ? now_ns() : 0;
+
+    free(offload);
+    self_actor_id = actor_id;
+    current_system = sys;
+
+    dispatch_message(sys, act, &env->message);
+    envelope_free(env);
+
+    if (start != 0) {
+        trace_complete(sys->trace, TRACE_ACTIVATION, actor_id, 1, start);
+    }
+
+    actor_end_work(sys, act);
+    tpool_offload_done(sys->tp);
+}
+
+/* Zlicza wiadomości dodane do skrzynki aktora i aktualizuje największą
+ * zaobserwowaną głębokość skrzynki. Nic nie robi przy wyłączonych statystykach. */
+void actor_count_enqueued(cacti_system_t *sys, actor_state_t *act, size_t how_many) {
+    if (!sys->stats || how_many == 0) {
+        return;
+    }
+
+    actor_metrics_t *metrics = vector_metrics(sys->actors, act->id);
+    unsigned long long depth = mailbox_size(sys->actors, act);
+    unsigned long long max_depth = atomic_load_explicit(&metrics->max_depth, memory_order_relaxed);
+
+    atomic_fetch_add_explicit(&metrics->enqueued, how_many, memory_order_relaxed);
+
+    while (max_depth < depth &&
+           !atomic_compare_exchange_weak_explicit(&metrics->max_depth, &max_depth, depth,
+                                                  memory_order_relaxed, memory_order_relaxed)) {
+    }
+}
+
+// Zwraca, ile czekać na miejsce w skrzynce aktora przy zwykłej wysyłce.
+unsigned long long overflow_timeout(cacti_system_t *sys, actor_state_t *act) {
+    return actor_overflow(sys, act) == OVERFLOW_BLOCK ? sys->send_timeout_us : 0;
+}
+
+/* Czy czekanie na miejsce w skrzynce aktora nigdy by się nie skończyło:
+ * aktor wysyła sam do siebie (jego skrzynki nikt nie opróżni, dopóki trwa
+ * obsługa), albo czeka jedyny wątek puli, który mógłby ją opróżnić. */
+bool wait_would_deadlock(cacti_system_t *sys, actor_state_t *act) {
+    if (current_system != sys) {
+        return false;
+    }
+
+    return atomic_load(&act->id) == self_actor_id || (worker_index >= 0 && sys->tp->threads_num == 1);
+}
+
+/* Ponawia dodanie węzła do pełnej skrzynki, czekając coraz dłużej, co najwyżej
+ * 'timeout_us' mikrosekund. Zwraca 0, MAILBOX_FULL po upływie czasu lub od
+ * razu, gdy czekanie nie może się skończyć (zob. wait_would_deadlock), lub -1,
+ * gdy aktor przestał przyjmować wiadomości. */
+int wait_for_space(cacti_system_t *sys, actor_state_t *act, mpsc_queue *q, mpsc_node_t *node,
+                   unsigned long long timeout_us) {
+    if (wait_would_deadlock(sys, act)) {
+        return MAILBOX_FULL;
+    }
+
+    unsigned long long deadline = timeout_us == TIMEOUT_INFINITE ? 0 : now_ns() + timeout_us * 1000ull;
+    struct timespec pause = {.tv_sec = 0, .tv_nsec = 1000};
+
+    for (size_t attempt = 0;; attempt++) {
+        if (actor_is_dead(act) || signaled) {
+            return -1;
+        }
+
+        if (deadline != 0 && now_ns() >= deadline) {
+            return MAILBOX_FULL;
+        }
+
+        if (attempt < IDLE_YIELDS) {
+            sched_yield();
+        }
+        else {
+            nanosleep(&pause, NULL);
+            pause.tv_nsec = pause.tv_nsec < 1000000 ? pause.tv_nsec * 2 : pause.tv_nsec;
+        }
+
+        if (mpsc_add(q, node, mailbox_limit(sys, act)) == 0) {
+            return 0;
+        }
+    }
+}
+
+/* Sprawdza, czy do aktora o podanym id można wysłać wiadomość. Zwraca 0
+ * i zapisuje stan aktora pod 'receiver', a w.p.p. kod błędu. Przy sukcesie
+ * nadawca trzyma odwołanie do aktora, które oddaje przez actor_release,
+ * więc do tego czasu miejsce aktora nie zostanie użyte ponownie. */
+int find_receiver(cacti_system_t *sys, actor_id_t actor, actor_state_t **receiver) {
+    actor_state_t *act;
+    bool outside = sys != NULL && current_system != sys;
+
+    /* Wątki systemu kończą pracę przed zniszczeniem aktorów, ale wątek spoza
+     * systemu może wciąż wysyłać, gdy system się kończy. Liczymy go przed
+     * sprawdzeniem 'alive', a destroy_actor_system czeka, aż skończy. */
+    if (outside) {
+        atomic_fetch_add(&sys->outside_senders, 1);
+    }
+
+    if (sys == NULL || !sys->alive) {
+        if (outside) {
+            atomic_fetch_sub(&sys->outside_senders, 1);
+        }
+
+        return NO_ACTIVE_SYSTEM;
+    }
+    else if ((act = vector_get(sys->actors, actor)) == NULL) {
+        if (outside) {
+            atomic_fetch_sub(&sys->outside_senders, 1);
+        }
+
+        return -2;
+    }
+    else {
+        unsigned state = atomic_fetch_add(&act->state, ACTOR_REF);
+        actor_id_t id = atomic_load(&act->id);
+
+        // Inny numer w tym miejscu oznacza zmarłego poprzednika, lub numer jeszcze nienadany.
+        if (id != actor || (state & ACTOR_DEAD) || signaled) {
+            actor_release(sys, act);
+
+            return id < actor ? -2 : -1;
+        }
+
+        *receiver = act;
+
+        return 0;
+    }
+}
+
+/* Wstawia kopertę do skrzynki aktora o danym priorytecie i w razie potrzeby
+ * dodaje go do kolejki puli wątków. Komunikaty sterujące zawsze trafiają na
+ * stos sterujący (zob. control_limit). Przy pełnej skrzynce czeka na miejsce
+ * co najwyżej 'timeout_us', a koperta, która się nie zmieściła, jest odrzucana
+ * razem z danymi na własność. */
+int deliver_envelope(cacti_system_t *sys, actor_state_t *act, envelope_t *env, int priority,
+                     unsigned long long timeout_us) {
+    mpsc_queue *q;
+    int result = 0;
+
+    if (is_control_message(env->message.message_type)) {
+        if (mailbox_push_control(sys->actors, act, &env->node,
+                                 control_limit(sys, act, env->message.message_type)) == 0) {
+            actor_count_enqueued(sys, act, 1);
+        }
+        else {
+            envelope_drop(env);
+            actor_count_dropped(sys, act, 1);
+            result = MAILBOX_FULL;
+        }
+    }
+    else if (mpsc_add(q = mailbox_lane(sys->actors, act, priority), &env->node, mailbox_limit(sys, act)) == -1 &&
+        (timeout_us == 0 || (result = wait_for_space(sys, act, q, &env->node, timeout_us)) != 0)) {
+        envelope_drop(env);
+        actor_count_dropped(sys, act, 1);
+        result = result == 0 ? MAILBOX_FULL : result;
+    }
+    else {
+        actor_count_enqueued(sys, act, 1);
+    }
+
+    try_to_add_actor(act, sys->tp);
+    actor_release(sys, act);
+
+    return result;
+}
+
+// Zwalnia dane wiadomości na własność, której nie udało się wysłać.
+void message_drop(const message_t *message) {
+    if (message->destroy != NULL) {
+        message->destroy(message->data);
+    }
+}
+
+/* Jump consistent hash (Lamping, Veach): numer z [0, 'n'), który przy zmianie
+ * 'n' zmienia się tylko dla części kluczy, bez żadnej tablicy punktów. */
+size_t jump_hash(unsigned long long key, size_t n) {
+    long long bucket = -1;
+    long long next = 0;
+
+    while (next < (long long) n) {
+        bucket = next;
+        key = key * 2862933555777941757ull + 1;
+        next = (long long) ((double) (bucket + 1) * ((double) (1ll << 31) / (double) ((key >> 33) + 1)));
+    }
+
+    return (size_t) bucket;
+}
+
+/* Zwraca klucz wiadomości dla ROUTER_CONSISTENT_HASH. Bez funkcji klucza jest
+ * nim wskaźnik 'data', a przy 'by_value' (dane kopiowane do koperty, których
+ * adres jest przypadkowy) skrót FNV-1a zawartości danych. */
+unsigned long long router_key(router_t *router, const message_t *message, bool by_value) {
+    unsigned long long key = 14695981039346656037ull;
+
+    if (router->key != NULL) {
+        return router->key(message);
+    }
+
+    if (!by_value) {
+        return (unsigned long long) (uintptr_t) message->data;
+    }
+
+    for (size_t i = 0; i < message->nbytes; i++) {
+        key = (key ^ ((const unsigned char *) message->data)[i]) * 1099511628211ull;
+    }
+
+    return key;
+}
+
+// Wybiera aktora puli routera, do którego trafi wiadomość.
+actor_id_t router_pick(cacti_system_t *sys, router_t *router, const message_t *message, bool by_value) {
+    size_t start;
+    size_t best;
+    size_t best_depth = (size_t) -1;
+
+    switch (router->strategy) {
+        case ROUTER_SMALLEST_MAILBOX:
+            // Przy równych skrzynkach zaczynamy od kolejnego aktora, żeby nie wybierać stale pierwszego.
+            start = atomic_fetch_add_explicit(&router->next, 1, memory_order_relaxed) % router->size;
+            best = start;
+
+            for (size_t i = 0; i < router->size && best_depth > 0; i++) {
+                size_t index = (start + i) % router->size;
+                actor_state_t *routee = vector_get(sys->actors, router->routees[index]);
+                size_t depth = mailbox_size(sys->actors, routee);
+
+                if (depth < best_depth) {
+                    best = index;
+                    best_depth = depth;
+                }
+            }
+
+            return router->routees[best];
+        case ROUTER_CONSISTENT_HASH:
+            return router->routees[jump_hash(router_key(router, message, by_value), router->size)];
+        default:
+            return router->routees[atomic_fetch_add_explicit(&router->next, 1, memory_order_relaxed) % router->size];
+    }
+}
+
+/* Zamienia odwołanie do routera '*receiver' na odwołanie do wybranego aktora
+ * jego puli. Zwraca 0, lub kod błędu, gdy wybrany aktor nie przyjmuje wiadomości. */
+int route_message(cacti_system_t *sys, actor_state_t **receiver, const message_t *message, bool by_value) {
+    actor_state_t *router_state = *receiver;
+    int err = find_receiver(sys, router_pick(sys, (router_t *) router_state->role, message, by_value), receiver);
+
+    actor_release(sys, router_state);
+
+    return err;
+}
+
+/* Obsługuje MSG_GODIE wysłany do routera: przekazuje go każdemu aktorowi puli
+ * i uznaje router za martwego. Oddaje odwołanie nadawcy do routera. */
+int router_stop(cacti_system_t *sys, actor_state_t *router_state, const message_t *message) {
+    router_t *router = (router_t *) router_state->role;
+    actor_state_t *routee;
+
+    for (size_t i = 0; i < router->size; i++) {
+        if (find_receiver(sys, router->routees[i], &routee) == 0) {
+            envelope_t *env = envelope_alloc();
+
+            env->message = (message_t){.message_type = MSG_GODIE};
+            deliver_envelope(sys, routee, env, PRIORITY_NORMAL, 0);
+        }
+    }
+
+    message_drop(message);
+
+    bool last = actor_turn_dead(sys->actors, atomic_load(&router_state->id));
+
+    // Oddanie odwołania może zwolnić router, więc potem go już nie dotykamy.
+    actor_release(sys, router_state);
+
+    // Nadawca nie musi być wątkiem puli, więc koniec systemu zgłasza puli sam.
+    if (last) {
+        tpool_finish(sys->tp);
+    }
+
+    return 0;
+}
+
+// Zwraca system, którego dotyczą funkcje wywołane bez uchwytu.
+cacti_system_t *calling_system() {
+    return current_system != NULL ? current_system : atomic_load(&default_system);
+}
+
+/* Wysyła wiadomość, czekając na miejsce w skrzynce co najwyżej 'timeout_us', lub
+ * wg odbiorcy. Koperta bierze odwołanie do pożyczki 'loan', jeżeli nie jest NULL. */
+int send_loaned(cacti_system_t *sys, actor_id_t actor, message_t message, envelope_loan_t *loan,
+                int priority, bool by_receiver, unsigned long long timeout_us) {
+    actor_state_t *act;
+    int err;
+
+    if ((err = find_receiver(sys, actor, &act)) != 0) {
+        message_drop(&message);
+        return err;
+    }
+
+    if (is_router(act->role)) {
+        if (message.message_type == MSG_GODIE) {
+            return router_stop(sys, act, &message);
+        }
+
+        if ((err = route_message(sys, &act, &message, false)) != 0) {
+            message_drop(&message);
+            return err;
+        }
+    }
+
+    envelope_t *env = envelope_alloc();
+
+    env->message = message;
+
+    if (loan != NULL) {
+        envelope_lend(env, loan);
+    }
+
+    return deliver_envelope(sys, act, env, priority, by_receiver ? overflow_timeout(sys, act) : timeout_us);
+}
+
+int send_with_timeout(cacti_system_t *sys, actor_id_t actor, message_t message, int priority,
+                      bool by_receiver, unsigned long long timeout_us) {
+    return send_loaned(sys, actor, message, NULL, priority, by_receiver, timeout_us);
+}
+
+// Wątek zegarów nie może czekać na miejsce w skrzynce, bo wstrzymałby pozostałe zegary.
+int timer_fire(void *target, actor_id_t actor, message_t message, envelope_loan_t *loan) {
+    return send_loaned(target, actor, message, loan, PRIORITY_NORMAL, false, 0);
+}
+
+int cacti_send_message(cacti_system_t *system, actor_id_t actor, message_t message) {
+    return send_with_timeout(system, actor, message, PRIORITY_NORMAL, true, 0);
+}
+
+int cacti_send_message_prio(cacti_system_t *system, actor_id_t actor, message_t message, int priority) {
+    if (priority < PRIORITY_NORMAL || priority >= PRIORITY_LEVELS) {
+        return INVALID_PRIORITY;
+    }
+
+    return send_with_timeout(system, actor, message, priority, true, 0);
+}
+
+int send_message_prio(actor_id_t actor, message_t message, int priority) {
+    return cacti_send_message_prio(calling_system(), actor, message, priority);
+}
+
+int send_message(actor_id_t actor, message_t message) {
+    return send_with_timeout(calling_system(), actor, message, PRIORITY_NORMAL, true, 0);
+}
+
+int send_message_try(actor_id_t actor, message_t message) {
+    return send_with_timeout(calling_system(), actor, message, PRIORITY_NORMAL, false, 0);
+}
+
+int send_message_timed(actor_id_t actor, message_t message, unsigned long long timeout_us) {
+    return send_with_timeout(calling_system(), actor, message, PRIORITY_NORMAL, false, timeout_us);
+}
+
+int cacti_send_messages(cacti_system_t *system, actor_id_t actor, const message_t *messages, size_t n) {
+    cacti_system_t *sys = system;
+    actor_state_t *act;
+    envelope_t *first = NULL;
+    envelope_t *last = NULL;
+    mpsc_node_t *rest = NULL;
+    size_t chained = 0;
+    size_t accepted = 0;
+    int result = 0;
+    int err = 0;
+
+    if ((err = find_receiver(sys, actor, &act)) != 0) {
+        for (size_t i = 0; i < n; i++) {
+            message_drop(&messages[i]);
+        }
+
+        return err;
+    }
+
+    // Wiadomości do routera mogą trafić do różnych aktorów, więc wysyłamy je po jednej.
+    if (n == 0 || is_router(act->role)) {
+        actor_release(sys, act);
+
+        for (size_t i = 0; i < n; i++) {
+            if ((err = send_with_timeout(sys, actor, messages[i], PRIORITY_NORMAL, true, 0)) != 0 &&
+                result == 0) {
+                result = err;
+            }
+        }
+
+        return result;
+    }
+
+    /* Łączymy koperty w łańcuch, który trafi do skrzynki jedną operacją.
+     * Komunikaty sterujące idą osobno, na stos sterujący. */
+    for (size_t i = 0; i < n; i++) {
+        envelope_t *env = envelope_alloc();
+
+        env->message = messages[i];
+        atomic_store_explicit(&env->node.next, NULL, memory_order_relaxed);
+
+        if (is_control_message(env->message.message_type)) {
+            if (mailbox_push_control(sys->actors, act, &env->node,
+                                     control_limit(sys, act, env->message.message_type)) == 0) {
+                accepted++;
+            }
+            else {
+                envelope_drop(env);
+            }
+
+            continue;
+        }
+
+        chained++;
+
+        if (last == NULL) {
+            first = env;
+        }
+        else {
+            atomic_store_explicit(&last->node.next, &env->node, memory_order_relaxed);
+        }
+
+        last = env;
+    }
+
+    if (first != NULL) {
+        accepted += mpsc_add_chain(&act->q, &first->node, chained, mailbox_limit(sys, act), &rest);
+    }
+
+    unsigned long long timeout_us = overflow_timeout(sys, act);
+
+    // Resztę łańcucha, która się nie zmieściła, dodajemy po jednej, o ile wolno czekać.
+    while (rest != NULL && timeout_us != 0) {
+        mpsc_node_t *next = atomic_load_explicit(&rest->next, memory_order_relaxed);
+
+        try_to_add_actor(act, sys->tp);
+
+        if ((err = wait_for_space(sys, act, &act->q, rest, timeout_us)) != 0) {
+            break;
+        }
+
+        accepted++;
+        rest = next;
+    }
+
+    actor_count_enqueued(sys, act, accepted);
+    actor_count_dropped(sys, act, n - accepted);
+
+    while (rest != NULL) {
+        mpsc_node_t *next = atomic_load_explicit(&rest->next, memory_order_relaxed);
+
+        envelope_destroy(rest);
+        rest = next;
+    }
+
+    try_to_add_actor(act, sys->tp);
+    actor_release(sys, act);
+
+    return accepted == n ? 0 : (err != 0 ? err : MAILBOX_FULL);
+}
+
+int send_messages(actor_id_t actor, const message_t *messages, size_t n) {
+    return cacti_send_messages(calling_system(), actor, messages, n);
+}
+
+int send_message_multicast(const actor_id_t *receivers, size_t n, message_t message) {
+    cacti_system_t *sys = calling_system();
+    int result = 0;
+    int err;
+
+    if (message.destroy != NULL) {
+        message_drop(&message);
+        return INVALID_MESSAGE;
+    }
+
+    for (size_t i = 0; i < n; i++) {
+        if ((err = send_with_timeout(sys, receivers[i], message, PRIORITY_NORMAL, true, 0)) != 0 && result == 0) {
+            result = err;
+        }
+    }
+
+    return result;
+}
+
+int send_message_inline(actor_id_t actor, message_type_t message_type, const void *payload, size_t nbytes) {
+    cacti_system_t *sys = calling_system();
+    actor_state_t *act;
+    int err;
+
+    if (nbytes > MESSAGE_INLINE_LIMIT) {
+        return PAYLOAD_TOO_BIG;
+    }
+
+    if ((err = find_receiver(sys, actor, &act)) != 0) {
+        return err;
+    }
+
+    if (is_router(act->role)) {
+        message_t message = {.message_type = message_type, .nbytes = nbytes, .data = (void *) payload};
+
+        if (message_type == MSG_GODIE) {
+            return router_stop(sys, act, &message);
+        }
+
+        if ((err = route_message(sys, &act, &message, true)) != 0) {
+            return err;
+        }
+    }
+
+    envelope_t *env = envelope_alloc();
 
-    actor_end_work(actor_id);
+    memcpy(env->payload, payload, nbytes);
+    env->message.message_type = message_type;
+    env->message.nbytes = nbytes;
+    env->message.data = env->payload;
+    env->message.destroy = NULL;
+
+    return deliver_envelope(sys, act, env, PRIORITY_NORMAL, overflow_timeout(sys, act));
 }
 
-int send_message(actor_id_t actor, message_t message) {
-    if (!is_system_alive) {
+int send_message_shared(actor_id_t actor, message_type_t message_type, void *buffer) {
+    message_t message = {.message_type = message_type,
+            .nbytes = shared_size(buffer),
+            .data = shared_retain(buffer),
+            .destroy = shared_release};
+
+    return send_message(actor, message);
+}
+
+int send_message_multicast_shared(const actor_id_t *receivers, size_t n, message_type_t message_type, void *buffer) {
+    cacti_system_t *sys = calling_system();
+    int result = 0;
+    int err;
+
+    for (size_t i = 0; i < n; i++) {
+        message_t message = {.message_type = message_type,
+                .nbytes = shared_size(buffer),
+                .data = shared_retain(buffer),
+                .destroy = shared_release};
+
+        if ((err = send_with_timeout(sys, receivers[i], message, PRIORITY_NORMAL, true, 0)) != 0 && result == 0) {
+            result = err;
+        }
+    }
+
+    return result;
+}
+
+timer_id_t send_message_after(actor_id_t actor, message_t message, unsigned long long delay_us) {
+    return cacti_send_message_every(calling_system(), actor, message, delay_us, 0);
+}
+
+timer_id_t send_message_every(actor_id_t actor, message_t message,
+                              unsigned long long delay_us, unsigned long long period_us) {
+    return cacti_send_message_every(calling_system(), actor, message, delay_us, period_us);
+}
+
+timer_id_t cacti_send_message_every(cacti_system_t *system, actor_id_t actor, message_t message,
+                                    unsigned long long delay_us, unsigned long long period_us) {
+    actor_state_t *act;
+    timer_id_t timer;
+    int err;
+
+    if ((err = find_receiver(system, actor, &act)) != 0) {
+        message_drop(&message);
+        return err;
+    }
+
+    actor_release(system, act);
+
+    if ((timer = timer_add(system->timers, actor, message, delay_us, period_us)) < 0) {
+        message_drop(&message);
         return NO_ACTIVE_SYSTEM;
     }
-    else if (actor < 0 || (size_t) actor >= actors->curr_size) {
-        return -2;
+
+    return timer;
+}
+
+int cacti_cancel_timer(cacti_system_t *system, timer_id_t timer) {
+    return system == NULL ? -1 : timer_cancel(system->timers, timer);
+}
+
+int cancel_timer(timer_id_t timer) {
+    return cacti_cancel_timer(calling_system(), timer);
+}
+
+int cacti_router_create(cacti_system_t *system, actor_id_t *router, const router_config_t *config) {
+    router_t *new_router;
+
+    if (config->role == NULL || config->size == 0 || config->strategy > ROUTER_CONSISTENT_HASH) {
+        return INVALID_ROUTER;
     }
-    else {
-        actor_state_t *act = vector_get(actors, actor);
 
-        if (act->is_dead || signaled) {
-            return -1;
-        }
-        else {
-            message_t *allocated_message = safe_malloc(sizeof (message_t));
+    if (system == NULL || !system->alive || signaled) {
+        return NO_ACTIVE_SYSTEM;
+    }
 
-            allocated_message->data = message.data;
-            allocated_message->nbytes = message.nbytes;
-            allocated_message->message_type = message.message_type;
+    new_router = safe_malloc(sizeof (router_t) + sizeof (actor_id_t) * config->size);
+    new_router->role = (role_t){.nprompts = 0, .prompts = router_prompts};
+    new_router->strategy = config->strategy;
+    new_router->key = config->key;
+    atomic_init(&new_router->next, 0);
+    new_router->size = config->size;
 
-            if(queue_add(act->q, (void *) allocated_message) == -1) {
-                free(allocated_message);
-            }
+    for (size_t i = 0; i < config->size; i++) {
+        new_router->routees[i] = add_act(system->actors, config->role);
+    }
 
-            try_to_add_actor(actor, thread_pool);
+    // Router nie dostaje MSG_HELLO, bo nigdy nie wykonuje komunikatów.
+    *router = add_act(system->actors, &new_router->role);
 
-            return 0;
-        }
+    for (size_t i = 0; i < config->size; i++) {
+        message_t hello = {.message_type = MSG_HELLO,
+                .nbytes = sizeof (actor_id_t),
+                .data = (void *) *router};
+
+        cacti_send_message(system, new_router->routees[i], hello);
     }
+
+    return 0;
+}
+
+int router_create(actor_id_t *router, const router_config_t *config) {
+    return cacti_router_create(calling_system(), router, config);
 }
 
 /* Ustawia nowe zachowanie procesu, po otrzymaniu sygnalu SIGINT, lub przywraca domyślne */
@@ -586,6 +2233,8 @@ void proc_mask(int type) {
     newhandler.sa_flags = 0;
 
     if (type == INIT_SIGACTION) {
+        pthread_once(&signal_watcher_once, start_signal_watcher);
+
         if (sigaction(SIGINT, &newhandler, &old_handler) == -1) {
             fatal("SIGACTION failed!\n");
         }
@@ -598,71 +2247,476 @@ void proc_mask(int type) {
 
 }
 
-int actor_system_create(actor_id_t *actor, role_t *const role) {
-    pthread_mutex_lock(&system_mutex);
+/* Zwraca liczbę wątków puli: wartość zmiennej środowiskowej POOL_SIZE_ENV,
+ * jeżeli jest poprawną liczbą dziesiętną, w.p.p. 'pool_size'. Zero oznacza
+ * liczbę procesorów. */
+size_t resolve_pool_size(size_t pool_size) {
+    char *env = getenv(POOL_SIZE_ENV);
+    char *end;
+
+    // strtoul pomija białe znaki i przyjmuje minus, więc "-1" dałoby ULONG_MAX wątków.
+    if (env != NULL && *env >= '0' && *env <= '9') {
+        errno = 0;
+        unsigned long parsed = strtoul(env, &end, 10);
+
+        if (*end == '\0' && errno == 0) {
+            pool_size = parsed;
+        }
+    }
+
+    if (pool_size == 0) {
+        long cpus = sysconf(_SC_NPROCESSORS_ONLN);
+
+        pool_size = cpus > 0 ? (size_t) cpus : 1;
+    }
+
+    return pool_size;
+}
+
+/* Tworzy ślad systemu, jeżeli podano plik w ustawieniach lub w zmiennej
+ * środowiskowej TRACE_PATH_ENV, w.p.p. zwraca NULL. */
+trace_t *create_trace(const actor_system_config_t *config) {
+    const char *path = getenv(TRACE_PATH_ENV);
+
+    if (path == NULL || *path == '\0') {
+        path = config->trace_path;
+    }
+
+    if (path == NULL) {
+        return NULL;
+    }
+
+    return trace_create(path, config->trace_events == 0 ? TRACE_BUFFER_EVENTS : config->trace_events);
+}
+
+int cacti_system_create(cacti_system_t **system, actor_id_t *actor, role_t *const role,
+                        const actor_system_config_t *config) {
+    actor_system_config_t defaults = {.pool_size = POOL_SIZE};
+    cacti_system_t *sys = safe_malloc(sizeof (cacti_system_t));
+    int res;
+
+    if (config == NULL) {
+        config = &defaults;
+    }
+
+    memset(sys, 0, sizeof (cacti_system_t));
+
+    if ((res = pthread_mutex_init(&sys->mutex, NULL)) != 0) {
+        syserr(res, "System mutex init failed!\n");
+    }
 
-    // Sprawdzamy, czy nie istnieje juz przypadkiem inny system aktorow.
-    if (actors != NULL) {
-        pthread_mutex_unlock(&system_mutex);
-        return INIT_SYSTEM_ERROR;
+    if ((res = pthread_cond_init(&sys->join, NULL)) != 0) {
+        syserr(res, "System cond init failed!\n");
     }
 
-    is_system_alive = true;
-    signaled = false;
-    thread_pool = tpool_create(POOL_SIZE);
-    actors = create_vector();
-    actor_id_t new_actor = add_act(actors, role);
+    sys->alive = true;
+    sys->stats = config->stats;
+    sys->latency = config->latency ? latency_table_create() : NULL;
+    sys->slow_handler_ns = config->slow_handler_us * 1000;
+    sys->slow_handler = config->slow_handler;
+    sys->queue_limit = config->queue_limit == 0 ? ACTOR_QUEUE_LIMIT : config->queue_limit;
+    sys->queue_limit = sys->queue_limit == QUEUE_UNLIMITED ? 0 : sys->queue_limit;
+    sys->overflow = config->overflow == OVERFLOW_DEFAULT ? OVERFLOW_ERROR : config->overflow;
+    sys->send_timeout_us = config->send_timeout_us == 0 ? SEND_TIMEOUT_US : config->send_timeout_us;
+    sys->timers = timer_wheel_create(timer_fire, sys);
+    sys->trace = create_trace(config);
+    cacti_system_set_budget(sys, config->budget);
+
+    if ((res = pthread_mutex_lock(&systems_mutex)) != 0) {
+        syserr(res, "Systems mutex failed!\n");
+    }
+
+    // Ustawienia wspólne dla procesu włącza pierwszy działający system.
+    if (systems_running++ == 0) {
+        signaled = false;
+        proc_mask(INIT_SIGACTION);
+    }
+
+    if ((res = pthread_mutex_unlock(&systems_mutex)) != 0) {
+        syserr(res, "Systems mutex failed!\n");
+    }
+
+    // Wątki puli kończą system pod jego mutexem, więc nie zrobią tego przed wysłaniem HELLO.
+    if ((res = pthread_mutex_lock(&sys->mutex)) != 0) {
+        syserr(res, "System mutex failed!\n");
+    }
+
+    sys->tp = tpool_create(sys, resolve_pool_size(config->pool_size), config);
+    sys->actors = create_vector(config->stats, sys->latency);
+    actor_id_t new_actor = add_act(sys->actors, role);
 
     message_t hello = {.message_type = MSG_HELLO,
                          .nbytes = 0,
                          .data = NULL};
 
-    send_message(new_actor, hello);
+    cacti_send_message(sys, new_actor, hello);
+
+    if ((res = pthread_mutex_unlock(&sys->mutex)) != 0) {
+        syserr(res, "System mutex failed!\n");
+    }
+
+    // Mutex listy systemów bierzemy dopiero po zwolnieniu mutexu systemu, tak jak w system_join.
+    if ((res = pthread_mutex_lock(&systems_mutex)) != 0) {
+        syserr(res, "Systems mutex failed!\n");
+    }
 
-    proc_mask(INIT_SIGACTION);
+    sys->next = systems;
+    systems = sys;
 
-    pthread_mutex_unlock(&system_mutex);
+    if ((res = pthread_mutex_unlock(&systems_mutex)) != 0) {
+        syserr(res, "Systems mutex failed!\n");
+    }
 
+    *system = sys;
     *actor = new_actor;
 
     return 0;
 }
 
-void actor_system_join(actor_id_t actor) {
+/* Czeka na zakończenie systemu i niszczy jego pulę wątków. Jeżeli 'actor'
+ * nie jest NULL, a aktor nie należy do systemu, to nie czeka. */
+void system_join(cacti_system_t *sys, const actor_id_t *actor) {
     int res;
 
-    if ((res = pthread_mutex_lock(&system_mutex))) {
+    if ((res = pthread_mutex_lock(&sys->mutex))) {
         syserr(res, "System mutex failed!\n");
     }
 
     // Sprwadzamy czy numer aktora nalezy do systemu.
-    if (thread_pool == NULL ||
-        (actors != NULL && (actor < 0 || actors->curr_size < (size_t) actor))) {
-        if ((res = pthread_mutex_unlock(&system_mutex))) {
+    if (sys->tp == NULL ||
+        (actor != NULL && sys->actors != NULL && vector_get(sys->actors, *actor) == NULL)) {
+        if ((res = pthread_mutex_unlock(&sys->mutex))) {
             syserr(res, "System mutex failed!\n");
         }
 
         return;
     }
 
-    while (actors != NULL) {
-        if ((res = pthread_cond_wait(&system_join, &system_mutex))) {
+    while (sys->actors != NULL) {
+        if ((res = pthread_cond_wait(&sys->join, &sys->mutex))) {
             syserr(res, "System wait failed!\n");
         }
     }
 
-    if (thread_pool != NULL) {
-        tpool_destroy(thread_pool);
-        thread_pool = NULL;
-        proc_mask(RESTORE_SIGACTION);
-        signaled = false;
+    if (sys->tp != NULL) {
+        if ((res = pthread_mutex_lock(&systems_mutex)) != 0) {
+            syserr(res, "Systems mutex failed!\n");
+        }
+
+        // Po odłączeniu systemu obsługa SIGINT nie sięgnie już do jego puli.
+        for (cacti_system_t **it = &systems; *it != NULL; it = &(*it)->next) {
+            if (*it == sys) {
+                *it = sys->next;
+                break;
+            }
+        }
+
+        if ((res = pthread_mutex_unlock(&systems_mutex)) != 0) {
+            syserr(res, "Systems mutex failed!\n");
+        }
+
+        tpool_destroy(sys->tp);
+        sys->tp = NULL;
+
+        if (sys->trace != NULL) {
+            trace_close(sys->trace);
+            sys->trace = NULL;
+        }
+
+        if ((res = pthread_mutex_lock(&systems_mutex)) != 0) {
+            syserr(res, "Systems mutex failed!\n");
+        }
+
+        // Ślady zapisujemy razem, gdy nie działa już żaden system.
+        if (--systems_running == 0) {
+            trace_flush();
+            proc_mask(RESTORE_SIGACTION);
+            signaled = false;
+        }
+
+        if ((res = pthread_mutex_unlock(&systems_mutex)) != 0) {
+            syserr(res, "Systems mutex failed!\n");
+        }
     }
 
-    if ((res = pthread_mutex_unlock(&system_mutex))) {
+    if ((res = pthread_mutex_unlock(&sys->mutex))) {
         syserr(res, "System mutex failed!\n");
     }
 }
 
+void cacti_system_join(cacti_system_t *system) {
+    system_join(system, NULL);
+}
+
+void cacti_system_free(cacti_system_t *system) {
+    int res;
+
+    if (system == NULL) {
+        return;
+    }
+
+    system_join(system, NULL);
+
+    cacti_system_t *expected = system;
+
+    atomic_compare_exchange_strong(&default_system, &expected, NULL);
+
+    timer_wheel_destroy(system->timers);
+    latency_table_destroy(system->latency);
+
+    if ((res = pthread_cond_destroy(&system->join)) != 0) {
+        syserr(res, "System cond destroy failed!\n");
+    }
+
+    if ((res = pthread_mutex_destroy(&system->mutex)) != 0) {
+        syserr(res, "System mutex destroy failed!\n");
+    }
+
+    free(system->retired_stats);
+    free(system);
+}
+
+cacti_system_t *cacti_system_self() {
+    return current_system;
+}
+
+int actor_system_create(actor_id_t *actor, role_t *const role) {
+    actor_system_config_t config = {.pool_size = POOL_SIZE};
+
+    return actor_system_create_ex(actor, role, &config);
+}
+
+int actor_system_create_ex(actor_id_t *actor, role_t *const role, const actor_system_config_t *config) {
+    static pthread_mutex_t default_mutex = PTHREAD_MUTEX_INITIALIZER;
+    cacti_system_t *old;
+    cacti_system_t *sys;
+    bool running = false;
+    int res;
+
+    if ((res = pthread_mutex_lock(&default_mutex)) != 0) {
+        syserr(res, "Default system mutex failed!\n");
+    }
+
+    // Sprawdzamy, czy nie istnieje juz przypadkiem inny domyślny system aktorow.
+    if ((old = atomic_load(&default_system)) != NULL) {
+        if ((res = pthread_mutex_lock(&old->mutex)) != 0) {
+            syserr(res, "System mutex failed!\n");
+        }
+
+        running = old->actors != NULL;
+
+        if ((res = pthread_mutex_unlock(&old->mutex)) != 0) {
+            syserr(res, "System mutex failed!\n");
+        }
+    }
+
+    if (!running) {
+        // Zakończony system jest trzymany do tej pory tylko dla statystyk.
+        cacti_system_free(old);
+        cacti_system_create(&sys, actor, role, config);
+        atomic_store(&default_system, sys);
+    }
+
+    if ((res = pthread_mutex_unlock(&default_mutex)) != 0) {
+        syserr(res, "Default system mutex failed!\n");
+    }
+
+    return running ? INIT_SYSTEM_ERROR : 0;
+}
+
+void actor_system_join(actor_id_t actor) {
+    cacti_system_t *sys = atomic_load(&default_system);
+
+    if (sys != NULL) {
+        system_join(sys, &actor);
+    }
+}
+
+size_t cacti_threads_warm(size_t threads) {
+    return thread_cache_warm(resolve_pool_size(threads));
+}
+
+int cacti_threads_release() {
+    int res;
+    int result = 0;
+
+    if ((res = pthread_mutex_lock(&systems_mutex)) != 0) {
+        syserr(res, "Systems mutex failed!\n");
+    }
+
+    // Po dołączeniu wszystkich systemów nikt nie czeka już na zadania wątków.
+    if (systems_running > 0) {
+        result = INIT_SYSTEM_ERROR;
+    }
+    else {
+        thread_cache_release();
+    }
+
+    if ((res = pthread_mutex_unlock(&systems_mutex)) != 0) {
+        syserr(res, "Systems mutex failed!\n");
+    }
+
+    return result;
+}
+
 actor_id_t actor_id_self() {
     return self_actor_id;
-}
\ No newline at end of file
+}
+
+void cacti_system_set_budget(cacti_system_t *system, size_t budget) {
+    atomic_store(&system->budget, budget == BUDGET_DEFAULT ? ACTOR_BUDGET : budget);
+}
+
+void actor_system_set_budget(size_t budget) {
+    cacti_system_t *sys = calling_system();
+
+    if (sys != NULL) {
+        cacti_system_set_budget(sys, budget);
+    }
+}
+
+/* Zapisuje statystyki wątku 'worker' bieżącej puli systemu, a jeżeli jej nie ma,
+ * to ostatniej zniszczonej. Zwraca false, gdy nie ma takiego wątku.
+ * Wymaga posiadania mutexa systemu, pod którym niszczona jest pula. */
+bool read_worker_stats(cacti_system_t *sys, size_t worker, worker_stats_t *stats) {
+    if (sys->tp != NULL) {
+        if (worker >= sys->tp->threads_num) {
+            return false;
+        }
+
+        worker_counters_read(&sys->tp->workers[worker].counters, stats);
+    }
+    else {
+        if (worker >= sys->retired_stats_num) {
+            return false;
+        }
+
+        *stats = sys->retired_stats[worker];
+    }
+
+    return true;
+}
+
+void cacti_system_stats(cacti_system_t *system, system_stats_t *stats) {
+    worker_stats_t worker;
+    int res;
+
+    *stats = (system_stats_t){0};
+
+    if (system == NULL) {
+        return;
+    }
+
+    if ((res = pthread_mutex_lock(&system->mutex)) != 0) {
+        syserr(res, "System mutex failed!\n");
+    }
+
+    while (read_worker_stats(system, stats->workers_num, &worker)) {
+        worker_stats_add(&stats->total, &worker);
+        stats->workers_num++;
+    }
+
+    stats->dropped = atomic_load_explicit(&system->dropped, memory_order_relaxed);
+
+    if (system->actors != NULL) {
+        stats->live_actors = atomic_load(&system->actors->live);
+        stats->actor_slots = vector_size(system->actors);
+    }
+
+    if ((res = pthread_mutex_unlock(&system->mutex)) != 0) {
+        syserr(res, "System mutex failed!\n");
+    }
+}
+
+void actor_system_stats(system_stats_t *stats) {
+    cacti_system_stats(calling_system(), stats);
+}
+
+int cacti_system_worker_stats(cacti_system_t *system, size_t worker, worker_stats_t *stats) {
+    int res;
+    bool found;
+
+    if (system == NULL) {
+        return -2;
+    }
+
+    if ((res = pthread_mutex_lock(&system->mutex)) != 0) {
+        syserr(res, "System mutex failed!\n");
+    }
+
+    found = read_worker_stats(system, worker, stats);
+
+    if ((res = pthread_mutex_unlock(&system->mutex)) != 0) {
+        syserr(res, "System mutex failed!\n");
+    }
+
+    return found ? 0 : -2;
+}
+
+int actor_system_worker_stats(size_t worker, worker_stats_t *stats) {
+    return cacti_system_worker_stats(calling_system(), worker, stats);
+}
+
+int cacti_actor_stats(cacti_system_t *system, actor_id_t actor, actor_stats_t *stats) {
+    actor_state_t *act;
+    int res;
+    int result = 0;
+
+    if (system == NULL) {
+        return NO_ACTIVE_SYSTEM;
+    }
+
+    if ((res = pthread_mutex_lock(&system->mutex)) != 0) {
+        syserr(res, "System mutex failed!\n");
+    }
+
+    // Tablica aktorów jest niszczona pod mutexem systemu, więc tu jest bezpieczna.
+    if (system->actors == NULL) {
+        result = NO_ACTIVE_SYSTEM;
+    }
+    else if (!system->stats) {
+        result = STATS_DISABLED;
+    }
+    else if ((act = vector_get(system->actors, actor)) == NULL || atomic_load(&act->id) != actor) {
+        result = -2;
+    }
+    else {
+        actor_metrics_t *metrics = vector_metrics(system->actors, actor);
+
+        stats->enqueued = atomic_load_explicit(&metrics->enqueued, memory_order_relaxed);
+        stats->dropped = atomic_load_explicit(&metrics->dropped, memory_order_relaxed);
+        stats->max_depth = atomic_load_explicit(&metrics->max_depth, memory_order_relaxed);
+        stats->handler_ns = atomic_load_explicit(&metrics->handler_ns, memory_order_relaxed);
+        stats->depth = mailbox_size(system->actors, act);
+    }
+
+    if ((res = pthread_mutex_unlock(&system->mutex)) != 0) {
+        syserr(res, "System mutex failed!\n");
+    }
+
+    return result;
+}
+
+int actor_stats(actor_id_t actor, actor_stats_t *stats) {
+    return cacti_actor_stats(calling_system(), actor, stats);
+}
+
+void actor_system_sched_stats(sched_stats_t *stats) {
+    system_stats_t system;
+
+    actor_system_stats(&system);
+
+    stats->activations = system.total.activations;
+    stats->messages = system.total.messages;
+    stats->preemptions = system.total.preemptions;
+    stats->max_batch = system.total.max_batch;
+}
+
+int cacti_system_latency(cacti_system_t *system, const role_t *role, message_type_t message_type,
+                         latency_stats_t *stats) {
+    return system != NULL && latency_read(system->latency, role, message_type, stats) ? 0 : -2;
+}
+
+int actor_system_latency(const role_t *role, message_type_t message_type, latency_stats_t *stats) {
+    return cacti_system_latency(calling_system(), role, message_type, stats);
+}
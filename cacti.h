@@ -2,6 +2,7 @@
 #define CACTI_H
 
 #include <stddef.h>
+#include <stdbool.h>
 
 typedef long message_type_t;
 
@@ -13,37 +14,442 @@ typedef long message_type_t;
 #define ACTOR_QUEUE_LIMIT 1024
 #endif
 
+// Największa liczba wątków puli wykonującej blokujące obsługi komunikatów.
+#ifndef BLOCKING_THREADS
+#define BLOCKING_THREADS 64
+#endif
+
+// Po tylu milisekundach bez pracy kończy się wątek puli blokującej.
+#ifndef BLOCKING_IDLE_MS
+#define BLOCKING_IDLE_MS 1000
+#endif
+
+// Krok koła zegarów, czyli dokładność opóźnionych wiadomości.
+#ifndef TIMER_TICK_US
+#define TIMER_TICK_US 1000
+#endif
+
+// Domyślna liczba zdarzeń w buforze śladu jednego wątku.
+#ifndef TRACE_BUFFER_EVENTS
+#define TRACE_BUFFER_EVENTS 65536
+#endif
+
 #ifndef CAST_LIMIT
 #define CAST_LIMIT 1048576
 #endif
 
+#ifndef MESSAGE_INLINE_LIMIT
+#define MESSAGE_INLINE_LIMIT 48
+#endif
+
+#ifndef ACTOR_BUDGET
+#define ACTOR_BUDGET 64
+#endif
+
+#ifndef IDLE_SPINS
+#define IDLE_SPINS 256
+#endif
+
+#ifndef IDLE_YIELDS
+#define IDLE_YIELDS 16
+#endif
+
 #ifndef POOL_SIZE
 #define POOL_SIZE 3
 #endif
 
+/* Wiadomość z niepustym 'destroy' przekazuje dane na własność: obsługa
+ * komunikatu przejmuje 'data' i sama je zwalnia, a jeżeli wiadomość nie trafi
+ * do obsługi (odrzucona przy pełnej skrzynce, wysłana do martwego aktora,
+ * MSG_GODIE, lub pozostała w skrzynce po zakończeniu systemu), to system
+ * wywołuje 'destroy(data)'. Od chwili wysłania nadawca nie może używać danych,
+ * także gdy wysyłka zwróciła błąd. */
 typedef struct message
 {
     message_type_t message_type;
     size_t nbytes;
     void *data;
+    void (*destroy)(void *data);
 } message_t;
 
+/* Miejsca po zmarłych aktorach są używane ponownie, a numer aktora zawiera
+ * pokolenie miejsca, więc numer zmarłego aktora nie wskazuje jego następcy.
+ * CAST_LIMIT ogranicza liczbę aktorów żyjących (lub kończących pracę) naraz. */
 typedef long actor_id_t;
 
+typedef long timer_id_t;
+
 actor_id_t actor_id_self();
 
 typedef void (*const act_t)(void **stateptr, size_t nbytes, void *data);
 
+// Budżet równy 0 oznacza użycie domyślnego budżetu systemu.
+#define BUDGET_DEFAULT ((size_t) 0)
+// Aktor z takim budżetem jest przetwarzany aż do opróżnienia skrzynki.
+#define BUDGET_UNLIMITED ((size_t) -1)
+
+// Kod błędu wysyłki, której wiadomość nie zmieściła się w skrzynce odbiorcy.
+#define MAILBOX_FULL (-7)
+
+// Czas czekania na miejsce w skrzynce bez ograniczenia.
+#define TIMEOUT_INFINITE ((unsigned long long) -1)
+
+// Domyślny czas, przez jaki wysyłka czeka na miejsce w skrzynce przy OVERFLOW_BLOCK.
+#ifndef SEND_TIMEOUT_US
+#define SEND_TIMEOUT_US 1000000
+#endif
+
+// Co zrobić z wiadomością, która nie mieści się w skrzynce odbiorcy.
+typedef enum overflow
+{
+    OVERFLOW_DEFAULT = 0,  // Dla roli: ustawienie systemu, dla systemu: OVERFLOW_ERROR.
+    OVERFLOW_ERROR,        // Odrzucić wiadomość, wysyłka zwraca MAILBOX_FULL.
+    /* Czekać na miejsce w skrzynce, co najwyżej 'send_timeout_us'. Czekający
+     * wątek w tym czasie nie wykonuje innych aktorów. Wysyłka do samego siebie
+     * oraz wysyłka z jedynego wątku puli nie czekają, bo nikt nie opróżniłby
+     * skrzynki, tylko od razu zwracają MAILBOX_FULL. */
+    OVERFLOW_BLOCK,
+    OVERFLOW_DROP_OLDEST,  // Przyjąć wiadomość, odrzucając najstarsze ze skrzynki.
+    OVERFLOW_UNBOUNDED     // Skrzynka nie ma limitu.
+} overflow_t;
+
 typedef struct role
 {
     size_t nprompts;
     act_t *prompts;
+    size_t budget; // Najwięcej komunikatów wykonanych w jednym przetworzeniu aktora.
+    /* Tablica 'nprompts' flag, NULL = żadna. Obsługa oznaczona jako blokująca
+     * (np. śpiąca lub czekająca na wejście/wyjście) wykonuje się w osobnej puli
+     * wątków, więc nie wstrzymuje innych aktorów. Kolejność komunikatów aktora
+     * jest zachowana. */
+    const bool *blocking;
+    overflow_t overflow; // Zachowanie przy pełnej skrzynce aktorów tej roli.
 } role_t;
 
+typedef struct sched_stats
+{
+    unsigned long long activations; // Ile razy wątek zabrał się za przetwarzanie aktora.
+    unsigned long long messages;    // Ile komunikatów wykonano.
+    unsigned long long preemptions; // Ile przetworzeń przerwał budżet, mimo czekających komunikatów.
+    unsigned long long max_batch;   // Najwięcej komunikatów wykonanych w jednym przetworzeniu.
+} sched_stats_t;
+
+typedef struct worker_stats
+{
+    unsigned long long activations; // Ile razy wątek zabrał się za przetwarzanie aktora.
+    unsigned long long messages;    // Ile komunikatów wykonał wątek.
+    unsigned long long preemptions; // Ile przetworzeń przerwał budżet.
+    unsigned long long max_batch;   // Najwięcej komunikatów wykonanych w jednym przetworzeniu.
+    unsigned long long steals;      // Ilu aktorów wątek zabrał z kolejek innych wątków.
+    unsigned long long parks;       // Ile razy wątek zasnął z braku pracy.
+    unsigned long long wakeups;     // Ile razy wątek został obudzony, bo pojawiła się praca.
+} worker_stats_t;
+
+typedef struct system_stats
+{
+    size_t workers_num;
+    worker_stats_t total; // Suma liczników wszystkich wątków (max_batch to maksimum).
+    unsigned long long dropped; // Ile wiadomości odrzucono z powodu pełnych skrzynek.
+    size_t live_actors;         // Liczba żyjących aktorów działającego systemu.
+    size_t actor_slots;         // Liczba zajętych miejsc tablicy aktorów (żywi i zwolnieni).
+} system_stats_t;
+
+typedef struct actor_stats
+{
+    unsigned long long enqueued;   // Ile wiadomości trafiło do skrzynki aktora.
+    unsigned long long dropped;    // Ile wiadomości odrzucono z powodu pełnej skrzynki.
+    unsigned long long max_depth;  // Największa zaobserwowana liczba wiadomości w skrzynce.
+    unsigned long long handler_ns; // Łączny czas wykonywania obsług komunikatów aktora.
+    size_t depth;                  // Bieżąca liczba wiadomości w skrzynce.
+} actor_stats_t;
+
+// Wyłącza daną fazę aktywnego czekania bezczynnego wątku.
+#define IDLE_NONE ((size_t) -1)
+
+// Skrzynka aktora z takim limitem nie ma ograniczenia rozmiaru.
+#define QUEUE_UNLIMITED ((size_t) -1)
+
+typedef struct latency_stats
+{
+    unsigned long long count;   // Ile razy wykonano obsługę komunikatu.
+    unsigned long long slow;    // Ile wykonań przekroczyło próg 'slow_handler_us'.
+    unsigned long long mean_ns;
+    unsigned long long max_ns;
+    unsigned long long p50_ns;  // Percentyle z dokładnością do 1/8 wartości.
+    unsigned long long p90_ns;
+    unsigned long long p99_ns;
+    unsigned long long p999_ns;
+} latency_stats_t;
+
+// Wywoływana w wątku aktora po obsłudze komunikatu trwającej co najmniej zadany próg.
+typedef void (*slow_handler_t)(actor_id_t actor, message_type_t message_type, unsigned long long ns);
+
+typedef enum affinity
+{
+    AFFINITY_NONE = 0, // Wątki działają na dowolnych procesorach.
+    AFFINITY_CPU,      // Każdy wątek jest przypięty do jednego procesora.
+    AFFINITY_NODE      // Każdy wątek jest przypięty do procesorów jednego węzła NUMA.
+} affinity_t;
+
+/* Ustawienia systemu aktorów. Pole równe 0 oznacza wartość domyślną, więc
+ * wystarczy ustawić tylko te pola, które mają się różnić od domyślnych. */
+typedef struct actor_system_config
+{
+    size_t pool_size;   // Liczba wątków, 0 = liczba dostępnych procesorów.
+    size_t queue_limit; // Limit skrzynki aktora, 0 = ACTOR_QUEUE_LIMIT.
+    size_t budget;      // Domyślny budżet przetwarzania, 0 = ACTOR_BUDGET.
+    /* Przypinanie wątków do procesorów. Przy przypiętych wątkach aktor jest
+     * szeregowany do wątku, który ostatnio go przetwarzał. Przypinane są tylko
+     * wątki: stan aktorów i skrzynki nie są rozmieszczane między węzłami NUMA. */
+    affinity_t affinity;
+    /* Dla AFFINITY_CPU: procesory kolejnych wątków, NULL = wszystkie dozwolone.
+     * Wątek, którego procesor nie jest dozwolony dla procesu, nie jest przypinany. */
+    const int *cpus;
+    size_t ncpus;
+    /* Bezczynny wątek sprawdza najpierw 'idle_spins' razy, czy jest praca, w aktywnej
+     * pętli, potem 'idle_yields' razy oddaje procesor, a dopiero potem zasypia.
+     * 0 = IDLE_SPINS / IDLE_YIELDS, IDLE_NONE pomija daną fazę. */
+    size_t idle_spins;
+    size_t idle_yields;
+    /* Włącza liczniki aktorów (actor_stats) i pomiar czasu obsług komunikatów.
+     * Liczniki wątków są zbierane zawsze. */
+    bool stats;
+    // Włącza histogramy czasu obsług komunikatów dla każdej roli (actor_system_latency).
+    bool latency;
+    /* Obsługa komunikatu trwająca co najmniej tyle mikrosekund jest zgłaszana
+     * funkcji 'slow_handler', a gdy ta jest NULL, wypisywana na stderr. 0 = wyłączone. */
+    unsigned long long slow_handler_us;
+    slow_handler_t slow_handler;
+    /* Plik, do którego actor_system_join zapisze przebieg szeregowania w formacie
+     * Chrome trace, NULL = bez śladu. Każdy wątek pamięta 'trace_events' ostatnich
+     * zdarzeń, 0 = TRACE_BUFFER_EVENTS. Ślady systemów działających naraz trafiają
+     * do pliku po zakończeniu ostatniego z nich, każdy jako osobny proces. */
+    const char *trace_path;
+    size_t trace_events;
+    size_t blocking_threads; // Limit wątków puli blokującej, 0 = BLOCKING_THREADS.
+    overflow_t overflow;     // Zachowanie przy pełnej skrzynce dla ról, które go nie ustalają.
+    unsigned long long send_timeout_us; // 0 = SEND_TIMEOUT_US, może być TIMEOUT_INFINITE.
+} actor_system_config_t;
+
+/* Zmienna środowiskowa nadpisująca liczbę wątków systemu (0 = liczba
+ * dostępnych procesorów), niezależnie od tego, jak system został utworzony.
+ * Wartość, która nie jest liczbą dziesiętną bez znaku, jest pomijana. */
+#define POOL_SIZE_ENV "CACTI_POOL_SIZE"
+
+// Zmienna środowiskowa nadpisująca pole 'trace_path' ustawień systemu.
+#define TRACE_PATH_ENV "CACTI_TRACE"
+
+/* Niezależny system aktorów z własną pulą wątków, tablicą aktorów, zegarami
+ * i ustawieniami. W jednym procesie może działać kilka systemów naraz. */
+typedef struct cacti_system cacti_system_t;
+
+/* Tworzy nowy system z aktorem o roli 'role' (NULL 'config' = ustawienia
+ * domyślne) i zapisuje jego uchwyt. Funkcje bez uchwytu wywołane w wątku
+ * systemu dotyczą tego systemu. */
+int cacti_system_create(cacti_system_t **system, actor_id_t *actor, role_t *const role,
+                        const actor_system_config_t *config);
+
+// Czeka, aż wszyscy aktorzy systemu umrą, i niszczy jego pulę wątków.
+void cacti_system_join(cacti_system_t *system);
+
+// Dołącza system, o ile nie był dołączony, i zwalnia go. Potem uchwyt jest nieważny.
+void cacti_system_free(cacti_system_t *system);
+
+// Zwraca system aktora, którego komunikat jest obsługiwany, NULL poza systemami.
+cacti_system_t *cacti_system_self();
+
+int cacti_send_message(cacti_system_t *system, actor_id_t actor, message_t message);
+
+int cacti_send_message_prio(cacti_system_t *system, actor_id_t actor, message_t message, int priority);
+
+int cacti_send_messages(cacti_system_t *system, actor_id_t actor, const message_t *messages, size_t n);
+
+timer_id_t cacti_send_message_every(cacti_system_t *system, actor_id_t actor, message_t message,
+                                    unsigned long long delay_us, unsigned long long period_us);
+
+int cacti_cancel_timer(cacti_system_t *system, timer_id_t timer);
+
+void cacti_system_set_budget(cacti_system_t *system, size_t budget);
+
+void cacti_system_stats(cacti_system_t *system, system_stats_t *stats);
+
+int cacti_system_worker_stats(cacti_system_t *system, size_t worker, worker_stats_t *stats);
+
+int cacti_actor_stats(cacti_system_t *system, actor_id_t actor, actor_stats_t *stats);
+
+int cacti_system_latency(cacti_system_t *system, const role_t *role, message_type_t message_type,
+                         latency_stats_t *stats);
+
+/* Wątki pul są po zakończeniu systemu zachowywane dla kolejnych systemów.
+ * Tworzy z góry tyle wątków, ile ma pula o rozmiarze 'threads' (0 = liczba
+ * procesorów, jak 'pool_size'), żeby pierwszy system ich nie tworzył.
+ * Zwraca liczbę czekających wątków. */
+size_t cacti_threads_warm(size_t threads);
+
+/* Kończy zachowane wątki. Zwraca 0, lub INIT_SYSTEM_ERROR (-3), gdy
+ * jakiś system nie został jeszcze dołączony. */
+int cacti_threads_release();
+
+/* Funkcje bez uchwytu dotyczą systemu bieżącego wątku, a poza wątkami systemów
+ * systemu domyślnego, tworzonego przez actor_system_create. Domyślny system
+ * może istnieć tylko jeden naraz. */
 int actor_system_create(actor_id_t *actor, role_t *const role);
 
+int actor_system_create_ex(actor_id_t *actor, role_t *const role, const actor_system_config_t *config);
+
 void actor_system_join(actor_id_t actor);
 
+/* Wysyła wiadomość. Zwraca 0, lub kod błędu, w tym MAILBOX_FULL, gdy
+ * wiadomość odrzucono zgodnie z zachowaniem odbiorcy przy pełnej skrzynce. */
 int send_message(actor_id_t actor, message_t message);
 
+/* Poziomy priorytetu wiadomości: od PRIORITY_NORMAL (send_message) do
+ * PRIORITY_LEVELS - 1. Aktor wykonuje najpierw komunikaty sterujące (MSG_HELLO,
+ * MSG_SPAWN, MSG_GODIE, niezależnie od sposobu wysłania), potem wiadomości od
+ * najwyższego priorytetu. W ramach jednego priorytetu kolejność jest zachowana,
+ * a limit skrzynki dotyczy każdego priorytetu osobno, także przy
+ * OVERFLOW_DROP_OLDEST. Oczekujących komunikatów sterujących też może być co
+ * najwyżej tyle, ile wynosi limit; nadmiar jest odrzucany bez czekania
+ * (MAILBOX_FULL), a jedynie MSG_GODIE jest przyjmowany zawsze. */
+#ifndef PRIORITY_LEVELS
+#define PRIORITY_LEVELS 4
+#endif
+
+#define PRIORITY_NORMAL 0
+
+// Kod błędu wysyłki z priorytetem spoza zakresu.
+#define INVALID_PRIORITY (-8)
+
+// Kod błędu wysyłki wiadomości na własność do wielu aktorów naraz.
+#define INVALID_MESSAGE (-9)
+
+// Jak send_message, ale wiadomość ma priorytet 'priority'.
+int send_message_prio(actor_id_t actor, message_t message, int priority);
+
+// Jak send_message, ale nigdy nie czeka na miejsce w skrzynce.
+int send_message_try(actor_id_t actor, message_t message);
+
+/* Jak send_message, ale przy pełnej skrzynce czeka na miejsce co najwyżej
+ * 'timeout_us' mikrosekund, niezależnie od zachowania odbiorcy. */
+int send_message_timed(actor_id_t actor, message_t message, unsigned long long timeout_us);
+
+/* Ustawia domyślny budżet przetwarzania dla ról, które nie mają własnego.
+ * BUDGET_DEFAULT przywraca wartość ACTOR_BUDGET. */
+void actor_system_set_budget(size_t budget);
+
+// Zapisuje statystyki szeregowania bieżącego (lub ostatniego) systemu aktorów.
+void actor_system_sched_stats(sched_stats_t *stats);
+
+// Zapisuje zsumowane liczniki wątków bieżącego (lub ostatniego) systemu aktorów.
+void actor_system_stats(system_stats_t *stats);
+
+// Zapisuje liczniki wątku o numerze 'worker'. Zwraca 0, lub -2 gdy nie ma takiego wątku.
+int actor_system_worker_stats(size_t worker, worker_stats_t *stats);
+
+/* Zapisuje liczniki aktora o podanym id. Wymaga włączenia 'stats' w ustawieniach
+ * systemu i działającego systemu. Zwraca 0, lub kod błędu. */
+int actor_stats(actor_id_t actor, actor_stats_t *stats);
+
+/* Zapisuje rozkład czasu obsługi komunikatu 'message_type' przez aktorów roli
+ * 'role' w bieżącym (lub ostatnim) systemie. Wymaga włączenia 'latency'
+ * w ustawieniach systemu. Zwraca 0, lub -2 gdy nie ma pomiarów. */
+int actor_system_latency(const role_t *role, message_type_t message_type, latency_stats_t *stats);
+
+/* Wysyła do aktora naraz 'n' wiadomości, w podanej kolejności. Wiadomości trafiają
+ * do skrzynki jedną operacją, a aktor jest dodawany do kolejki co najwyżej raz. */
+int send_messages(actor_id_t actor, const message_t *messages, size_t n);
+
+/* Wysyła tę samą wiadomość do każdego z 'n' podanych aktorów. Zwraca 0, jeżeli
+ * wszystkie wysyłki się powiodły, w.p.p. kod błędu pierwszej nieudanej. Dane
+ * wiadomości z 'destroy' nie mogą mieć wielu właścicieli, więc taka wiadomość
+ * jest od razu zwalniana, a wysyłka zwraca INVALID_MESSAGE. */
+int send_message_multicast(const actor_id_t *receivers, size_t n, message_t message);
+
+/* Niezmienne bufory z licznikiem odwołań, które można wysłać wielu aktorom bez
+ * kopiowania. Nowy bufor ma jedno odwołanie, należące do twórcy, który wypełnia
+ * go przed pierwszym wysłaniem. Potem nikt nie może go już zmieniać. Bufor jest
+ * zwalniany, gdy zostanie oddane ostatnie odwołanie. */
+void *shared_alloc(size_t size);
+
+// Bierze dodatkowe odwołanie do bufora. Zwraca 'buffer'.
+void *shared_retain(void *buffer);
+
+// Oddaje odwołanie do bufora. Nadaje się na pole 'destroy' wiadomości.
+void shared_release(void *buffer);
+
+size_t shared_size(const void *buffer);
+
+/* Wysyła bufor ze współdzielonymi danymi, biorąc dla odbiorcy osobne odwołanie,
+ * które obsługa komunikatu oddaje przez shared_release. Nadawca zachowuje swoje
+ * odwołanie. Wysyłka z uchwytem systemu to cacti_send_message z wiadomością
+ * {.nbytes = shared_size(b), .data = shared_retain(b), .destroy = shared_release}. */
+int send_message_shared(actor_id_t actor, message_type_t message_type, void *buffer);
+
+// Jak send_message_multicast, ale każdy odbiorca dostaje odwołanie do tego samego bufora.
+int send_message_multicast_shared(const actor_id_t *receivers, size_t n, message_type_t message_type, void *buffer);
+
+/* Wysyła wiadomość, której dane (co najwyżej MESSAGE_INLINE_LIMIT bajtów) są
+ * kopiowane do koperty, więc nadawca nie musi ich alokować. Obsługa komunikatu
+ * dostaje wskaźnik na kopię, ważny jedynie w trakcie jej wykonania. */
+int send_message_inline(actor_id_t actor, message_type_t message_type, const void *payload, size_t nbytes);
+
+// Sposób, w jaki router wybiera aktora puli dla kolejnej wiadomości.
+typedef enum router_strategy
+{
+    ROUTER_ROUND_ROBIN = 0,  // Kolejno, po jednej wiadomości.
+    ROUTER_SMALLEST_MAILBOX, // Aktor o najmniejszej liczbie wiadomości w skrzynce.
+    /* Aktor wyznaczony przez klucz wiadomości, więc wiadomości o tym samym kluczu
+     * trafiają do tego samego aktora, w kolejności wysłania. */
+    ROUTER_CONSISTENT_HASH
+} router_strategy_t;
+
+// Zwraca klucz wiadomości dla ROUTER_CONSISTENT_HASH.
+typedef unsigned long long (*router_key_t)(const message_t *message);
+
+typedef struct router_config
+{
+    router_strategy_t strategy;
+    role_t *role;     // Rola aktorów puli.
+    size_t size;      // Liczba aktorów puli.
+    /* NULL = kluczem jest wartość wskaźnika 'data', a dla send_message_inline
+     * (i send_value) zawartość kopiowanych danych. */
+    router_key_t key;
+} router_config_t;
+
+// Kod błędu tworzenia routera z niepoprawnymi ustawieniami.
+#define INVALID_ROUTER (-10)
+
+/* Tworzy pulę 'size' aktorów roli 'role' i router, którego numer zapisuje pod
+ * 'router'. Aktorzy puli dostają MSG_HELLO z numerem routera. Wiadomość wysłana
+ * do routera trafia od razu do skrzynki wybranego aktora puli, bez pośredniej
+ * skrzynki routera. MSG_GODIE wysłany do routera dostaje każdy aktor puli,
+ * a router umiera. Router jest żywym aktorem, więc dopóki nie dostanie
+ * MSG_GODIE, system się nie kończy. Zwraca 0, lub kod błędu. */
+int router_create(actor_id_t *router, const router_config_t *config);
+
+int cacti_router_create(cacti_system_t *system, actor_id_t *router, const router_config_t *config);
+
+/* Wysyła wiadomość po upływie 'delay_us' mikrosekund (z dokładnością do
+ * TIMER_TICK_US), bez zajmowania żadnego wątku w trakcie czekania. Zwraca
+ * id zegara (nieujemne), lub kod błędu, tak jak send_message. */
+timer_id_t send_message_after(actor_id_t actor, message_t message, unsigned long long delay_us);
+
+/* Wysyła wiadomość po 'delay_us', a potem co 'period_us' mikrosekund, dopóki
+ * zegar nie zostanie usunięty, lub aktor nie umrze. Odpalenie, które trafi na
+ * pełną skrzynkę, przepada, ale zegar działa dalej.
+ * Dane na własność należą do zegara: aktor dostaje je bez 'destroy', a zwalniane
+ * są po usunięciu zegara, gdy żadna wysłana już wiadomość zegara ich nie używa. */
+timer_id_t send_message_every(actor_id_t actor, message_t message,
+                              unsigned long long delay_us, unsigned long long period_us);
+
+// Usuwa zegar. Zwraca 0, lub -1 gdy zegar już się odpalił, lub nie istnieje.
+int cancel_timer(timer_id_t timer);
+
+// Wysyła kopię zmiennej 'value' jako dane wiadomości.
+#define send_value(actor, message_type, value) \
+    send_message_inline((actor), (message_type), &(value), sizeof (value))
+
+// Odczytuje w obsłudze komunikatu wartość wysłaną przez send_value.
+#define message_value(type, data) (*(const type *) (data))
+
 #endif
\ No newline at end of file
@@ -0,0 +1,235 @@
+#include <stdatomic.h>
+#include <stdbool.h>
+#include <stdlib.h>
+#include <pthread.h>
+#include "err.h"
+
+#include "envelope_pool.h"
+
+#define ENVELOPE_BATCH 64
+#define ENVELOPE_CACHE_MAX (2 * ENVELOPE_BATCH)
+
+/* Nagłówek bloku pamięci, z którego wycinane są koperty. Bloki trzymamy
+ * na liście, żeby pamięć pozostała osiągalna do końca działania procesu. */
+typedef struct slab {
+    struct slab *next;
+    envelope_t envelopes[ENVELOPE_BATCH];
+} slab_t;
+
+struct envelope_loan {
+    atomic_size_t refs;
+    void *data;
+    void (*destroy)(void *data);
+};
+
+static pthread_mutex_t pool_mutex = PTHREAD_MUTEX_INITIALIZER;
+static envelope_t *pool_free = NULL;
+static size_t pool_count = 0;
+static slab_t *slabs = NULL;
+
+static __thread envelope_t *local_free = NULL;
+static __thread size_t local_count = 0;
+
+/* Klucz wątku, którego destruktor oddaje listę kończącego się wątku do
+ * wspólnej puli. Wątek rejestruje się przy pierwszym użyciu swojej listy. */
+static pthread_key_t exit_key;
+static pthread_once_t exit_key_once = PTHREAD_ONCE_INIT;
+static __thread bool exit_registered = false;
+
+static envelope_t *next_free(envelope_t *env) {
+    return (envelope_t *) atomic_load_explicit(&env->node.next, memory_order_relaxed);
+}
+
+static void set_next_free(envelope_t *env, envelope_t *next) {
+    // Węzeł jest pierwszym polem koperty, więc rzutowanie zachowuje też NULL.
+    atomic_store_explicit(&env->node.next, (mpsc_node_t *) next, memory_order_relaxed);
+}
+
+static void pool_lock() {
+    int res;
+
+    if ((res = pthread_mutex_lock(&pool_mutex)) != 0) {
+        syserr(res, "Locking envelope pool mutex failed!\n");
+    }
+}
+
+static void pool_unlock() {
+    int res;
+
+    if ((res = pthread_mutex_unlock(&pool_mutex)) != 0) {
+        syserr(res, "Unlocking envelope pool mutex failed!\n");
+    }
+}
+
+static void flush_on_exit(void *arg) {
+    (void) arg;
+
+    envelope_pool_flush();
+}
+
+static void create_exit_key() {
+    int res;
+
+    if ((res = pthread_key_create(&exit_key, flush_on_exit)) != 0) {
+        syserr(res, "Creating envelope pool key failed!\n");
+    }
+}
+
+// Destruktor klucza działa tylko dla wątków, które ustawiły jego wartość.
+static void register_exit() {
+    int res;
+
+    if ((res = pthread_once(&exit_key_once, create_exit_key)) != 0) {
+        syserr(res, "Creating envelope pool key failed!\n");
+    }
+
+    if ((res = pthread_setspecific(exit_key, &exit_key)) != 0) {
+        syserr(res, "Setting envelope pool key failed!\n");
+    }
+
+    exit_registered = true;
+}
+
+/* Uzupełnia listę wątku paczką kopert ze wspólnej puli, a jeżeli ta
+ * jest pusta, to nowym blokiem pamięci. */
+static void refill_local() {
+    if (!exit_registered) {
+        register_exit();
+    }
+
+    pool_lock();
+
+    if (pool_count > 0) {
+        for (size_t i = 0; i < ENVELOPE_BATCH && pool_free != NULL; i++) {
+            envelope_t *env = pool_free;
+
+            pool_free = next_free(env);
+            pool_count--;
+
+            set_next_free(env, local_free);
+            local_free = env;
+            local_count++;
+        }
+
+        pool_unlock();
+        return;
+    }
+
+    slab_t *slab = malloc(sizeof (slab_t));
+
+    if (slab == NULL) {
+        fatal("Envelope slab allocation failed!\n");
+    }
+
+    slab->next = slabs;
+    slabs = slab;
+
+    pool_unlock();
+
+    for (size_t i = 0; i < ENVELOPE_BATCH; i++) {
+        set_next_free(&slab->envelopes[i], local_free);
+        local_free = &slab->envelopes[i];
+        local_count++;
+    }
+}
+
+// Oddaje do wspólnej puli co najwyżej 'how_many' kopert z listy wątku.
+static void return_local(size_t how_many) {
+    pool_lock();
+
+    for (size_t i = 0; i < how_many && local_free != NULL; i++) {
+        envelope_t *env = local_free;
+
+        local_free = next_free(env);
+        local_count--;
+
+        set_next_free(env, pool_free);
+        pool_free = env;
+        pool_count++;
+    }
+
+    pool_unlock();
+}
+
+envelope_t *envelope_alloc() {
+    if (local_free == NULL) {
+        refill_local();
+    }
+
+    envelope_t *env = local_free;
+
+    local_free = next_free(env);
+    local_count--;
+    env->loan = NULL;
+
+    return env;
+}
+
+void envelope_free(envelope_t *env) {
+    if (!exit_registered) {
+        register_exit();
+    }
+
+    if (env->loan != NULL) {
+        envelope_loan_release(env->loan);
+        env->loan = NULL;
+    }
+
+    set_next_free(env, local_free);
+    local_free = env;
+    local_count++;
+
+    if (local_count > ENVELOPE_CACHE_MAX) {
+        return_local(ENVELOPE_BATCH);
+    }
+}
+
+void envelope_drop(envelope_t *env) {
+    if (env->message.destroy != NULL) {
+        env->message.destroy(env->message.data);
+    }
+
+    envelope_free(env);
+}
+
+void envelope_destroy(mpsc_node_t *node) {
+    envelope_drop((envelope_t *) node);
+}
+
+void envelope_pool_flush() {
+    if (local_count > 0) {
+        return_local(local_count);
+    }
+}
+
+envelope_loan_t *envelope_loan_create(void *data, void (*destroy)(void *data)) {
+    envelope_loan_t *loan = malloc(sizeof (envelope_loan_t));
+
+    if (loan == NULL) {
+        fatal("Envelope loan allocation failed!\n");
+    }
+
+    atomic_init(&loan->refs, 1);
+    loan->data = data;
+    loan->destroy = destroy;
+
+    return loan;
+}
+
+void envelope_lend(envelope_t *env, envelope_loan_t *loan) {
+    atomic_fetch_add_explicit(&loan->refs, 1, memory_order_relaxed);
+    env->loan = loan;
+}
+
+void envelope_loan_release(envelope_loan_t *loan) {
+    // Ostatni właściciel musi widzieć wszystkie wcześniejsze odczyty pozostałych.
+    if (atomic_fetch_sub_explicit(&loan->refs, 1, memory_order_release) == 1) {
+        atomic_thread_fence(memory_order_acquire);
+
+        if (loan->destroy != NULL) {
+            loan->destroy(loan->data);
+        }
+
+        free(loan);
+    }
+}
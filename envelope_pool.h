@@ -0,0 +1,54 @@
+#ifndef CACTI_ENVELOPE_POOL_H
+#define CACTI_ENVELOPE_POOL_H
+
+#include "mpsc_queue.h"
+#include "cacti.h"
+
+/* Dane na własność pożyczane wielu kopertom naraz, np. kolejnym wiadomościom
+ * zegara okresowego. Właściciel i każda koperta z pożyczką trzymają odwołanie,
+ * a oddanie ostatniego zwalnia dane przez 'destroy'. */
+typedef struct envelope_loan envelope_loan_t;
+
+/* Koperta, w której wiadomość czeka w skrzynce aktora. Węzeł kolejki jest
+ * pierwszym polem, więc wskaźnik na węzeł jest zarazem wskaźnikiem na kopertę.
+ * Małe dane wiadomości wysłanych przez send_message_inline są kopiowane do
+ * 'payload', a 'message.data' wskazuje wtedy na tę kopię. Odwołanie 'loan'
+ * (o ile nie NULL) jest oddawane przy zwolnieniu koperty. */
+typedef struct envelope {
+    mpsc_node_t node;
+    message_t message;
+    envelope_loan_t *loan;
+    _Alignas(max_align_t) unsigned char payload[MESSAGE_INLINE_LIMIT];
+} envelope_t;
+
+/* Pula kopert. Każdy wątek trzyma własną listę wolnych kopert, więc alokacja
+ * i zwolnienie zwykle nie biorą żadnego mutexa. Koperty zwalnia zazwyczaj inny
+ * wątek niż ten, który je zaalokował, dlatego nadmiar z listy wątku jest
+ * oddawany do wspólnej puli całymi paczkami, a pusta lista wątku jest z niej
+ * uzupełniana również paczką. Lista kończącego się wątku wraca do wspólnej
+ * puli. Pamięć kopert nie jest oddawana systemowi. */
+
+envelope_t *envelope_alloc();
+
+// Zwalnia kopertę wiadomości, którą wykonano. Dane należą wtedy do obsługi.
+void envelope_free(envelope_t *env);
+
+// Zwalnia kopertę wiadomości, której nie wykonano, razem z jej danymi na własność.
+void envelope_drop(envelope_t *env);
+
+// Wersja envelope_drop do użycia jako destruktor elementów kolejki mpsc.
+void envelope_destroy(mpsc_node_t *node);
+
+// Oddaje do wspólnej puli wszystkie koperty z listy bieżącego wątku.
+void envelope_pool_flush();
+
+// Tworzy pożyczkę danych 'data' z jednym odwołaniem, należącym do twórcy.
+envelope_loan_t *envelope_loan_create(void *data, void (*destroy)(void *data));
+
+// Daje kopercie własne odwołanie do pożyczki.
+void envelope_lend(envelope_t *env, envelope_loan_t *loan);
+
+// Oddaje odwołanie do pożyczki.
+void envelope_loan_release(envelope_loan_t *loan);
+
+#endif //CACTI_ENVELOPE_POOL_H
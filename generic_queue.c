@@ -1,20 +1,34 @@
 #include <stddef.h>
 #include <stdlib.h>
-#include <argp.h>
 #include <pthread.h>
 #include "err.h"
 
 #include "generic_queue.h"
 
+// Pojemność pierwszego segmentu i największa pojemność segmentu (potęgi dwójki).
+#define SEGMENT_MIN_SIZE (8)
+#define SEGMENT_MAX_SIZE (1024)
+
+/* Kolejka jest listą segmentów, z których każdy jest buforem cyklicznym
+ * o pojemności będącej potęgą dwójki, więc indeks wyznacza maska zamiast '%'.
+ * Gdy ostatni segment jest pełny, dokładamy nowy, dwa razy większy (do
+ * SEGMENT_MAX_SIZE), zamiast przepisywać elementy, a opróżniony pierwszy
+ * segment zwalniamy. Pusta kolejka zajmuje więc tylko SEGMENT_MIN_SIZE komórek. */
+typedef struct segment {
+    size_t capacity;
+    size_t first;   // Indeks pierwszego elementu, przed nałożeniem maski.
+    size_t count;
+    struct segment *next;
+    void *elements[];
+} segment_t;
+
 struct queue {
-     size_t max_size;   /* Liczba dostępnych do zajęcia komórek
-                         * w pamięci (Maksymalny rozmiar 'elements') */
-     size_t curr_size;  // Aktualna liczba zajętych komórek w kolejce
-     size_t curr_index; //
-     size_t first_index;
+     size_t curr_size;  // Aktualna liczba elementów we wszystkich segmentach
      size_t limit;
+     segment_t *head;   // Segment, z którego zdejmujemy elementy
+     segment_t *tail;   // Segment, do którego dokładamy elementy
+     segment_t *spare;  // Ostatnio zwolniony segment, do ponownego użycia
      pthread_mutex_t q_mutex;
-     void **elements;
 };
 
 static void *safe_malloc(size_t size) {
@@ -27,72 +41,56 @@ static void *safe_malloc(size_t size) {
     return space;
 }
 
-void free_queue(generic_queue* q) {
-    int res;
-    if (q) {
-        if (q->elements) {
-            for (size_t i = 0; i < q->max_size; i++) {
-                if (q->elements[i]) {
-                    free(q->elements[i]);
-                }
-            }
-
-            free(q->elements);
-        }
-
-        if ((res = pthread_mutex_destroy(&q->q_mutex)) != 0) {
-            syserr(res, "Destroying mutex failed!\n");
-        }
+static segment_t *create_segment(generic_queue *q, size_t capacity) {
+    segment_t *segment;
 
-        free(q);
+    if (q->spare != NULL && q->spare->capacity == capacity) {
+        segment = q->spare;
+        q->spare = NULL;
     }
-}
-
-void swap(void **ptr1, void **ptr2) {
-    void *tmp = *ptr1;
-    *ptr1 = *ptr2;
-    *ptr2 = tmp;
-}
-
-void reverese(generic_queue *q, size_t l, size_t r) {
-    if (l >= r) {
-        return;
+    else {
+        segment = safe_malloc(sizeof (segment_t) + sizeof (void *) * capacity);
+        segment->capacity = capacity;
     }
 
-    size_t mid = (l + r) / 2;
+    segment->first = 0;
+    segment->count = 0;
+    segment->next = NULL;
 
-    for (size_t i = l; i <= mid; i++) {
-        swap(&q->elements[i], &q->elements[r - i]);
-    }
+    return segment;
 }
 
-void cyclic_shift(generic_queue *q, size_t k) {
-    reverese(q, 0, k - 1);
-    reverese(q, k, q->max_size - 1);
-    reverese(q, 0, q->max_size - 1);
+// Zwalnia pusty segment, zachowując go jako zapasowy.
+static void release_segment(generic_queue *q, segment_t *segment) {
+    free(q->spare);
+    q->spare = segment;
 }
 
-void size_up(generic_queue *q) {
-    if (q->first_index > 0) {
-        cyclic_shift(q, q->first_index);
-    }
+static void *segment_at(segment_t *segment, size_t i) {
+    return segment->elements[(segment->first + i) & (segment->capacity - 1)];
+}
 
-    q->max_size *= 2;
+void free_queue(generic_queue* q) {
+    int res;
+    if (q) {
+        while (q->head != NULL) {
+            segment_t *next = q->head->next;
 
-    void* tmp = realloc(q->elements, q->max_size * (sizeof (void *)));
+            for (size_t i = 0; i < q->head->count; i++) {
+                free(segment_at(q->head, i));
+            }
 
-    if (!tmp) {
-        free_queue(q);
-        exit(1);
-    }
-    else {
-        q->elements = tmp;
-        q->curr_index = q->curr_size;
-        q->first_index = 0;
+            free(q->head);
+            q->head = next;
+        }
+
+        free(q->spare);
 
-        for (size_t i = q->curr_index; i < q->max_size; i++) {
-            q->elements[i] = NULL;
+        if ((res = pthread_mutex_destroy(&q->q_mutex)) != 0) {
+            syserr(res, "Destroying mutex failed!\n");
         }
+
+        free(q);
     }
 }
 
@@ -119,20 +117,11 @@ generic_queue* create_queue(void *limit) {
 
     new_queue = safe_malloc(sizeof (struct queue));
 
-    if (!new_queue) {
-        return NULL;
-    }
-
-    new_queue->max_size = 1024;
     new_queue->curr_size = 0;
-    new_queue->first_index = 0;
-    new_queue->curr_index = 0;
     new_queue->limit = limit == NULL ? 0 : (size_t) limit;
-    new_queue->elements = safe_malloc((sizeof (void*)) * new_queue->max_size);
-
-    for (size_t i = new_queue->curr_index; i < new_queue->max_size; i++) {
-        new_queue->elements[i] = NULL;
-    }
+    new_queue->spare = NULL;
+    new_queue->head = create_segment(new_queue, SEGMENT_MIN_SIZE);
+    new_queue->tail = new_queue->head;
 
     if ((res = pthread_mutex_init(&new_queue->q_mutex, NULL)) != 0) {
         syserr(res, "Mutex initialization failed!\n");
@@ -149,13 +138,19 @@ int queue_add(generic_queue *q, void *arg) {
         return -1;
     }
 
-    if (q->curr_size == q->max_size) {
-        size_up(q);
+    segment_t *tail = q->tail;
+
+    if (tail->count == tail->capacity) {
+        size_t capacity = tail->capacity < SEGMENT_MAX_SIZE ? tail->capacity * 2 : SEGMENT_MAX_SIZE;
+
+        tail->next = create_segment(q, capacity);
+        tail = tail->next;
+        q->tail = tail;
     }
 
+    tail->elements[(tail->first + tail->count) & (tail->capacity - 1)] = arg;
+    tail->count++;
     q->curr_size++;
-    q->elements[q->curr_index] = arg;
-    q->curr_index = (q->curr_index + 1) % q->max_size;
 
     queue_unlock_mutex(q);
     return 0;
@@ -165,28 +160,54 @@ int is_empty(generic_queue *q) {
     return q->curr_size == 0;
 }
 
+// Zdejmuje pierwszy element niepustej kolejki. Wymaga mutexa kolejki.
+static void *pop_locked(generic_queue *q) {
+    segment_t *head = q->head;
+    void *out = head->elements[head->first & (head->capacity - 1)];
+
+    head->first++;
+    head->count--;
+    q->curr_size--;
+
+    if (head->count == 0 && head->next != NULL) {
+        q->head = head->next;
+        release_segment(q, head);
+    }
+
+    return out;
+}
+
 void *queue_pop(generic_queue *q) {
+    void *out = NULL;
+
     queue_lock_mutex(q);
 
     if (!is_empty(q)) {
-        void *out = q->elements[q->first_index];
+        out = pop_locked(q);
+    }
 
-        q->curr_size--;
-        q->elements[q->first_index] = NULL;
-        q->first_index = (q->first_index + 1) % q->max_size;
-        queue_unlock_mutex(q);
+    queue_unlock_mutex(q);
 
-        return out;
-    }
-    else {
+    return out;
+}
+
+int queue_try_pop(generic_queue *q, void **out) {
+    queue_lock_mutex(q);
+
+    if (is_empty(q)) {
         queue_unlock_mutex(q);
-        return NULL;
+        return -1;
     }
+
+    *out = pop_locked(q);
+    queue_unlock_mutex(q);
+
+    return 0;
 }
 
 void *queue_peek(generic_queue *q) {
     if (!is_empty(q)) {
-        return q->elements[q->first_index];
+        return segment_at(q->head, 0);
     }
     else {
         return NULL;
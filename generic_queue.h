@@ -1,6 +1,8 @@
 #ifndef CACTI_GENERIC_QUEUE_H
 #define CACTI_GENERIC_QUEUE_H
 
+#include <stddef.h>
+
 /* Implementacja współbieżnej kolejki generycznej,
  * operacje krytyczne które modyfikują zawartosć kolejki są opatrzone dostępem do mutexa */
 
@@ -23,6 +25,11 @@ void* queue_peek(generic_queue *q);
 
 void* queue_pop(generic_queue *q);
 
+/* Zdejmuje element z kolejki i zapisuje go pod 'out'. Zwraca 0 jeżeli
+ * udało się zdjąć element, w.p.p (pusta kolejka) -1. W przeciwieństwie do
+ * queue_pop pozwala trzymać w kolejce wartości równe NULL (np. aktora o id 0). */
+int queue_try_pop(generic_queue *q, void **out);
+
 size_t queue_size(generic_queue *q);
 
 int is_empty(generic_queue *q);
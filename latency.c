@@ -0,0 +1,207 @@
+#include <stdlib.h>
+#include <pthread.h>
+#include "latency.h"
+#include "err.h"
+
+typedef struct role_latency {
+    const role_t *role;
+    size_t nprompts;
+    latency_histogram_t *histograms;
+    struct role_latency *next;
+} role_latency_t;
+
+struct latency_table {
+    pthread_mutex_t mutex;
+    role_latency_t *roles;
+};
+
+static void latency_lock(latency_table_t *table) {
+    int res;
+
+    if ((res = pthread_mutex_lock(&table->mutex)) != 0) {
+        syserr(res, "Latency mutex failed!\n");
+    }
+}
+
+static void latency_unlock(latency_table_t *table) {
+    int res;
+
+    if ((res = pthread_mutex_unlock(&table->mutex)) != 0) {
+        syserr(res, "Latency mutex failed!\n");
+    }
+}
+
+// Zwraca numer przedziału, do którego należy wartość 'value'.
+static size_t bucket_index(unsigned long long value) {
+    if (value < LATENCY_SUB_BUCKETS) {
+        return (size_t) value;
+    }
+
+    int msb = 63 - __builtin_clzll(value);
+    int shift = msb - LATENCY_SUB_BITS;
+
+    return (size_t) (msb - LATENCY_SUB_BITS + 1) * LATENCY_SUB_BUCKETS
+           + (size_t) ((value >> shift) & (LATENCY_SUB_BUCKETS - 1));
+}
+
+// Zwraca największą wartość należącą do przedziału 'index'.
+static unsigned long long bucket_high(size_t index) {
+    if (index < LATENCY_SUB_BUCKETS) {
+        return index;
+    }
+
+    int shift = (int) (index / LATENCY_SUB_BUCKETS) - 1;
+    unsigned long long low = (unsigned long long) (LATENCY_SUB_BUCKETS + index % LATENCY_SUB_BUCKETS) << shift;
+
+    return low + ((1ull << shift) - 1);
+}
+
+latency_table_t *latency_table_create() {
+    latency_table_t *table = malloc(sizeof (latency_table_t));
+    int res;
+
+    if (table == NULL) {
+        fatal("Memory allocation failure!\n");
+    }
+
+    if ((res = pthread_mutex_init(&table->mutex, NULL)) != 0) {
+        syserr(res, "Latency mutex init failed!\n");
+    }
+
+    table->roles = NULL;
+
+    return table;
+}
+
+void latency_table_destroy(latency_table_t *table) {
+    int res;
+
+    if (table == NULL) {
+        return;
+    }
+
+    while (table->roles != NULL) {
+        role_latency_t *next = table->roles->next;
+
+        free(table->roles->histograms);
+        free(table->roles);
+        table->roles = next;
+    }
+
+    if ((res = pthread_mutex_destroy(&table->mutex)) != 0) {
+        syserr(res, "Latency mutex destroy failed!\n");
+    }
+
+    free(table);
+}
+
+latency_histogram_t *latency_role_histograms(latency_table_t *table, const role_t *role) {
+    role_latency_t *entry;
+
+    latency_lock(table);
+
+    for (entry = table->roles; entry != NULL; entry = entry->next) {
+        if (entry->role == role) {
+            break;
+        }
+    }
+
+    if (entry == NULL) {
+        if ((entry = malloc(sizeof (role_latency_t))) == NULL ||
+            (entry->histograms = calloc(role->nprompts, sizeof (latency_histogram_t))) == NULL) {
+            fatal("Memory allocation failure!\n");
+        }
+
+        entry->role = role;
+        entry->nprompts = role->nprompts;
+        entry->next = table->roles;
+        table->roles = entry;
+    }
+
+    latency_unlock(table);
+
+    return entry->histograms;
+}
+
+void latency_record(latency_histogram_t *histogram, unsigned long long ns, bool slow) {
+    unsigned long long max = atomic_load_explicit(&histogram->max, memory_order_relaxed);
+
+    atomic_fetch_add_explicit(&histogram->buckets[bucket_index(ns)], 1, memory_order_relaxed);
+    atomic_fetch_add_explicit(&histogram->count, 1, memory_order_relaxed);
+    atomic_fetch_add_explicit(&histogram->sum, ns, memory_order_relaxed);
+
+    if (slow) {
+        atomic_fetch_add_explicit(&histogram->slow, 1, memory_order_relaxed);
+    }
+
+    while (max < ns &&
+           !atomic_compare_exchange_weak_explicit(&histogram->max, &max, ns,
+                                                  memory_order_relaxed, memory_order_relaxed)) {
+    }
+}
+
+/* Zwraca górną granicę przedziału, w którym leży 'rank'-ta (licząc od 1)
+ * najmniejsza wartość, ale nie więcej niż 'max'. */
+static unsigned long long percentile(const unsigned long long *buckets, unsigned long long rank,
+                                     unsigned long long max) {
+    unsigned long long seen = 0;
+
+    for (size_t i = 0; i < LATENCY_BUCKETS; i++) {
+        seen += buckets[i];
+
+        if (seen >= rank) {
+            unsigned long long high = bucket_high(i);
+
+            return high < max ? high : max;
+        }
+    }
+
+    return max;
+}
+
+bool latency_read(latency_table_t *table, const role_t *role, message_type_t message_type,
+                  latency_stats_t *stats) {
+    unsigned long long buckets[LATENCY_BUCKETS];
+    unsigned long long total = 0;
+    latency_histogram_t *histogram = NULL;
+
+    if (table == NULL) {
+        return false;
+    }
+
+    latency_lock(table);
+
+    for (role_latency_t *entry = table->roles; entry != NULL; entry = entry->next) {
+        if (entry->role == role && message_type >= 0 && (size_t) message_type < entry->nprompts) {
+            histogram = &entry->histograms[message_type];
+            break;
+        }
+    }
+
+    if (histogram == NULL) {
+        latency_unlock(table);
+        return false;
+    }
+
+    /* Liczniki mogą się zmieniać w trakcie odczytu, więc percentyle liczymy
+     * względem sumy odczytanych przedziałów, a nie pola 'count'. */
+    for (size_t i = 0; i < LATENCY_BUCKETS; i++) {
+        buckets[i] = atomic_load_explicit(&histogram->buckets[i], memory_order_relaxed);
+        total += buckets[i];
+    }
+
+    stats->count = atomic_load_explicit(&histogram->count, memory_order_relaxed);
+    stats->slow = atomic_load_explicit(&histogram->slow, memory_order_relaxed);
+    stats->max_ns = atomic_load_explicit(&histogram->max, memory_order_relaxed);
+    stats->mean_ns = stats->count == 0 ? 0 :
+            atomic_load_explicit(&histogram->sum, memory_order_relaxed) / stats->count;
+
+    latency_unlock(table);
+
+    stats->p50_ns = total == 0 ? 0 : percentile(buckets, (total + 1) / 2, stats->max_ns);
+    stats->p90_ns = total == 0 ? 0 : percentile(buckets, (total * 90 + 99) / 100, stats->max_ns);
+    stats->p99_ns = total == 0 ? 0 : percentile(buckets, (total * 99 + 99) / 100, stats->max_ns);
+    stats->p999_ns = total == 0 ? 0 : percentile(buckets, (total * 999 + 999) / 1000, stats->max_ns);
+
+    return true;
+}
@@ -0,0 +1,45 @@
+#ifndef CACTI_LATENCY_H
+#define CACTI_LATENCY_H
+
+#include <stdbool.h>
+#include <stdatomic.h>
+#include "cacti.h"
+
+/* Histogramy czasu wykonania obsług komunikatów, osobne dla każdej pary
+ * (rola, typ komunikatu). Przedziały są logarytmiczno-liniowe, jak w HDR
+ * Histogram: każda potęga dwójki jest podzielona na LATENCY_SUB_BUCKETS równych
+ * części, więc błąd względny odczytanego percentyla nie przekracza 1/8. */
+
+#define LATENCY_SUB_BITS (3)
+#define LATENCY_SUB_BUCKETS (1 << LATENCY_SUB_BITS)
+#define LATENCY_BUCKETS ((64 - LATENCY_SUB_BITS + 1) * LATENCY_SUB_BUCKETS)
+
+typedef struct latency_histogram {
+    atomic_ullong count;
+    atomic_ullong sum;
+    atomic_ullong max;
+    atomic_ullong slow;
+    atomic_ullong buckets[LATENCY_BUCKETS];
+} latency_histogram_t;
+
+// Histogramy jednego systemu aktorów, dla wszystkich jego ról.
+typedef struct latency_table latency_table_t;
+
+latency_table_t *latency_table_create();
+
+// Zwalnia tablicę razem z histogramami wszystkich ról.
+void latency_table_destroy(latency_table_t *table);
+
+/* Zwraca tablicę histogramów roli 'role', indeksowaną typem komunikatu,
+ * tworząc ją przy pierwszym wywołaniu dla danej roli. */
+latency_histogram_t *latency_role_histograms(latency_table_t *table, const role_t *role);
+
+// Dolicza czas 'ns' do histogramu. Bezpieczne dla wielu wątków.
+void latency_record(latency_histogram_t *histogram, unsigned long long ns, bool slow);
+
+/* Zapisuje podsumowanie histogramu komunikatu 'message_type' roli 'role'.
+ * Zwraca false, jeżeli dla tej roli nic nie zmierzono. */
+bool latency_read(latency_table_t *table, const role_t *role, message_type_t message_type,
+                  latency_stats_t *stats);
+
+#endif //CACTI_LATENCY_H
@@ -22,9 +22,12 @@ static act_t first_act[6] = {&first_hello, &get_notify, &get_info, &calculate, &
 
 static act_t default_act[6] = {&hello, &get_notify, &get_info, &calculate, &notify_father, &end};
 
-static role_t first_role = {.nprompts = 6, .prompts = first_act};
+// Obliczanie wiersza czeka, więc wykonuje się poza wątkami puli.
+static const bool blocking_act[6] = {[MSG_CALC] = true};
 
-static role_t default_role = {.nprompts = 6, .prompts = default_act};
+static role_t first_role = {.nprompts = 6, .prompts = first_act, .blocking = blocking_act};
+
+static role_t default_role = {.nprompts = 6, .prompts = default_act, .blocking = blocking_act};
 
 typedef struct matrix_val {
     int val;
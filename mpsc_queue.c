@@ -0,0 +1,161 @@
+#include <stdlib.h>
+#include <sched.h>
+#include "err.h"
+
+#include "mpsc_queue.h"
+
+void mpsc_init(mpsc_queue *q) {
+    atomic_init(&q->stub.next, NULL);
+    atomic_init(&q->head, &q->stub);
+    q->tail = &q->stub;
+    atomic_init(&q->size, 0);
+}
+
+/* Podpina węzeł na koniec listy. Pomiędzy zamianą 'head' a ustawieniem 'next'
+ * poprzednika lista jest chwilowo rozerwana, co konsument musi obsłużyć. */
+static void mpsc_link(mpsc_queue *q, mpsc_node_t *node) {
+    atomic_store_explicit(&node->next, NULL, memory_order_relaxed);
+
+    mpsc_node_t *prev = atomic_exchange_explicit(&q->head, node, memory_order_acq_rel);
+
+    atomic_store_explicit(&prev->next, node, memory_order_release);
+}
+
+/* Rezerwuje w liczniku miejsce na co najwyżej 'n' elementów i zwraca, na ile.
+ * Licznik nigdy nie przekracza limitu, nawet chwilowo, więc każdy wliczony
+ * element zostanie podpięty, na co może bezpiecznie czekać konsument. */
+static size_t mpsc_reserve(mpsc_queue *q, size_t n, size_t limit) {
+    size_t old_size;
+    size_t accepted;
+
+    if (limit == 0) {
+        atomic_fetch_add(&q->size, n);
+        return n;
+    }
+
+    old_size = atomic_load(&q->size);
+
+    do {
+        if (old_size >= limit) {
+            return 0;
+        }
+
+        accepted = limit - old_size < n ? limit - old_size : n;
+    } while (!atomic_compare_exchange_weak(&q->size, &old_size, old_size + accepted));
+
+    return accepted;
+}
+
+int mpsc_add(mpsc_queue *q, mpsc_node_t *node, size_t limit) {
+    if (mpsc_reserve(q, 1, limit) == 0) {
+        return -1;
+    }
+
+    mpsc_link(q, node);
+
+    return 0;
+}
+
+size_t mpsc_add_chain(mpsc_queue *q, mpsc_node_t *first, size_t n, size_t limit, mpsc_node_t **rest) {
+    size_t accepted;
+    mpsc_node_t *last = first;
+
+    *rest = NULL;
+
+    if (n == 0) {
+        return 0;
+    }
+
+    if ((accepted = mpsc_reserve(q, n, limit)) == 0) {
+        *rest = first;
+        return 0;
+    }
+
+    for (size_t i = 1; i < accepted; i++) {
+        last = atomic_load_explicit(&last->next, memory_order_relaxed);
+    }
+
+    *rest = atomic_load_explicit(&last->next, memory_order_relaxed);
+    atomic_store_explicit(&last->next, NULL, memory_order_relaxed);
+
+    mpsc_node_t *prev = atomic_exchange_explicit(&q->head, last, memory_order_acq_rel);
+
+    atomic_store_explicit(&prev->next, first, memory_order_release);
+
+    return accepted;
+}
+
+/* Próba zdjęcia elementu, zwraca NULL również wtedy, gdy producent
+ * jest w trakcie podpinania kolejnego węzła. */
+static mpsc_node_t *mpsc_try_pop(mpsc_queue *q) {
+    mpsc_node_t *tail = q->tail;
+    mpsc_node_t *next = atomic_load_explicit(&tail->next, memory_order_acquire);
+
+    if (tail == &q->stub) {
+        if (next == NULL) {
+            return NULL;
+        }
+
+        q->tail = next;
+        tail = next;
+        next = atomic_load_explicit(&tail->next, memory_order_acquire);
+    }
+
+    if (next != NULL) {
+        q->tail = next;
+        return tail;
+    }
+
+    if (tail != atomic_load_explicit(&q->head, memory_order_acquire)) {
+        return NULL;
+    }
+
+    mpsc_link(q, &q->stub);
+
+    next = atomic_load_explicit(&tail->next, memory_order_acquire);
+
+    if (next != NULL) {
+        q->tail = next;
+        return tail;
+    }
+
+    return NULL;
+}
+
+mpsc_node_t *mpsc_pop(mpsc_queue *q) {
+    mpsc_node_t *out;
+
+    if (atomic_load(&q->size) == 0) {
+        return NULL;
+    }
+
+    /* Licznik mówi, że element jest (lub za chwilę będzie) w kolejce,
+     * więc czekamy aż producent skończy go podpinać. */
+    while ((out = mpsc_try_pop(q)) == NULL) {
+        sched_yield();
+    }
+
+    atomic_fetch_sub(&q->size, 1);
+
+    return out;
+}
+
+size_t mpsc_size(mpsc_queue *q) {
+    return atomic_load(&q->size);
+}
+
+int mpsc_is_empty(mpsc_queue *q) {
+    return atomic_load(&q->size) == 0;
+}
+
+void mpsc_clear(mpsc_queue *q, void (*destroy)(mpsc_node_t *)) {
+    mpsc_node_t *node;
+
+    while ((node = mpsc_try_pop(q)) != NULL) {
+        if (destroy) {
+            destroy(node);
+        }
+    }
+
+    atomic_store(&q->size, 0);
+}
@@ -0,0 +1,54 @@
+#ifndef CACTI_MPSC_QUEUE_H
+#define CACTI_MPSC_QUEUE_H
+
+#include <stddef.h>
+#include <stdatomic.h>
+
+/* Implementacja nieblokującej kolejki intruzywnej typu "wielu producentów,
+ * jeden konsument" (algorytm D. Vyukova). Elementy kolejki zawierają w sobie
+ * węzeł 'mpsc_node_t', więc dodanie elementu nie alokuje pamięci. Dodawać
+ * elementy może jednocześnie dowolnie wiele wątków, natomiast zdejmować
+ * je może w danej chwili tylko jeden wątek. */
+
+typedef struct mpsc_node {
+    _Atomic(struct mpsc_node *) next;
+} mpsc_node_t;
+
+/* Struktura jest jawna, żeby kolejkę można było osadzić w innej strukturze
+ * (np. w stanie aktora) bez osobnej alokacji. Kolejka nie może być przenoszona
+ * w pamięci, bo węzeł 'stub' jest częścią listy. */
+typedef struct mpsc_queue {
+    _Atomic(mpsc_node_t *) head; // Ostatnio dodany element, modyfikowany przez producentów.
+    mpsc_node_t *tail;           // Najstarszy element, należy do konsumenta.
+    mpsc_node_t stub;            // Węzeł pomocniczy, dzięki któremu kolejka nigdy nie jest pusta.
+    atomic_size_t size;          /* Liczba elementów, wliczając te, które producent
+                                  * zarezerwował, ale jeszcze nie podpiął do listy. */
+} mpsc_queue;
+
+// Inicjalizuje pustą kolejkę w miejscu.
+void mpsc_init(mpsc_queue *q);
+
+/* Dodaje element do kolejki, jeżeli ma ona mniej niż 'limit' elementów
+ * (limit = 0 oznacza brak limitu). Zwraca 0 jeżeli poprawnie dodano element,
+ * w.p.p -1. Bezpieczne dla wielu producentów. */
+int mpsc_add(mpsc_queue *q, mpsc_node_t *node, size_t limit);
+
+/* Dodaje naraz łańcuch 'n' elementów połączonych polami 'next' (ostatni musi
+ * mieć next = NULL), jedną operacją atomową na końcu kolejki. Jeżeli w kolejce
+ * nie zmieszczą się wszystkie, dodaje tylko początek łańcucha, a pozostałą
+ * część zapisuje pod 'rest' (w.p.p. NULL). Zwraca liczbę dodanych elementów. */
+size_t mpsc_add_chain(mpsc_queue *q, mpsc_node_t *first, size_t n, size_t limit, mpsc_node_t **rest);
+
+/* Zdejmuje element z początku kolejki, lub zwraca NULL gdy kolejka jest pusta.
+ * Może być wołane tylko przez jednego konsumenta naraz. */
+mpsc_node_t *mpsc_pop(mpsc_queue *q);
+
+size_t mpsc_size(mpsc_queue *q);
+
+int mpsc_is_empty(mpsc_queue *q);
+
+/* Opróżnia kolejkę, wywołując 'destroy' na każdym pozostałym w niej elemencie.
+ * Nie może być wywołane współbieżnie z innymi operacjami. */
+void mpsc_clear(mpsc_queue *q, void (*destroy)(mpsc_node_t *));
+
+#endif //CACTI_MPSC_QUEUE_H
@@ -0,0 +1,48 @@
+#include <stdatomic.h>
+#include <stdlib.h>
+#include "cacti.h"
+#include "err.h"
+
+/* Nagłówek bufora leży tuż przed danymi. Wyrównanie nagłówka sprawia,
+ * że dane są wyrównane tak, jak pamięć z malloc. */
+typedef struct shared_header {
+    _Alignas(max_align_t) atomic_size_t refs;
+    size_t size;
+} shared_header_t;
+
+static shared_header_t *header_of(const void *buffer) {
+    return (shared_header_t *) buffer - 1;
+}
+
+void *shared_alloc(size_t size) {
+    shared_header_t *header = malloc(sizeof (shared_header_t) + size);
+
+    if (header == NULL) {
+        fatal("Shared buffer allocation failed!\n");
+    }
+
+    atomic_init(&header->refs, 1);
+    header->size = size;
+
+    return header + 1;
+}
+
+void *shared_retain(void *buffer) {
+    atomic_fetch_add_explicit(&header_of(buffer)->refs, 1, memory_order_relaxed);
+
+    return buffer;
+}
+
+void shared_release(void *buffer) {
+    shared_header_t *header = header_of(buffer);
+
+    // Ostatni właściciel musi widzieć wszystkie wcześniejsze odczyty pozostałych.
+    if (atomic_fetch_sub_explicit(&header->refs, 1, memory_order_release) == 1) {
+        atomic_thread_fence(memory_order_acquire);
+        free(header);
+    }
+}
+
+size_t shared_size(const void *buffer) {
+    return header_of(buffer)->size;
+}
@@ -0,0 +1,99 @@
+#define _GNU_SOURCE
+#include "minunit.h"
+#include "cacti.h"
+
+#include <sched.h>
+#include <stdio.h>
+
+int tests_run = 0;
+
+static cpu_set_t seen;
+static int seen_count;
+
+static void hello(void **stateptr, size_t nbytes, void *data)
+{
+    (void) stateptr; (void) nbytes; (void) data;
+
+    sched_getaffinity(0, sizeof seen, &seen);
+    seen_count = CPU_COUNT(&seen);
+    send_message(actor_id_self(), (message_t){.message_type = MSG_GODIE});
+}
+
+static act_t acts[] = {&hello};
+static role_t role = {.nprompts = 1, .prompts = acts};
+
+static void run(const int *cpus, size_t ncpus)
+{
+    actor_system_config_t config = {.pool_size = 1, .affinity = AFFINITY_CPU, .cpus = cpus, .ncpus = ncpus};
+    actor_id_t first;
+
+    seen_count = 0;
+    actor_system_create_ex(&first, &role, &config);
+    actor_system_join(first);
+}
+
+static int first_allowed(const cpu_set_t *allowed)
+{
+    for (int cpu = 0; cpu < CPU_SETSIZE; cpu++) {
+        if (CPU_ISSET(cpu, allowed)) {
+            return cpu;
+        }
+    }
+
+    return -1;
+}
+
+static char *listed_cpu_is_pinned()
+{
+    cpu_set_t allowed;
+    int cpu;
+
+    mu_assert("allowed", sched_getaffinity(0, sizeof allowed, &allowed) == 0);
+    cpu = first_allowed(&allowed);
+
+    run(&cpu, 1);
+
+    mu_assert("one cpu", seen_count == 1 && CPU_ISSET(cpu, &seen));
+    return 0;
+}
+
+// Procesor spoza dozwolonych nie przerywa tworzenia systemu, wątek działa nieprzypięty.
+static char *disallowed_cpu_runs_unpinned()
+{
+    cpu_set_t allowed;
+    int cpu = CPU_SETSIZE - 1;
+
+    mu_assert("allowed", sched_getaffinity(0, sizeof allowed, &allowed) == 0);
+
+    if (CPU_ISSET(cpu, &allowed)) {
+        return 0;
+    }
+
+    run(&cpu, 1);
+
+    mu_assert("unpinned", seen_count == CPU_COUNT(&allowed) && !CPU_ISSET(cpu, &seen));
+    return 0;
+}
+
+static char *all_tests()
+{
+    mu_run_test(listed_cpu_is_pinned);
+    mu_run_test(disallowed_cpu_runs_unpinned);
+    return 0;
+}
+
+int main()
+{
+    char *result = all_tests();
+    if (result != 0)
+    {
+        printf(__FILE__ ": %s\n", result);
+    }
+    else
+    {
+        printf(__FILE__ ": ALL TESTS PASSED\n");
+    }
+    printf(__FILE__ ": Tests run: %d\n", tests_run);
+
+    return result != 0;
+}
@@ -0,0 +1,127 @@
+#include "minunit.h"
+#include "cacti.h"
+
+#include <stdbool.h>
+#include <stdio.h>
+
+#define MSG_COUNT (1)
+#define MSG_CHILD_COUNT (1)
+#define BATCH (100)
+#define CHILDREN (4)
+
+int tests_run = 0;
+
+static role_t child_role;
+
+static long counted;
+static bool in_order = true;
+static long child_counted[CHILDREN];
+static actor_id_t children[CHILDREN];
+static int spawned;
+
+static void first_hello(void **stateptr, size_t nbytes, void *data)
+{
+    (void) stateptr; (void) nbytes; (void) data;
+
+    message_t batch[BATCH];
+
+    for (long i = 0; i < BATCH; i++) {
+        batch[i] = (message_t){.message_type = MSG_COUNT, .data = (void *) i};
+    }
+
+    send_messages(actor_id_self(), batch, BATCH);
+
+    for (int i = 0; i < CHILDREN; i++) {
+        send_message(actor_id_self(), (message_t){.message_type = MSG_SPAWN, .data = &child_role});
+    }
+}
+
+static void count(void **stateptr, size_t nbytes, void *data)
+{
+    (void) stateptr; (void) nbytes;
+
+    if ((long) data != counted) {
+        in_order = false;
+    }
+
+    counted++;
+}
+
+static void child_hello(void **stateptr, size_t nbytes, void *data)
+{
+    (void) stateptr; (void) nbytes;
+
+    actor_id_t father = (actor_id_t) data;
+
+    send_message(father, (message_t){.message_type = 2, .data = (void *) actor_id_self()});
+}
+
+static void child_count(void **stateptr, size_t nbytes, void *data)
+{
+    (void) stateptr; (void) nbytes; (void) data;
+
+    for (int i = 0; i < CHILDREN; i++) {
+        if (children[i] == actor_id_self()) {
+            child_counted[i]++;
+        }
+    }
+
+    send_message(actor_id_self(), (message_t){.message_type = MSG_GODIE});
+}
+
+static void child_ready(void **stateptr, size_t nbytes, void *data)
+{
+    (void) stateptr; (void) nbytes;
+
+    children[spawned++] = (actor_id_t) data;
+
+    if (spawned == CHILDREN) {
+        send_message_multicast(children, CHILDREN, (message_t){.message_type = MSG_CHILD_COUNT});
+        send_message(actor_id_self(), (message_t){.message_type = MSG_GODIE});
+    }
+}
+
+static act_t first_acts[] = {&first_hello, &count, &child_ready};
+static act_t child_acts[] = {&child_hello, &child_count};
+
+static role_t first_role = {.nprompts = 3, .prompts = first_acts};
+static role_t child_role = {.nprompts = 2, .prompts = child_acts};
+
+static char *batch_and_multicast()
+{
+    actor_id_t first;
+
+    mu_assert("create", actor_system_create(&first, &first_role) == 0);
+    actor_system_join(first);
+
+    mu_assert("batch delivered", counted == BATCH);
+    mu_assert("batch in order", in_order);
+
+    for (int i = 0; i < CHILDREN; i++) {
+        mu_assert("multicast delivered", child_counted[i] == 1);
+    }
+
+    return 0;
+}
+
+static char *all_tests()
+{
+    mu_run_test(batch_and_multicast);
+    return 0;
+}
+
+int main()
+{
+    char *result = all_tests();
+    if (result != 0)
+    {
+        printf(__FILE__ ": %s\n", result);
+    }
+    else
+    {
+        printf(__FILE__ ": ALL TESTS PASSED\n");
+    }
+    printf(__FILE__ ": Tests run: %d\n", tests_run);
+
+    return result != 0;
+}
@@ -0,0 +1,120 @@
+#include "minunit.h"
+#include "cacti.h"
+
+#include <stdbool.h>
+#include <stdio.h>
+#include <time.h>
+#include <unistd.h>
+
+#define MSG_SLEEP (1)
+#define MSG_STEP (2)
+#define CHILDREN (4)
+#define STEPS (10)
+#define SLEEP_US (200000)
+
+int tests_run = 0;
+
+static role_t role;
+
+static int steps[CHILDREN + 1];
+static bool out_of_order;
+
+static void hello(void **stateptr, size_t nbytes, void *data)
+{
+    (void) stateptr; (void) nbytes; (void) data;
+
+    if (actor_id_self() == 0) {
+        for (int i = 0; i < CHILDREN; i++) {
+            send_message(actor_id_self(), (message_t){.message_type = MSG_SPAWN, .data = &role});
+        }
+
+        send_message(actor_id_self(), (message_t){.message_type = MSG_GODIE});
+        return;
+    }
+
+    // Po blokującej obsłudze przychodzą zwykłe komunikaty, które muszą zaczekać na jej koniec.
+    send_message(actor_id_self(), (message_t){.message_type = MSG_SLEEP});
+
+    for (long i = 0; i < STEPS; i++) {
+        send_message(actor_id_self(), (message_t){.message_type = MSG_STEP, .data = (void *) i});
+    }
+
+    send_message(actor_id_self(), (message_t){.message_type = MSG_GODIE});
+}
+
+static void sleep_handler(void **stateptr, size_t nbytes, void *data)
+{
+    (void) stateptr; (void) nbytes; (void) data;
+
+    if (steps[actor_id_self()] != 0) {
+        out_of_order = true;
+    }
+
+    usleep(SLEEP_US);
+    steps[actor_id_self()] = -1;
+}
+
+static void step(void **stateptr, size_t nbytes, void *data)
+{
+    (void) stateptr; (void) nbytes;
+
+    int *done = &steps[actor_id_self()];
+
+    if ((*done == -1 ? 0 : *done) != (long) data) {
+        out_of_order = true;
+    }
+
+    *done = (int) (long) data + 1;
+}
+
+static act_t acts[] = {&hello, &sleep_handler, &step};
+static const bool blocking[3] = {[MSG_SLEEP] = true};
+static role_t role = {.nprompts = 3, .prompts = acts, .blocking = blocking};
+
+static char *offloaded()
+{
+    actor_system_config_t config = {.pool_size = 1};
+    struct timespec start, end;
+    actor_id_t first;
+
+    clock_gettime(CLOCK_MONOTONIC, &start);
+
+    mu_assert("create", actor_system_create_ex(&first, &role, &config) == 0);
+    actor_system_join(first);
+
+    clock_gettime(CLOCK_MONOTONIC, &end);
+
+    long elapsed_us = (end.tv_sec - start.tv_sec) * 1000000L + (end.tv_nsec - start.tv_nsec) / 1000;
+
+    mu_assert("messages in order", !out_of_order);
+
+    for (int i = 1; i <= CHILDREN; i++) {
+        mu_assert("all steps", steps[i] == STEPS);
+    }
+
+    // Jeden wątek puli wykonałby blokujące obsługi po kolei.
+    mu_assert("sleeps overlap", elapsed_us < CHILDREN * SLEEP_US);
+    return 0;
+}
+
+static char *all_tests()
+{
+    mu_run_test(offloaded);
+    return 0;
+}
+
+int main()
+{
+    char *result = all_tests();
+    if (result != 0)
+    {
+        printf(__FILE__ ": %s\n", result);
+    }
+    else
+    {
+        printf(__FILE__ ": ALL TESTS PASSED\n");
+    }
+    printf(__FILE__ ": Tests run: %d\n", tests_run);
+
+    return result != 0;
+}
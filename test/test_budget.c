@@ -0,0 +1,103 @@
+#include "minunit.h"
+#include "cacti.h"
+
+#include <stdbool.h>
+#include <stdio.h>
+
+#define MSG_COUNT (1)
+#define BATCH (100)
+
+int tests_run = 0;
+
+static long counted;
+
+static void hello(void **stateptr, size_t nbytes, void *data)
+{
+    (void) stateptr; (void) nbytes; (void) data;
+
+    message_t batch[BATCH];
+
+    for (long i = 0; i < BATCH; i++) {
+        batch[i] = (message_t){.message_type = MSG_COUNT};
+    }
+
+    batch[BATCH - 1].message_type = MSG_GODIE;
+
+    counted = 0;
+    send_messages(actor_id_self(), batch, BATCH);
+}
+
+static void count(void **stateptr, size_t nbytes, void *data)
+{
+    (void) stateptr; (void) nbytes; (void) data;
+
+    counted++;
+}
+
+static act_t acts[] = {&hello, &count};
+
+static char *run_with_budget(size_t budget, sched_stats_t *stats)
+{
+    role_t role = {.nprompts = 2, .prompts = acts, .budget = budget};
+    actor_id_t first;
+
+    mu_assert("create", actor_system_create(&first, &role) == 0);
+    actor_system_join(first);
+    actor_system_sched_stats(stats);
+
+    mu_assert("all messages executed", counted == BATCH - 1);
+    return 0;
+}
+
+static char *unlimited_budget()
+{
+    sched_stats_t stats;
+    char *result = run_with_budget(BUDGET_UNLIMITED, &stats);
+
+    if (result != 0) {
+        return result;
+    }
+
+    // MSG_HELLO i cała paczka wykonują się w jednym przetworzeniu.
+    mu_assert("single activation", stats.max_batch == BATCH + 1);
+    mu_assert("not preempted", stats.preemptions == 0);
+    return 0;
+}
+
+static char *budget_of_one()
+{
+    sched_stats_t stats;
+    char *result = run_with_budget(1, &stats);
+
+    if (result != 0) {
+        return result;
+    }
+
+    mu_assert("one message per activation", stats.max_batch == 1);
+    mu_assert("activation per message", stats.activations == BATCH + 1);
+    mu_assert("preempted", stats.preemptions > 0);
+    return 0;
+}
+
+static char *all_tests()
+{
+    mu_run_test(unlimited_budget);
+    mu_run_test(budget_of_one);
+    return 0;
+}
+
+int main()
+{
+    char *result = all_tests();
+    if (result != 0)
+    {
+        printf(__FILE__ ": %s\n", result);
+    }
+    else
+    {
+        printf(__FILE__ ": ALL TESTS PASSED\n");
+    }
+    printf(__FILE__ ": Tests run: %d\n", tests_run);
+
+    return result != 0;
+}
@@ -0,0 +1,139 @@
+#include "minunit.h"
+#include "cacti.h"
+
+#include <stdio.h>
+#include <string.h>
+#include <unistd.h>
+
+#define MSG_READY (1)
+#define ACTORS (1 << 17)
+#define WINDOW (1024)
+/* Stan aktora razem ze skrzynką to jedna linia pamięci, a do tego dochodzą
+ * tablice boczne i niezajęta jeszcze część ostatnich kawałków tablicy. */
+#define BYTES_PER_ACTOR (128)
+
+// Pamięć cieni sanitizerów liczy się do RSS, więc wtedy nie sprawdzamy obsady.
+#if defined(__SANITIZE_THREAD__) || defined(__SANITIZE_ADDRESS__)
+#define CHECK_FOOTPRINT (0)
+#else
+#define CHECK_FOOTPRINT (1)
+#endif
+
+int tests_run = 0;
+
+static actor_id_t cast[ACTORS];
+static size_t spawned;
+static size_t ready;
+static long rss_before_kb;
+static long rss_after_kb;
+
+static void root_hello(void **stateptr, size_t nbytes, void *data);
+static void root_ready(void **stateptr, size_t nbytes, void *data);
+static void member_hello(void **stateptr, size_t nbytes, void *data);
+
+static act_t root_acts[] = {&root_hello, &root_ready};
+static role_t root_role = {.nprompts = 2, .prompts = root_acts};
+static act_t member_acts[] = {&member_hello};
+static role_t member_role = {.nprompts = 1, .prompts = member_acts};
+
+// Bieżący RSS z /proc/self/statm, 0 gdy nie da się go odczytać.
+static long rss_kb()
+{
+    FILE *statm = fopen("/proc/self/statm", "r");
+    long pages = 0;
+
+    if (statm != NULL) {
+        if (fscanf(statm, "%*s %ld", &pages) != 1) {
+            pages = 0;
+        }
+
+        fclose(statm);
+    }
+
+    return pages * (sysconf(_SC_PAGESIZE) / 1024);
+}
+
+static void spawn_next()
+{
+    if (spawned < ACTORS) {
+        spawned++;
+        send_message(actor_id_self(), (message_t){.message_type = MSG_SPAWN, .data = &member_role});
+    }
+}
+
+// Naraz tworzymy co najwyżej WINDOW aktorów, żeby koperty MSG_SPAWN nie liczyły się do obsady.
+static void root_hello(void **stateptr, size_t nbytes, void *data)
+{
+    (void) stateptr; (void) nbytes; (void) data;
+
+    for (size_t i = 0; i < WINDOW; i++) {
+        spawn_next();
+    }
+}
+
+static void root_ready(void **stateptr, size_t nbytes, void *data)
+{
+    (void) stateptr; (void) nbytes;
+
+    cast[ready] = (actor_id_t) data;
+
+    if (++ready < ACTORS) {
+        spawn_next();
+        return;
+    }
+
+    rss_after_kb = rss_kb();
+
+    for (size_t i = 0; i < ACTORS; i++) {
+        send_message(cast[i], (message_t){.message_type = MSG_GODIE});
+    }
+
+    send_message(actor_id_self(), (message_t){.message_type = MSG_GODIE});
+}
+
+static void member_hello(void **stateptr, size_t nbytes, void *data)
+{
+    (void) stateptr; (void) nbytes;
+
+    send_message((actor_id_t) data, (message_t){.message_type = MSG_READY, .data = (void *) actor_id_self()});
+}
+
+/* Cała obsada żyje naraz, a RSS między startem systemu a zebraniem obsady
+ * rośnie o nie więcej niż BYTES_PER_ACTOR na aktora. */
+static char *many_live_actors()
+{
+    actor_system_config_t config = {.pool_size = 2};
+    actor_id_t root;
+
+    memset(cast, 0, sizeof cast);
+    rss_before_kb = rss_kb();
+
+    mu_assert("create", actor_system_create_ex(&root, &root_role, &config) == 0);
+    actor_system_join(root);
+
+    mu_assert("all ready", ready == ACTORS);
+    mu_assert("footprint", !CHECK_FOOTPRINT || (rss_after_kb - rss_before_kb) * 1024 / ACTORS <= BYTES_PER_ACTOR);
+    return 0;
+}
+
+static char *all_tests()
+{
+    mu_run_test(many_live_actors);
+    return 0;
+}
+
+int main()
+{
+    char *result = all_tests();
+    if (result != 0)
+    {
+        printf(__FILE__ ": %s\n", result);
+    }
+    else
+    {
+        printf(__FILE__ ": ALL TESTS PASSED\n");
+    }
+    printf(__FILE__ ": Tests run: %d\n", tests_run);
+
+    return result != 0;
+}
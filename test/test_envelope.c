@@ -0,0 +1,95 @@
+#include "minunit.h"
+#include "envelope_pool.h"
+
+#include <pthread.h>
+#include <stdbool.h>
+#include <stdio.h>
+
+// Tyle kopert mieści jeden blok pamięci puli.
+#define ENVELOPES (64)
+
+int tests_run = 0;
+
+static envelope_t *envelopes[ENVELOPES];
+
+static void *allocate(void *arg)
+{
+    (void) arg;
+
+    for (int i = 0; i < ENVELOPES; i++) {
+        envelopes[i] = envelope_alloc();
+        envelopes[i]->message = (message_t){.message_type = i};
+    }
+
+    return NULL;
+}
+
+// Zwalnia koperty innego wątku i kończy się bez envelope_pool_flush.
+static void *release(void *arg)
+{
+    (void) arg;
+
+    for (int i = 0; i < ENVELOPES; i++) {
+        if (envelopes[i]->message.message_type != (message_type_t) i) {
+            return (void *) 1;
+        }
+
+        envelope_free(envelopes[i]);
+    }
+
+    return NULL;
+}
+
+static bool allocated_before(envelope_t *env)
+{
+    for (int i = 0; i < ENVELOPES; i++) {
+        if (envelopes[i] == env) {
+            return true;
+        }
+    }
+
+    return false;
+}
+
+/* Koperty zaalokowane w jednym wątku i zwolnione w drugim wracają do wspólnej
+ * puli, gdy drugi wątek się kończy, więc kolejna alokacja ich używa zamiast
+ * nowego bloku pamięci. */
+static char *freed_on_other_thread()
+{
+    pthread_t thread;
+    void *result;
+
+    mu_assert("allocate", pthread_create(&thread, NULL, allocate, NULL) == 0);
+    pthread_join(thread, NULL);
+    mu_assert("release", pthread_create(&thread, NULL, release, NULL) == 0);
+    pthread_join(thread, &result);
+    mu_assert("contents", result == NULL);
+
+    for (int i = 0; i < ENVELOPES; i++) {
+        mu_assert("reused", allocated_before(envelope_alloc()));
+    }
+
+    return 0;
+}
+
+static char *all_tests()
+{
+    mu_run_test(freed_on_other_thread);
+    return 0;
+}
+
+int main()
+{
+    char *result = all_tests();
+    if (result != 0)
+    {
+        printf(__FILE__ ": %s\n", result);
+    }
+    else
+    {
+        printf(__FILE__ ": ALL TESTS PASSED\n");
+    }
+    printf(__FILE__ ": Tests run: %d\n", tests_run);
+
+    return result != 0;
+}
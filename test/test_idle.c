@@ -0,0 +1,114 @@
+#include "minunit.h"
+#include "cacti.h"
+
+#include <sched.h>
+#include <stdatomic.h>
+#include <stdbool.h>
+#include <stdio.h>
+#include <time.h>
+
+#define MSG_PING (1)
+#define POOL (2)
+
+int tests_run = 0;
+
+static atomic_bool sent;
+static atomic_bool pinged;
+static system_stats_t woken;
+
+static void hello(void **stateptr, size_t nbytes, void *data)
+{
+    (void) stateptr; (void) nbytes; (void) data;
+}
+
+// Kończy system dopiero, gdy wysyłka z głównego wątku się zakończyła.
+static void ping(void **stateptr, size_t nbytes, void *data)
+{
+    (void) stateptr; (void) nbytes; (void) data;
+
+    while (!sent) {
+        sched_yield();
+    }
+
+    pinged = true;
+    actor_system_stats(&woken);
+    send_message(actor_id_self(), (message_t){.message_type = MSG_GODIE});
+}
+
+static act_t acts[] = {&hello, &ping};
+static role_t role = {.nprompts = 2, .prompts = acts};
+
+/* Czeka, aż wszystkie wątki puli zasną, i wysyła wiadomość z wątku spoza puli.
+ * Wiadomość musi obudzić uśpiony wątek, więc liczba wybudzeń rośnie. */
+static char *wakes_parked(size_t spins, size_t yields)
+{
+    actor_system_config_t config = {.pool_size = POOL, .idle_spins = spins, .idle_yields = yields};
+    system_stats_t asleep;
+    actor_id_t first;
+
+    sent = false;
+    pinged = false;
+    mu_assert("create", actor_system_create_ex(&first, &role, &config) == 0);
+
+    do {
+        sched_yield();
+        actor_system_stats(&asleep);
+    } while (asleep.total.parks < POOL);
+
+    // Wątek mógł zasnąć, zanim inny go obudził; dajemy puli chwilę na uspokojenie.
+    nanosleep(&(struct timespec){.tv_nsec = 20000000}, NULL);
+    actor_system_stats(&asleep);
+
+    mu_assert("send", send_message(first, (message_t){.message_type = MSG_PING}) == 0);
+    sent = true;
+    actor_system_join(first);
+
+    mu_assert("handled", pinged);
+    mu_assert("woken", woken.total.wakeups > asleep.total.wakeups);
+    return 0;
+}
+
+static char *default_policy()
+{
+    return wakes_parked(0, 0);
+}
+
+static char *park_at_once()
+{
+    return wakes_parked(IDLE_NONE, IDLE_NONE);
+}
+
+static char *spin_only()
+{
+    return wakes_parked(16, IDLE_NONE);
+}
+
+static char *yield_only()
+{
+    return wakes_parked(IDLE_NONE, 4);
+}
+
+static char *all_tests()
+{
+    mu_run_test(default_policy);
+    mu_run_test(park_at_once);
+    mu_run_test(spin_only);
+    mu_run_test(yield_only);
+    return 0;
+}
+
+int main()
+{
+    char *result = all_tests();
+    if (result != 0)
+    {
+        printf(__FILE__ ": %s\n", result);
+    }
+    else
+    {
+        printf(__FILE__ ": ALL TESTS PASSED\n");
+    }
+    printf(__FILE__ ": Tests run: %d\n", tests_run);
+
+    return result != 0;
+}
@@ -0,0 +1,98 @@
+#include "minunit.h"
+#include "cacti.h"
+
+#include <stdbool.h>
+#include <stdio.h>
+#include <string.h>
+
+#define MSG_POINT (1)
+#define MSG_TEXT (2)
+
+typedef struct point {
+    long x;
+    long y;
+    double weight;
+} point_t;
+
+int tests_run = 0;
+
+static point_t received_point;
+static char received_text[MESSAGE_INLINE_LIMIT];
+static size_t received_nbytes;
+static int too_big_result;
+
+static void hello(void **stateptr, size_t nbytes, void *data)
+{
+    (void) stateptr; (void) nbytes; (void) data;
+
+    point_t point = {.x = 3, .y = -7, .weight = 0.5};
+    char text[] = "inline";
+    char too_big[MESSAGE_INLINE_LIMIT + 1] = {0};
+
+    send_value(actor_id_self(), MSG_POINT, point);
+
+    // Nadawca może od razu nadpisać swoją kopię danych.
+    point.x = 0;
+
+    send_message_inline(actor_id_self(), MSG_TEXT, text, sizeof text);
+    too_big_result = send_message_inline(actor_id_self(), MSG_TEXT, too_big, sizeof too_big);
+}
+
+static void get_point(void **stateptr, size_t nbytes, void *data)
+{
+    (void) stateptr; (void) nbytes;
+
+    received_point = message_value(point_t, data);
+}
+
+static void get_text(void **stateptr, size_t nbytes, void *data)
+{
+    (void) stateptr;
+
+    received_nbytes = nbytes;
+    memcpy(received_text, data, nbytes);
+
+    send_message(actor_id_self(), (message_t){.message_type = MSG_GODIE});
+}
+
+static act_t acts[] = {&hello, &get_point, &get_text};
+
+static role_t role = {.nprompts = 3, .prompts = acts};
+
+static char *inline_payload()
+{
+    actor_id_t first;
+
+    mu_assert("create", actor_system_create(&first, &role) == 0);
+    actor_system_join(first);
+
+    mu_assert("point x", received_point.x == 3);
+    mu_assert("point y", received_point.y == -7);
+    mu_assert("point weight", received_point.weight == 0.5);
+    mu_assert("text size", received_nbytes == sizeof "inline");
+    mu_assert("text", strcmp(received_text, "inline") == 0);
+    mu_assert("too big payload rejected", too_big_result != 0);
+    return 0;
+}
+
+static char *all_tests()
+{
+    mu_run_test(inline_payload);
+    return 0;
+}
+
+int main()
+{
+    char *result = all_tests();
+    if (result != 0)
+    {
+        printf(__FILE__ ": %s\n", result);
+    }
+    else
+    {
+        printf(__FILE__ ": ALL TESTS PASSED\n");
+    }
+    printf(__FILE__ ": Tests run: %d\n", tests_run);
+
+    return result != 0;
+}
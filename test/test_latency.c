@@ -0,0 +1,157 @@
+#include "minunit.h"
+#include "cacti.h"
+
+#include <stdbool.h>
+#include <stdio.h>
+#include <unistd.h>
+
+#define MSG_FAST (1)
+#define MSG_SLOW (2)
+#define FAST_COUNT (50)
+#define SLOW_US (2000)
+
+int tests_run = 0;
+
+static int slow_reported;
+static actor_id_t slow_actor;
+static message_type_t slow_type;
+
+static void hello(void **stateptr, size_t nbytes, void *data)
+{
+    (void) stateptr; (void) nbytes; (void) data;
+
+    for (int i = 0; i < FAST_COUNT; i++) {
+        send_message(actor_id_self(), (message_t){.message_type = MSG_FAST});
+    }
+
+    send_message(actor_id_self(), (message_t){.message_type = MSG_SLOW});
+    send_message(actor_id_self(), (message_t){.message_type = MSG_GODIE});
+}
+
+static void fast(void **stateptr, size_t nbytes, void *data)
+{
+    (void) stateptr; (void) nbytes; (void) data;
+}
+
+static void slow(void **stateptr, size_t nbytes, void *data)
+{
+    (void) stateptr; (void) nbytes; (void) data;
+
+    usleep(SLOW_US);
+}
+
+static void on_slow(actor_id_t actor, message_type_t message_type, unsigned long long ns)
+{
+    (void) ns;
+
+    slow_reported++;
+    slow_actor = actor;
+    slow_type = message_type;
+}
+
+static void quiet(void **stateptr, size_t nbytes, void *data)
+{
+    (void) stateptr; (void) nbytes; (void) data;
+}
+
+static act_t acts[] = {&hello, &fast, &slow};
+static role_t role = {.nprompts = 3, .prompts = acts};
+
+static act_t shared_acts[] = {&quiet, &fast};
+static role_t shared_role = {.nprompts = 2, .prompts = shared_acts};
+
+static char *histograms()
+{
+    actor_system_config_t config = {.latency = true, .slow_handler_us = SLOW_US / 2, .slow_handler = &on_slow};
+    latency_stats_t stats;
+    actor_id_t first;
+
+    mu_assert("create", actor_system_create_ex(&first, &role, &config) == 0);
+    actor_system_join(first);
+
+    mu_assert("fast measured", actor_system_latency(&role, MSG_FAST, &stats) == 0);
+    mu_assert("fast count", stats.count == FAST_COUNT);
+    mu_assert("fast percentiles ordered", stats.p50_ns <= stats.p99_ns && stats.p99_ns <= stats.max_ns);
+
+    mu_assert("slow measured", actor_system_latency(&role, MSG_SLOW, &stats) == 0);
+    mu_assert("slow count", stats.count == 1 && stats.slow == 1);
+    mu_assert("slow duration", stats.p50_ns >= SLOW_US * 1000ull);
+
+    mu_assert("slow reported once", slow_reported == 1);
+    mu_assert("slow actor", slow_actor == first && slow_type == MSG_SLOW);
+    mu_assert("no such message", actor_system_latency(&role, 3, &stats) != 0);
+    return 0;
+}
+
+static char *disabled()
+{
+    actor_system_config_t config = {0};
+    latency_stats_t stats;
+    actor_id_t first;
+
+    mu_assert("create", actor_system_create_ex(&first, &role, &config) == 0);
+    actor_system_join(first);
+
+    mu_assert("not measured", actor_system_latency(&role, MSG_FAST, &stats) != 0);
+    return 0;
+}
+
+static char *systems_separate()
+{
+    actor_system_config_t config = {.pool_size = 1, .latency = true};
+    cacti_system_t *systems[2];
+    actor_id_t actors[2];
+    latency_stats_t stats;
+
+    // Dwa systemy z tą samą rolą działają naraz, ale mierzą osobno.
+    for (int i = 0; i < 2; i++) {
+        mu_assert("create", cacti_system_create(&systems[i], &actors[i], &shared_role, &config) == 0);
+    }
+
+    for (int i = 0; i < 2; i++) {
+        for (int j = 0; j < FAST_COUNT * (i + 1); j++) {
+            mu_assert("send", cacti_send_message(systems[i], actors[i], (message_t){.message_type = MSG_FAST}) == 0);
+        }
+
+        cacti_send_message(systems[i], actors[i], (message_t){.message_type = MSG_GODIE});
+    }
+
+    for (int i = 0; i < 2; i++) {
+        cacti_system_join(systems[i]);
+    }
+
+    mu_assert("first measured", cacti_system_latency(systems[0], &shared_role, MSG_FAST, &stats) == 0);
+    mu_assert("first count", stats.count == FAST_COUNT);
+    mu_assert("second measured", cacti_system_latency(systems[1], &shared_role, MSG_FAST, &stats) == 0);
+    mu_assert("second count", stats.count == 2 * FAST_COUNT);
+
+    for (int i = 0; i < 2; i++) {
+        cacti_system_free(systems[i]);
+    }
+
+    return 0;
+}
+
+static char *all_tests()
+{
+    mu_run_test(histograms);
+    mu_run_test(disabled);
+    mu_run_test(systems_separate);
+    return 0;
+}
+
+int main()
+{
+    char *result = all_tests();
+    if (result != 0)
+    {
+        printf(__FILE__ ": %s\n", result);
+    }
+    else
+    {
+        printf(__FILE__ ": ALL TESTS PASSED\n");
+    }
+    printf(__FILE__ ": Tests run: %d\n", tests_run);
+
+    return result != 0;
+}
@@ -0,0 +1,196 @@
+#include "minunit.h"
+#include "mpsc_queue.h"
+
+#include <pthread.h>
+#include <stdatomic.h>
+#include <stdio.h>
+
+#define PRODUCERS (4)
+#define ADDS (20000)
+#define LIMIT (4)
+
+int tests_run = 0;
+
+// Węzeł jest pierwszym polem, więc wskaźnik na węzeł wskazuje też na element.
+typedef struct item {
+    mpsc_node_t node;
+    int producer;
+    int seq;
+} item_t;
+
+static item_t items[PRODUCERS][ADDS];
+
+static char *fifo_with_limit()
+{
+    mpsc_queue q;
+
+    mpsc_init(&q);
+
+    for (int i = 0; i < LIMIT; i++) {
+        mu_assert("add", mpsc_add(&q, &items[0][i].node, LIMIT) == 0);
+    }
+
+    mu_assert("full", mpsc_add(&q, &items[0][LIMIT].node, LIMIT) == -1 && mpsc_size(&q) == LIMIT);
+
+    for (int i = 0; i < LIMIT; i++) {
+        mu_assert("order", mpsc_pop(&q) == &items[0][i].node);
+    }
+
+    mu_assert("empty", mpsc_pop(&q) == NULL && mpsc_is_empty(&q));
+    return 0;
+}
+
+static mpsc_queue shared;
+
+static void *producer(void *arg)
+{
+    item_t *own = arg;
+
+    for (int i = 0; i < ADDS; i++) {
+        mpsc_add(&shared, &own[i].node, 0);
+    }
+
+    return NULL;
+}
+
+// Elementy każdego producenta wychodzą w kolejności, w jakiej je dodał.
+static char *producers_keep_order()
+{
+    pthread_t threads[PRODUCERS];
+    int next[PRODUCERS] = {0};
+    long popped = 0;
+
+    mpsc_init(&shared);
+
+    for (int i = 0; i < PRODUCERS; i++) {
+        for (int j = 0; j < ADDS; j++) {
+            items[i][j] = (item_t){.producer = i, .seq = j};
+        }
+
+        mu_assert("thread", pthread_create(&threads[i], NULL, producer, items[i]) == 0);
+    }
+
+    while (popped < PRODUCERS * ADDS) {
+        item_t *item = (item_t *) mpsc_pop(&shared);
+
+        if (item != NULL) {
+            mu_assert("per producer order", item->seq == next[item->producer]++);
+            popped++;
+        }
+    }
+
+    for (int i = 0; i < PRODUCERS; i++) {
+        pthread_join(threads[i], NULL);
+    }
+
+    mu_assert("empty", mpsc_pop(&shared) == NULL);
+    return 0;
+}
+
+static mpsc_queue queue;
+static mpsc_node_t nodes[PRODUCERS][ADDS];
+static atomic_long accepted;
+static atomic_int producing;
+static atomic_size_t max_size;
+
+static void observe_size()
+{
+    size_t size = mpsc_size(&queue);
+    size_t seen = atomic_load(&max_size);
+
+    while (size > seen && !atomic_compare_exchange_weak(&max_size, &seen, size)) {
+    }
+}
+
+static void *limited_producer(void *arg)
+{
+    mpsc_node_t *own = arg;
+
+    for (int i = 0; i < ADDS; i++) {
+        if (mpsc_add(&queue, &own[i], LIMIT) == 0) {
+            atomic_fetch_add(&accepted, 1);
+        }
+
+        observe_size();
+    }
+
+    atomic_fetch_sub(&producing, 1);
+    return NULL;
+}
+
+/* Producenci ciągle trafiają na pełną kolejkę. Odrzucona wysyłka nie może
+ * nawet na chwilę podbić licznika, bo konsument czekałby wtedy na element,
+ * którego nigdy nie będzie. */
+static char *full_queue_rejects()
+{
+    pthread_t threads[PRODUCERS];
+    long popped = 0;
+
+    mpsc_init(&queue);
+    atomic_store(&producing, PRODUCERS);
+
+    for (int i = 0; i < PRODUCERS; i++) {
+        mu_assert("thread", pthread_create(&threads[i], NULL, limited_producer, nodes[i]) == 0);
+    }
+
+    while (atomic_load(&producing) > 0 || !mpsc_is_empty(&queue)) {
+        observe_size();
+
+        if (mpsc_pop(&queue) != NULL) {
+            popped++;
+        }
+    }
+
+    for (int i = 0; i < PRODUCERS; i++) {
+        pthread_join(threads[i], NULL);
+    }
+
+    mu_assert("size within limit", atomic_load(&max_size) <= LIMIT);
+    mu_assert("every accepted popped", popped == atomic_load(&accepted));
+    mu_assert("empty", mpsc_pop(&queue) == NULL);
+    return 0;
+}
+
+static char *chain_fills_up_to_limit()
+{
+    mpsc_node_t chain[LIMIT + 2];
+    mpsc_node_t *rest;
+
+    mpsc_init(&queue);
+    mu_assert("first", mpsc_add(&queue, &nodes[0][0], LIMIT) == 0);
+
+    for (int i = 0; i < LIMIT + 2; i++) {
+        atomic_store(&chain[i].next, i + 1 < LIMIT + 2 ? &chain[i + 1] : NULL);
+    }
+
+    mu_assert("chain cut", mpsc_add_chain(&queue, chain, LIMIT + 2, LIMIT, &rest) == LIMIT - 1);
+    mu_assert("rest", rest == &chain[LIMIT - 1] && mpsc_size(&queue) == LIMIT);
+    mu_assert("full", mpsc_add(&queue, &nodes[0][1], LIMIT) == -1 && mpsc_size(&queue) == LIMIT);
+    mu_assert("order", mpsc_pop(&queue) == &nodes[0][0] && mpsc_pop(&queue) == &chain[0]);
+    return 0;
+}
+
+static char *all_tests()
+{
+    mu_run_test(fifo_with_limit);
+    mu_run_test(producers_keep_order);
+    mu_run_test(full_queue_rejects);
+    mu_run_test(chain_fills_up_to_limit);
+    return 0;
+}
+
+int main()
+{
+    char *result = all_tests();
+    if (result != 0)
+    {
+        printf(__FILE__ ": %s\n", result);
+    }
+    else
+    {
+        printf(__FILE__ ": ALL TESTS PASSED\n");
+    }
+    printf(__FILE__ ": Tests run: %d\n", tests_run);
+
+    return result != 0;
+}
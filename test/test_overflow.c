@@ -0,0 +1,181 @@
+#include "minunit.h"
+#include "cacti.h"
+
+#include <stdbool.h>
+#include <stdio.h>
+
+#define MSG_COUNT (1)
+#define LIMIT (4)
+#define SENT (10)
+#define FROM_OUTSIDE (100)
+
+int tests_run = 0;
+
+static int results[SENT];
+static long received[FROM_OUTSIDE];
+static int received_num;
+static int try_result;
+static int blocked_result;
+static bool flood_self;
+
+static void hello(void **stateptr, size_t nbytes, void *data)
+{
+    (void) stateptr; (void) nbytes; (void) data;
+
+    if (!flood_self) {
+        return;
+    }
+
+    for (long i = 0; i < SENT; i++) {
+        results[i] = send_message(actor_id_self(), (message_t){.message_type = MSG_COUNT, .data = (void *) i});
+    }
+
+    try_result = send_message_try(actor_id_self(), (message_t){.message_type = MSG_COUNT});
+    blocked_result = send_message_timed(actor_id_self(), (message_t){.message_type = MSG_COUNT}, 1000);
+
+    // Skrzynka może być pełna, więc kończymy pracę dopiero po jej opróżnieniu.
+    send_message_after(actor_id_self(), (message_t){.message_type = MSG_GODIE}, 1000);
+}
+
+static void count(void **stateptr, size_t nbytes, void *data)
+{
+    (void) stateptr; (void) nbytes;
+
+    received[received_num++] = (long) data;
+
+    if (!flood_self && received_num == FROM_OUTSIDE) {
+        send_message(actor_id_self(), (message_t){.message_type = MSG_GODIE});
+    }
+}
+
+static act_t acts[] = {&hello, &count};
+
+static void run(overflow_t overflow, system_stats_t *stats)
+{
+    role_t role = {.nprompts = 2, .prompts = acts, .overflow = overflow, .budget = BUDGET_UNLIMITED};
+    actor_system_config_t config = {.pool_size = 1, .queue_limit = LIMIT};
+    actor_id_t first;
+
+    received_num = 0;
+    flood_self = true;
+
+    actor_system_create_ex(&first, &role, &config);
+    actor_system_join(first);
+    actor_system_stats(stats);
+}
+
+static char *error_policy()
+{
+    system_stats_t stats;
+
+    run(OVERFLOW_DEFAULT, &stats);
+
+    for (int i = 0; i < SENT; i++) {
+        mu_assert("full mailbox reported", results[i] == (i < LIMIT ? 0 : MAILBOX_FULL));
+    }
+
+    mu_assert("try reports full", try_result == MAILBOX_FULL);
+    mu_assert("timed send gives up", blocked_result == MAILBOX_FULL);
+    mu_assert("first messages kept", received_num == LIMIT && received[LIMIT - 1] == LIMIT - 1);
+    mu_assert("drops counted", stats.dropped == SENT - LIMIT + 2);
+    return 0;
+}
+
+static char *drop_oldest()
+{
+    system_stats_t stats;
+
+    run(OVERFLOW_DROP_OLDEST, &stats);
+
+    for (int i = 0; i < SENT; i++) {
+        mu_assert("all accepted", results[i] == 0);
+    }
+
+    mu_assert("newest messages kept", received_num == LIMIT && received[0] == SENT - LIMIT + 2);
+    mu_assert("drops counted", stats.dropped == SENT - LIMIT + 2);
+    return 0;
+}
+
+static char *unbounded()
+{
+    system_stats_t stats;
+
+    run(OVERFLOW_UNBOUNDED, &stats);
+
+    mu_assert("all received", received_num == SENT + 2);
+    mu_assert("nothing dropped", stats.dropped == 0 && try_result == 0 && blocked_result == 0);
+    return 0;
+}
+
+static char *blocking_sender()
+{
+    role_t role = {.nprompts = 2, .prompts = acts, .overflow = OVERFLOW_BLOCK};
+    actor_system_config_t config = {.pool_size = 1, .queue_limit = LIMIT, .send_timeout_us = TIMEOUT_INFINITE};
+    actor_id_t first;
+    bool all_sent = true;
+
+    received_num = 0;
+    flood_self = false;
+
+    mu_assert("create", actor_system_create_ex(&first, &role, &config) == 0);
+
+    // Nadawca spoza systemu czeka, aż aktor zrobi miejsce w skrzynce.
+    for (long i = 0; i < FROM_OUTSIDE; i++) {
+        all_sent &= send_message(first, (message_t){.message_type = MSG_COUNT, .data = (void *) i}) == 0;
+    }
+
+    actor_system_join(first);
+
+    mu_assert("all sent", all_sent);
+    mu_assert("all received", received_num == FROM_OUTSIDE);
+    mu_assert("in order", received[FROM_OUTSIDE - 1] == FROM_OUTSIDE - 1);
+    return 0;
+}
+
+static char *blocking_self_send()
+{
+    role_t role = {.nprompts = 2, .prompts = acts, .overflow = OVERFLOW_BLOCK, .budget = BUDGET_UNLIMITED};
+    actor_system_config_t config = {.pool_size = 1, .queue_limit = LIMIT, .send_timeout_us = TIMEOUT_INFINITE};
+    actor_id_t first;
+
+    received_num = 0;
+    flood_self = true;
+
+    // Aktor nie opróżni własnej skrzynki, więc wysyłka nie czeka bez końca.
+    mu_assert("create", actor_system_create_ex(&first, &role, &config) == 0);
+    actor_system_join(first);
+
+    for (int i = 0; i < SENT; i++) {
+        mu_assert("full mailbox reported", results[i] == (i < LIMIT ? 0 : MAILBOX_FULL));
+    }
+
+    mu_assert("timed send gives up", try_result == MAILBOX_FULL && blocked_result == MAILBOX_FULL);
+    mu_assert("first messages kept", received_num == LIMIT);
+    return 0;
+}
+
+static char *all_tests()
+{
+    mu_run_test(error_policy);
+    mu_run_test(drop_oldest);
+    mu_run_test(unbounded);
+    mu_run_test(blocking_sender);
+    mu_run_test(blocking_self_send);
+    return 0;
+}
+
+int main()
+{
+    char *result = all_tests();
+    if (result != 0)
+    {
+        printf(__FILE__ ": %s\n", result);
+    }
+    else
+    {
+        printf(__FILE__ ": ALL TESTS PASSED\n");
+    }
+    printf(__FILE__ ": Tests run: %d\n", tests_run);
+
+    return result != 0;
+}
@@ -0,0 +1,334 @@
+#include "minunit.h"
+#include "cacti.h"
+
+#include <stdatomic.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <time.h>
+
+#define MSG_WORK (1)
+#define MSG_JOINED (1)
+#define MSG_READ (1)
+#define LIMIT (4)
+#define SENT (10)
+#define CHILDREN (8)
+#define VALUES (1000)
+#define TICKS (3)
+#define MSG_DONE (2)
+#define MAGIC (0x5eed)
+
+int tests_run = 0;
+
+static atomic_int destroyed;
+static int full;
+static int handled;
+static int after_death;
+
+static void count_destroyed(void *data)
+{
+    (void) data;
+
+    atomic_fetch_add(&destroyed, 1);
+}
+
+static message_t owned(message_type_t message_type)
+{
+    return (message_t){.message_type = message_type, .data = &destroyed, .destroy = count_destroyed};
+}
+
+// Zalewa własną skrzynkę, więc część wiadomości nie może trafić do obsługi.
+static void flood(void **stateptr, size_t nbytes, void *data)
+{
+    (void) stateptr; (void) nbytes; (void) data;
+
+    for (int i = 0; i < SENT; i++) {
+        if (send_message(actor_id_self(), owned(MSG_WORK)) == MAILBOX_FULL) {
+            full++;
+        }
+    }
+
+    send_message(actor_id_self(), owned(MSG_GODIE));
+}
+
+// Obsługa przejmuje dane, więc nie są one zwalniane przez system.
+static void work(void **stateptr, size_t nbytes, void *data)
+{
+    (void) stateptr; (void) nbytes; (void) data;
+
+    if (handled++ == 0) {
+        after_death = send_message(actor_id_self(), owned(MSG_WORK));
+    }
+}
+
+static act_t flood_acts[] = {&flood, &work};
+
+static void run_flood(overflow_t overflow)
+{
+    role_t role = {.nprompts = 2, .prompts = flood_acts, .overflow = overflow, .budget = BUDGET_UNLIMITED};
+    actor_system_config_t config = {.pool_size = 1, .queue_limit = LIMIT};
+    actor_id_t first;
+
+    atomic_store(&destroyed, 0);
+    full = 0;
+    handled = 0;
+
+    actor_system_create_ex(&first, &role, &config);
+    actor_system_join(first);
+}
+
+static char *dropped_messages_destroyed()
+{
+    run_flood(OVERFLOW_ERROR);
+
+    mu_assert("full mailbox reported", full == SENT - LIMIT);
+    mu_assert("accepted handled", handled == LIMIT);
+    mu_assert("send to dead actor fails", after_death < 0);
+    // Odrzucone przy wysyłce, MSG_GODIE i wysłana do martwego aktora.
+    mu_assert("rejected destroyed", atomic_load(&destroyed) == SENT - LIMIT + 2);
+
+    run_flood(OVERFLOW_DROP_OLDEST);
+
+    mu_assert("everything accepted", full == 0);
+    mu_assert("newest handled", handled == LIMIT);
+    mu_assert("oldest destroyed", atomic_load(&destroyed) == SENT - LIMIT + 2);
+    return 0;
+}
+
+static int ticks;
+
+static void idle(void **stateptr, size_t nbytes, void *data)
+{
+    (void) stateptr; (void) nbytes; (void) data;
+}
+
+static void tick(void **stateptr, size_t nbytes, void *data)
+{
+    (void) stateptr; (void) nbytes; (void) data;
+
+    if (++ticks == TICKS) {
+        send_message(actor_id_self(), (message_t){.message_type = MSG_GODIE});
+    }
+}
+
+static act_t timer_acts[] = {&idle, &tick};
+static role_t timer_role = {.nprompts = 2, .prompts = timer_acts};
+
+static char *timers_own_their_data()
+{
+    cacti_system_t *sys;
+    actor_id_t actor;
+    timer_id_t periodic;
+
+    atomic_store(&destroyed, 0);
+    mu_assert("create", cacti_system_create(&sys, &actor, &timer_role, NULL) == 0);
+
+    periodic = cacti_send_message_every(sys, actor, owned(MSG_WORK), 10000000, 10000000);
+    mu_assert("cancel", cacti_cancel_timer(sys, periodic) == 0);
+    mu_assert("cancelled destroyed", atomic_load(&destroyed) == 1);
+
+    mu_assert("pending", cacti_send_message_every(sys, actor, owned(MSG_WORK), 10000000, 0) >= 0);
+    mu_assert("ticking", cacti_send_message_every(sys, actor, owned(MSG_WORK), 1000, 1000) >= 0);
+
+    cacti_system_join(sys);
+    cacti_system_free(sys);
+
+    // Zegar okresowy zwalnia dane raz, choć wysłał je co najmniej TICKS razy.
+    mu_assert("ticks handled", ticks >= TICKS);
+    mu_assert("timers destroyed", atomic_load(&destroyed) == 3);
+    return 0;
+}
+
+typedef struct tick_data {
+    int magic;
+} tick_data_t;
+
+static timer_id_t ticker;
+static int late_ticks;
+static int bad_ticks;
+
+static void free_tick_data(void *data)
+{
+    tick_data_t *tick_data = data;
+
+    tick_data->magic = 0;
+    free(tick_data);
+    atomic_fetch_add(&destroyed, 1);
+}
+
+static void ticker_hello(void **stateptr, size_t nbytes, void *data)
+{
+    (void) stateptr; (void) nbytes; (void) data;
+
+    tick_data_t *tick_data = malloc(sizeof (tick_data_t));
+
+    tick_data->magic = MAGIC;
+    ticker = send_message_every(actor_id_self(), (message_t){.message_type = MSG_WORK,
+            .data = tick_data, .destroy = free_tick_data}, 1000, 1000);
+}
+
+/* Pierwsze odpalenie czeka, aż w skrzynce zbierze się kilka kolejnych, i usuwa
+ * zegar. Wiadomości zegara, które już wysłano, nadal czytają jego dane. */
+static void ticker_tick(void **stateptr, size_t nbytes, void *data)
+{
+    (void) stateptr; (void) nbytes;
+
+    if (ticker >= 0) {
+        nanosleep(&(struct timespec){.tv_nsec = 10000000}, NULL);
+        cancel_timer(ticker);
+        ticker = -1;
+        send_message(actor_id_self(), (message_t){.message_type = MSG_DONE});
+    }
+    else {
+        late_ticks++;
+    }
+
+    if (((tick_data_t *) data)->magic != MAGIC) {
+        bad_ticks++;
+    }
+}
+
+static void ticker_done(void **stateptr, size_t nbytes, void *data)
+{
+    (void) stateptr; (void) nbytes; (void) data;
+
+    send_message(actor_id_self(), (message_t){.message_type = MSG_GODIE});
+}
+
+static act_t ticker_acts[] = {&ticker_hello, &ticker_tick, &ticker_done};
+static role_t ticker_role = {.nprompts = 3, .prompts = ticker_acts};
+
+static char *cancelled_timer_data_outlives_ticks()
+{
+    actor_system_config_t config = {.pool_size = 1};
+    cacti_system_t *sys;
+    actor_id_t actor;
+
+    atomic_store(&destroyed, 0);
+    mu_assert("create", cacti_system_create(&sys, &actor, &ticker_role, &config) == 0);
+    cacti_system_join(sys);
+    cacti_system_free(sys);
+
+    mu_assert("ticks queued before cancel", late_ticks > 0);
+    mu_assert("data valid in every tick", bad_ticks == 0);
+    mu_assert("destroyed once", atomic_load(&destroyed) == 1);
+    return 0;
+}
+
+static actor_id_t children[CHILDREN];
+static int joined;
+static int multicast_owned;
+static int multicast_shared;
+static void *broadcast;
+static atomic_int reads;
+static atomic_int bad_reads;
+
+static void child_hello(void **stateptr, size_t nbytes, void *data);
+static void child_read(void **stateptr, size_t nbytes, void *data);
+static void parent_hello(void **stateptr, size_t nbytes, void *data);
+static void parent_joined(void **stateptr, size_t nbytes, void *data);
+
+static act_t child_acts[] = {&child_hello, &child_read};
+static role_t child_role = {.nprompts = 2, .prompts = child_acts};
+static act_t parent_acts[] = {&parent_hello, &parent_joined};
+static role_t parent_role = {.nprompts = 2, .prompts = parent_acts};
+
+static void child_hello(void **stateptr, size_t nbytes, void *data)
+{
+    (void) stateptr; (void) nbytes;
+
+    send_message((actor_id_t) data, (message_t){.message_type = MSG_JOINED, .data = (void *) actor_id_self()});
+}
+
+static void child_read(void **stateptr, size_t nbytes, void *data)
+{
+    (void) stateptr;
+    const long *values = data;
+    long sum = 0;
+
+    for (int i = 0; i < VALUES; i++) {
+        sum += values[i];
+    }
+
+    // Każdy odbiorca dostaje ten sam bufor, a nie kopię.
+    if (data != broadcast || nbytes != VALUES * sizeof (long) || sum != (long) VALUES * (VALUES - 1) / 2) {
+        atomic_fetch_add(&bad_reads, 1);
+    }
+
+    atomic_fetch_add(&reads, 1);
+    shared_release(data);
+    send_message(actor_id_self(), (message_t){.message_type = MSG_GODIE});
+}
+
+static void parent_hello(void **stateptr, size_t nbytes, void *data)
+{
+    (void) stateptr; (void) nbytes; (void) data;
+
+    for (int i = 0; i < CHILDREN; i++) {
+        send_message(actor_id_self(), (message_t){.message_type = MSG_SPAWN, .data = &child_role});
+    }
+}
+
+static void parent_joined(void **stateptr, size_t nbytes, void *data)
+{
+    (void) stateptr; (void) nbytes;
+
+    children[joined++] = (actor_id_t) data;
+
+    if (joined < CHILDREN) {
+        return;
+    }
+
+    multicast_owned = send_message_multicast(children, CHILDREN, owned(MSG_READ));
+
+    long *values = shared_alloc(VALUES * sizeof (long));
+
+    for (int i = 0; i < VALUES; i++) {
+        values[i] = i;
+    }
+
+    broadcast = values;
+    multicast_shared = send_message_multicast_shared(children, CHILDREN, MSG_READ, values);
+    shared_release(values);
+    send_message(actor_id_self(), (message_t){.message_type = MSG_GODIE});
+}
+
+static char *shared_buffer_broadcast()
+{
+    actor_id_t first;
+
+    atomic_store(&destroyed, 0);
+    mu_assert("create", actor_system_create(&first, &parent_role) == 0);
+    actor_system_join(first);
+
+    mu_assert("owned multicast rejected", multicast_owned == INVALID_MESSAGE);
+    mu_assert("owned multicast destroyed", atomic_load(&destroyed) == 1);
+    mu_assert("shared multicast sent", multicast_shared == 0);
+    mu_assert("every child read", atomic_load(&reads) == CHILDREN);
+    mu_assert("same buffer everywhere", atomic_load(&bad_reads) == 0);
+    return 0;
+}
+
+static char *all_tests()
+{
+    mu_run_test(dropped_messages_destroyed);
+    mu_run_test(timers_own_their_data);
+    mu_run_test(cancelled_timer_data_outlives_ticks);
+    mu_run_test(shared_buffer_broadcast);
+    return 0;
+}
+
+int main()
+{
+    char *result = all_tests();
+    if (result != 0)
+    {
+        printf(__FILE__ ": %s\n", result);
+    }
+    else
+    {
+        printf(__FILE__ ": ALL TESTS PASSED\n");
+    }
+    printf(__FILE__ ": Tests run: %d\n", tests_run);
+
+    return result != 0;
+}
@@ -0,0 +1,97 @@
+#include "minunit.h"
+#include "cacti.h"
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <unistd.h>
+
+#define CONFIGURED (2)
+
+int tests_run = 0;
+
+// Z cacti.c: liczba wątków puli dla pola 'pool_size' ustawień.
+size_t resolve_pool_size(size_t pool_size);
+
+// Zwraca liczbę wątków dla ustawień CONFIGURED i 'env' w POOL_SIZE_ENV.
+static size_t workers_with(const char *env)
+{
+    if (env != NULL) {
+        setenv(POOL_SIZE_ENV, env, 1);
+    }
+    else {
+        unsetenv(POOL_SIZE_ENV);
+    }
+
+    return resolve_pool_size(CONFIGURED);
+}
+
+static void hello(void **stateptr, size_t nbytes, void *data)
+{
+    (void) stateptr; (void) nbytes; (void) data;
+
+    send_message(actor_id_self(), (message_t){.message_type = MSG_GODIE});
+}
+
+static act_t acts[] = {&hello};
+static role_t role = {.nprompts = 1, .prompts = acts};
+
+static char *env_overrides_config()
+{
+    actor_system_config_t config = {.pool_size = CONFIGURED};
+    actor_id_t first;
+
+    mu_assert("unset", workers_with(NULL) == CONFIGURED);
+    mu_assert("set", workers_with("3") == 3);
+    mu_assert("one", workers_with("1") == 1);
+
+    // System z nadpisaną liczbą wątków działa normalnie.
+    mu_assert("create", actor_system_create_ex(&first, &role, &config) == 0);
+    actor_system_join(first);
+    return 0;
+}
+
+static char *zero_means_cpus()
+{
+    long cpus = sysconf(_SC_NPROCESSORS_ONLN);
+
+    mu_assert("zero", workers_with("0") == (size_t) (cpus > 0 ? cpus : 1));
+    unsetenv(POOL_SIZE_ENV);
+    mu_assert("zero config", resolve_pool_size(0) == (size_t) (cpus > 0 ? cpus : 1));
+    return 0;
+}
+
+// Niepoprawna wartość jest pomijana, a system dostaje liczbę z ustawień.
+static char *invalid_ignored()
+{
+    mu_assert("empty", workers_with("") == CONFIGURED);
+    mu_assert("letters", workers_with("abc") == CONFIGURED);
+    mu_assert("trailing", workers_with("3x") == CONFIGURED);
+    mu_assert("negative", workers_with("-1") == CONFIGURED);
+    mu_assert("space", workers_with(" 3") == CONFIGURED);
+    mu_assert("overflow", workers_with("99999999999999999999999") == CONFIGURED);
+    return 0;
+}
+
+static char *all_tests()
+{
+    mu_run_test(env_overrides_config);
+    mu_run_test(zero_means_cpus);
+    mu_run_test(invalid_ignored);
+    return 0;
+}
+
+int main()
+{
+    char *result = all_tests();
+    if (result != 0)
+    {
+        printf(__FILE__ ": %s\n", result);
+    }
+    else
+    {
+        printf(__FILE__ ": ALL TESTS PASSED\n");
+    }
+    printf(__FILE__ ": Tests run: %d\n", tests_run);
+
+    return result != 0;
+}
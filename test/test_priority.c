@@ -0,0 +1,208 @@
+#include "minunit.h"
+#include "cacti.h"
+
+#include <stdio.h>
+
+#define MSG_NORMAL (1)
+#define MSG_MIDDLE (2)
+#define MSG_TOP (3)
+#define PER_LANE (50)
+#define LIMIT (4)
+#define FLOOD (20)
+
+int tests_run = 0;
+
+typedef struct entry {
+    message_type_t lane;
+    long seq;
+} entry_t;
+
+static entry_t received[3 * PER_LANE];
+static int received_num;
+static int first_probe;
+static int bad_priority[2];
+
+static void hello(void **stateptr, size_t nbytes, void *data);
+static void normal(void **stateptr, size_t nbytes, void *data);
+static void middle(void **stateptr, size_t nbytes, void *data);
+static void top(void **stateptr, size_t nbytes, void *data);
+
+static act_t acts[] = {&hello, &normal, &middle, &top};
+static role_t role = {.nprompts = 4, .prompts = acts, .budget = BUDGET_UNLIMITED};
+
+/* Wszystko wysyłamy, zanim aktor wykona którąkolwiek wiadomość, przeplatając
+ * priorytety; MSG_GODIE wysłany na końcu zwykłym send_message. */
+static void hello(void **stateptr, size_t nbytes, void *data)
+{
+    (void) stateptr; (void) nbytes; (void) data;
+    actor_id_t self = actor_id_self();
+
+    for (long i = 0; i < PER_LANE; i++) {
+        send_message(self, (message_t){.message_type = MSG_NORMAL, .data = (void *) i});
+        send_message_prio(self, (message_t){.message_type = MSG_MIDDLE, .data = (void *) i}, 1);
+        send_message_prio(self, (message_t){.message_type = MSG_TOP, .data = (void *) i}, PRIORITY_LEVELS - 1);
+    }
+
+    bad_priority[0] = send_message_prio(self, (message_t){.message_type = MSG_TOP}, -1);
+    bad_priority[1] = send_message_prio(self, (message_t){.message_type = MSG_TOP}, PRIORITY_LEVELS);
+    send_message(self, (message_t){.message_type = MSG_GODIE});
+}
+
+static void record(message_type_t lane, void *data)
+{
+    // Martwy aktor nie przyjmuje wiadomości, więc MSG_GODIE wykonał się już wcześniej.
+    if (received_num == 0) {
+        first_probe = send_message(actor_id_self(), (message_t){.message_type = MSG_NORMAL});
+    }
+
+    received[received_num].seq = (long) data;
+    received[received_num].lane = lane;
+    received_num++;
+}
+
+static void normal(void **stateptr, size_t nbytes, void *data)
+{
+    (void) stateptr; (void) nbytes;
+
+    record(MSG_NORMAL, data);
+}
+
+static void middle(void **stateptr, size_t nbytes, void *data)
+{
+    (void) stateptr; (void) nbytes;
+
+    record(MSG_MIDDLE, data);
+}
+
+static void top(void **stateptr, size_t nbytes, void *data)
+{
+    (void) stateptr; (void) nbytes;
+
+    record(MSG_TOP, data);
+}
+
+static char *lanes_are_ordered()
+{
+    actor_id_t first;
+
+    mu_assert("create", actor_system_create(&first, &role) == 0);
+    actor_system_join(first);
+
+    mu_assert("all received", received_num == 3 * PER_LANE);
+    // Śmierć jedynego aktora kończy system, więc próbna wysyłka zwraca błąd.
+    mu_assert("godie went first", first_probe < 0);
+    mu_assert("negative priority", bad_priority[0] == INVALID_PRIORITY);
+    mu_assert("priority too high", bad_priority[1] == INVALID_PRIORITY);
+
+    // Najpierw cały najwyższy priorytet, potem 1, na końcu zwykłe, każdy w kolejności wysłania.
+    for (int i = 0; i < 3 * PER_LANE; i++) {
+        mu_assert("lanes by priority", received[i].lane == MSG_TOP - i / PER_LANE);
+        mu_assert("order within lane", received[i].seq == i % PER_LANE);
+    }
+
+    return 0;
+}
+
+static int hellos;
+static int rejected_hellos;
+static int flood_godie;
+static int kept[MSG_TOP + 1];
+static int stale[MSG_TOP + 1];
+
+static void flood_hello(void **stateptr, size_t nbytes, void *data);
+static void flood_normal(void **stateptr, size_t nbytes, void *data);
+static void flood_middle(void **stateptr, size_t nbytes, void *data);
+
+static act_t flood_acts[] = {&flood_hello, &flood_normal, &flood_middle};
+static role_t flood_role = {.nprompts = 3, .prompts = flood_acts, .budget = BUDGET_UNLIMITED,
+                            .overflow = OVERFLOW_DROP_OLDEST};
+
+/* Zalewa własne skrzynki: zwykłą, priorytetu 1 i sterującą. Ponowne
+ * MSG_HELLO tylko zapychają stos sterujący. */
+static void flood_hello(void **stateptr, size_t nbytes, void *data)
+{
+    (void) stateptr; (void) nbytes; (void) data;
+    actor_id_t self = actor_id_self();
+
+    if (hellos++ > 0) {
+        return;
+    }
+
+    for (long i = 0; i < FLOOD; i++) {
+        send_message(self, (message_t){.message_type = MSG_NORMAL, .data = (void *) i});
+        send_message_prio(self, (message_t){.message_type = MSG_MIDDLE, .data = (void *) i}, 1);
+    }
+
+    for (int i = 0; i < FLOOD; i++) {
+        if (send_message(self, (message_t){.message_type = MSG_HELLO}) == MAILBOX_FULL) {
+            rejected_hellos++;
+        }
+    }
+
+    flood_godie = send_message(self, (message_t){.message_type = MSG_GODIE});
+}
+
+// Zostać powinno tylko LIMIT najnowszych wiadomości każdego priorytetu.
+static void keep(message_type_t lane, void *data)
+{
+    if ((long) data < FLOOD - LIMIT) {
+        stale[lane]++;
+    }
+
+    kept[lane]++;
+}
+
+static void flood_normal(void **stateptr, size_t nbytes, void *data)
+{
+    (void) stateptr; (void) nbytes;
+
+    keep(MSG_NORMAL, data);
+}
+
+static void flood_middle(void **stateptr, size_t nbytes, void *data)
+{
+    (void) stateptr; (void) nbytes;
+
+    keep(MSG_MIDDLE, data);
+}
+
+static char *drop_oldest_bounds_every_lane()
+{
+    actor_system_config_t config = {.pool_size = 1, .queue_limit = LIMIT};
+    system_stats_t stats;
+    actor_id_t first;
+
+    mu_assert("create", actor_system_create_ex(&first, &flood_role, &config) == 0);
+    actor_system_join(first);
+    actor_system_stats(&stats);
+
+    mu_assert("control lane bounded", rejected_hellos == FLOOD - LIMIT && hellos == LIMIT + 1);
+    mu_assert("godie accepted when full", flood_godie == 0);
+    mu_assert("priority lane trimmed", kept[MSG_MIDDLE] == LIMIT && stale[MSG_MIDDLE] == 0);
+    mu_assert("normal lane trimmed", kept[MSG_NORMAL] == LIMIT && stale[MSG_NORMAL] == 0);
+    mu_assert("dropped counted", stats.dropped == 3 * (FLOOD - LIMIT));
+    return 0;
+}
+
+static char *all_tests()
+{
+    mu_run_test(lanes_are_ordered);
+    mu_run_test(drop_oldest_bounds_every_lane);
+    return 0;
+}
+
+int main()
+{
+    char *result = all_tests();
+    if (result != 0)
+    {
+        printf(__FILE__ ": %s\n", result);
+    }
+    else
+    {
+        printf(__FILE__ ": ALL TESTS PASSED\n");
+    }
+    printf(__FILE__ ": Tests run: %d\n", tests_run);
+
+    return result != 0;
+}
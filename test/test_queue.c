@@ -0,0 +1,81 @@
+#include "minunit.h"
+#include "generic_queue.h"
+
+#include <stdio.h>
+
+#define ROUNDS (5000)
+
+int tests_run = 0;
+
+static char *fifo_across_segments()
+{
+    generic_queue *q = create_queue(NULL);
+    long pushed = 0;
+    long popped = 0;
+    void *out;
+
+    // Dokładamy szybciej niż zdejmujemy, żeby kolejka przechodziła przez wiele segmentów.
+    for (int round = 0; round < ROUNDS; round++) {
+        for (int i = 0; i < 3; i++) {
+            mu_assert("add", queue_add(q, (void *) pushed++) == 0);
+        }
+
+        mu_assert("pop", queue_try_pop(q, &out) == 0);
+        mu_assert("fifo order", (long) out == popped++);
+    }
+
+    mu_assert("size", queue_size(q) == (size_t) (pushed - popped));
+
+    while (queue_try_pop(q, &out) == 0) {
+        mu_assert("fifo order after growth", (long) out == popped++);
+    }
+
+    mu_assert("drained", popped == pushed && is_empty(q) && queue_pop(q) == NULL);
+
+    free_queue(q);
+    return 0;
+}
+
+static char *limited()
+{
+    generic_queue *q = create_queue((void *) 10);
+
+    for (long i = 0; i < 10; i++) {
+        mu_assert("add below limit", queue_add(q, (void *) i) == 0);
+    }
+
+    mu_assert("add over limit", queue_add(q, (void *) 10) == -1);
+    mu_assert("peek", queue_peek(q) == NULL && queue_size(q) == 10);
+    mu_assert("null element popped", queue_pop(q) == NULL && queue_size(q) == 9);
+    mu_assert("add after pop", queue_add(q, (void *) 10) == 0);
+
+    for (long i = 1; i <= 10; i++) {
+        mu_assert("order", (long) queue_pop(q) == i);
+    }
+
+    free_queue(q);
+    return 0;
+}
+
+static char *all_tests()
+{
+    mu_run_test(fifo_across_segments);
+    mu_run_test(limited);
+    return 0;
+}
+
+int main()
+{
+    char *result = all_tests();
+    if (result != 0)
+    {
+        printf(__FILE__ ": %s\n", result);
+    }
+    else
+    {
+        printf(__FILE__ ": ALL TESTS PASSED\n");
+    }
+    printf(__FILE__ ": Tests run: %d\n", tests_run);
+
+    return result != 0;
+}
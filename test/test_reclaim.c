@@ -0,0 +1,104 @@
+#include "minunit.h"
+#include "cacti.h"
+
+#include <stdbool.h>
+#include <stdio.h>
+
+#define MSG_STRAY (1)
+#define STEPS (10000)
+
+int tests_run = 0;
+
+static size_t depth;
+static actor_id_t first_child;
+static actor_id_t last_id;
+static int stale_result;
+static int unknown_result;
+static int strays;
+static system_stats_t during;
+
+static void hello(void **stateptr, size_t nbytes, void *data);
+static void stray(void **stateptr, size_t nbytes, void *data);
+
+static act_t acts[] = {&hello, &stray};
+static role_t role = {.nprompts = 2, .prompts = acts};
+
+/* Jak w silnia.c: każdy aktor zabija ojca, tworzy syna i czeka na śmierć. */
+static void hello(void **stateptr, size_t nbytes, void *data)
+{
+    (void) stateptr; (void) nbytes;
+
+    if (depth > 0) {
+        send_message((actor_id_t) data, (message_t){.message_type = MSG_GODIE});
+    }
+
+    if (depth == 1) {
+        first_child = actor_id_self();
+    }
+
+    if (++depth < STEPS) {
+        send_message(actor_id_self(), (message_t){.message_type = MSG_SPAWN, .data = &role});
+        return;
+    }
+
+    last_id = actor_id_self();
+    actor_system_stats(&during);
+    stale_result = send_message(first_child, (message_t){.message_type = MSG_STRAY});
+    // Pokolenie miejsca nie przekroczy liczby kroków, więc ten numer nie był nadany.
+    unknown_result = send_message(last_id + STEPS * (actor_id_t) CAST_LIMIT,
+                                  (message_t){.message_type = MSG_STRAY});
+    send_message(actor_id_self(), (message_t){.message_type = MSG_GODIE});
+}
+
+static void stray(void **stateptr, size_t nbytes, void *data)
+{
+    (void) stateptr; (void) nbytes; (void) data;
+
+    strays++;
+}
+
+static char *slots_are_reused()
+{
+    actor_id_t first;
+
+    mu_assert("create", actor_system_create(&first, &role) == 0);
+    actor_system_join(first);
+
+    mu_assert("chain finished", depth == STEPS);
+    mu_assert("few slots used", during.actor_slots < 16);
+    // Przodkowie ostatniego aktora mogli jeszcze nie obsłużyć MSG_GODIE.
+    mu_assert("few actors alive", during.live_actors < 16);
+    mu_assert("recycled ids carry a generation", last_id >= CAST_LIMIT);
+    return 0;
+}
+
+static char *stale_ids_rejected()
+{
+    mu_assert("stale id is dead", stale_result == -1);
+    mu_assert("future id is unknown", unknown_result == -2);
+    mu_assert("successor got nothing", strays == 0);
+    return 0;
+}
+
+static char *all_tests()
+{
+    mu_run_test(slots_are_reused);
+    mu_run_test(stale_ids_rejected);
+    return 0;
+}
+
+int main()
+{
+    char *result = all_tests();
+    if (result != 0)
+    {
+        printf(__FILE__ ": %s\n", result);
+    }
+    else
+    {
+        printf(__FILE__ ": ALL TESTS PASSED\n");
+    }
+    printf(__FILE__ ": Tests run: %d\n", tests_run);
+
+    return result != 0;
+}
@@ -0,0 +1,98 @@
+#define _GNU_SOURCE
+#include "minunit.h"
+#include "cacti.h"
+
+#include <pthread.h>
+#include <sched.h>
+#include <stdio.h>
+
+#define SYSTEMS (200)
+
+int tests_run = 0;
+
+static int hellos;
+static int worker_cpus;
+
+static void hello(void **stateptr, size_t nbytes, void *data);
+
+static act_t acts[] = {&hello};
+static role_t role = {.nprompts = 1, .prompts = acts};
+
+static void hello(void **stateptr, size_t nbytes, void *data)
+{
+    (void) stateptr; (void) nbytes; (void) data;
+    cpu_set_t cpus;
+
+    hellos++;
+
+    if (pthread_getaffinity_np(pthread_self(), sizeof (cpu_set_t), &cpus) == 0) {
+        worker_cpus = CPU_COUNT(&cpus);
+    }
+
+    send_message(actor_id_self(), (message_t){.message_type = MSG_GODIE});
+}
+
+static char *systems_in_sequence()
+{
+    actor_system_config_t config = {.pool_size = 2};
+    actor_id_t first;
+
+    mu_assert("warm", cacti_threads_warm(2) >= 2);
+
+    for (int i = 0; i < SYSTEMS; i++) {
+        mu_assert("create", actor_system_create_ex(&first, &role, &config) == 0);
+        actor_system_join(first);
+    }
+
+    mu_assert("every system ran", hellos == SYSTEMS);
+    // Wątki poprzednich systemów czekają na kolejne.
+    mu_assert("threads kept", cacti_threads_warm(0) >= 2);
+    return 0;
+}
+
+static char *pinning_is_undone()
+{
+    int cpu = 0;
+    actor_system_config_t pinned = {.pool_size = 1, .affinity = AFFINITY_CPU, .cpus = &cpu, .ncpus = 1};
+    actor_system_config_t unpinned = {.pool_size = 1};
+    cpu_set_t cpus;
+    actor_id_t first;
+
+    mu_assert("release", cacti_threads_release() == 0);
+    mu_assert("process cpus", sched_getaffinity(0, sizeof (cpu_set_t), &cpus) == 0);
+
+    mu_assert("create pinned", actor_system_create_ex(&first, &role, &pinned) == 0);
+    actor_system_join(first);
+    mu_assert("worker pinned", worker_cpus == 1);
+
+    // Ten sam wątek trafia do systemu bez przypinania.
+    mu_assert("create free", actor_system_create_ex(&first, &role, &unpinned) == 0);
+    actor_system_join(first);
+    mu_assert("worker unpinned", worker_cpus == CPU_COUNT(&cpus));
+
+    mu_assert("release again", cacti_threads_release() == 0);
+    return 0;
+}
+
+static char *all_tests()
+{
+    mu_run_test(systems_in_sequence);
+    mu_run_test(pinning_is_undone);
+    return 0;
+}
+
+int main()
+{
+    char *result = all_tests();
+    if (result != 0)
+    {
+        printf(__FILE__ ": %s\n", result);
+    }
+    else
+    {
+        printf(__FILE__ ": ALL TESTS PASSED\n");
+    }
+    printf(__FILE__ ": Tests run: %d\n", tests_run);
+
+    return result != 0;
+}
@@ -0,0 +1,340 @@
+#include "minunit.h"
+#include "cacti.h"
+
+#include <sched.h>
+#include <stdio.h>
+#include <time.h>
+
+#define MSG_WORK (1)
+#define MSG_WORK_VALUE (2)
+#define MSG_JOINED (1)
+#define POOL (4)
+#define ROUNDS (24)
+#define SENT (POOL * ROUNDS)
+#define KEYS (16)
+#define LEVELLING (POOL * (POOL - 1) / 2)
+
+int tests_run = 0;
+
+static router_strategy_t strategy;
+static actor_id_t router;
+static actor_id_t driver;
+static int hellos;
+static int after_stop;
+static actor_id_t handled_by[SENT];
+static long handled_seq[SENT];
+static int handled_num;
+static int expected;
+static actor_id_t joined[POOL];
+static int joined_num;
+
+static void worker_hello(void **stateptr, size_t nbytes, void *data);
+static void work(void **stateptr, size_t nbytes, void *data);
+static void work_value(void **stateptr, size_t nbytes, void *data);
+static void driver_hello(void **stateptr, size_t nbytes, void *data);
+static void driver_joined(void **stateptr, size_t nbytes, void *data);
+
+static act_t worker_acts[] = {&worker_hello, &work, &work_value};
+static role_t worker_role = {.nprompts = 3, .prompts = worker_acts};
+static act_t driver_acts[] = {&driver_hello, &driver_joined};
+static role_t driver_role = {.nprompts = 2, .prompts = driver_acts};
+
+// Aktorzy puli zgłaszają się kierowcy, żeby ten znał ich numery.
+static void worker_hello(void **stateptr, size_t nbytes, void *data)
+{
+    (void) stateptr; (void) nbytes;
+
+    if ((actor_id_t) data == router) {
+        hellos++;
+    }
+
+    send_message(driver, (message_t){.message_type = MSG_JOINED, .data = (void *) actor_id_self()});
+}
+
+static void record(long seq)
+{
+    handled_by[handled_num] = actor_id_self();
+    handled_seq[handled_num] = seq;
+
+    /* MSG_GODIE wyprzedza wiadomości w skrzynkach, więc router i kierowcę
+     * kończymy dopiero po wykonaniu wszystkich wiadomości. */
+    if (++handled_num == expected) {
+        send_message(router, (message_t){.message_type = MSG_GODIE});
+        after_stop = send_message(router, (message_t){.message_type = MSG_WORK});
+        send_message(driver, (message_t){.message_type = MSG_GODIE});
+    }
+}
+
+static void work(void **stateptr, size_t nbytes, void *data)
+{
+    (void) stateptr; (void) nbytes;
+
+    record((long) data);
+}
+
+// Klucze wysłane przez send_value zapisujemy za kluczami wysłanymi wskaźnikiem.
+static void work_value(void **stateptr, size_t nbytes, void *data)
+{
+    (void) stateptr; (void) nbytes;
+
+    record(KEYS + message_value(long, data));
+}
+
+static void driver_hello(void **stateptr, size_t nbytes, void *data)
+{
+    (void) stateptr; (void) nbytes; (void) data;
+    router_config_t config = {.strategy = strategy, .role = &worker_role, .size = POOL};
+
+    driver = actor_id_self();
+    router_create(&router, &config);
+}
+
+static void send_round_robin()
+{
+    message_t batch[POOL];
+
+    // Połowę wysyłamy po jednej wiadomości, a połowę paczkami.
+    for (long i = 0; i < SENT / 2; i++) {
+        send_message(router, (message_t){.message_type = MSG_WORK, .data = (void *) i});
+    }
+
+    for (long i = SENT / 2; i < SENT; i += POOL) {
+        for (long j = 0; j < POOL; j++) {
+            batch[j] = (message_t){.message_type = MSG_WORK, .data = (void *) (i + j)};
+        }
+
+        send_messages(router, batch, POOL);
+    }
+}
+
+// Połowę kluczy wysyłamy w polu 'data', a połowę jako kopiowaną wartość.
+static void send_hashed()
+{
+    for (long i = 0; i < SENT / 2; i++) {
+        long key = i % KEYS;
+
+        send_message(router, (message_t){.message_type = MSG_WORK, .data = (void *) key});
+        send_value(router, MSG_WORK_VALUE, key);
+    }
+}
+
+/* Wątek jest jeden, a kierowca wysyła wszystko w jednej obsłudze, więc skrzynki
+ * aktorów puli się w tym czasie nie opróżniają. */
+static void send_to_smallest()
+{
+    // Skrzynki mają 3, 2, 1, 0 wiadomości, więc router wyrówna je do 3, 3, 3, 3.
+    for (int i = 0; i < POOL; i++) {
+        for (int j = i; j < POOL - 1; j++) {
+            send_message(joined[i], (message_t){.message_type = MSG_WORK, .data = (void *) -1});
+        }
+    }
+
+    for (long i = 0; i < LEVELLING; i++) {
+        send_message(router, (message_t){.message_type = MSG_WORK, .data = (void *) i});
+    }
+}
+
+static void driver_joined(void **stateptr, size_t nbytes, void *data)
+{
+    (void) stateptr; (void) nbytes;
+
+    joined[joined_num++] = (actor_id_t) data;
+
+    if (joined_num < POOL) {
+        return;
+    }
+
+    switch (strategy) {
+        case ROUTER_ROUND_ROBIN:
+            send_round_robin();
+            break;
+        case ROUTER_CONSISTENT_HASH:
+            send_hashed();
+            break;
+        default:
+            send_to_smallest();
+            break;
+    }
+}
+
+static void run(router_strategy_t router_strategy, int messages)
+{
+    actor_system_config_t config = {.pool_size = 1};
+    actor_id_t first;
+
+    strategy = router_strategy;
+    expected = messages;
+    hellos = 0;
+    handled_num = 0;
+    joined_num = 0;
+
+    actor_system_create_ex(&first, &driver_role, &config);
+    actor_system_join(first);
+}
+
+static int position(actor_id_t worker)
+{
+    for (int i = 0; i < POOL; i++) {
+        if (joined[i] == worker) {
+            return i;
+        }
+    }
+
+    return -1;
+}
+
+static char *round_robin()
+{
+    actor_id_t by_seq[SENT];
+
+    run(ROUTER_ROUND_ROBIN, SENT);
+
+    mu_assert("pool greeted by router", hellos == POOL);
+    // MSG_GODIE dostali wszyscy aktorzy puli, inaczej system by się nie skończył.
+    mu_assert("dead router rejects", after_stop < 0);
+
+    for (int i = 0; i < SENT; i++) {
+        by_seq[handled_seq[i]] = handled_by[i];
+    }
+
+    for (int i = 0; i < SENT; i++) {
+        mu_assert("routed to pool", position(by_seq[i]) >= 0);
+        mu_assert("in turn", by_seq[i] == by_seq[i % POOL]);
+    }
+
+    for (int i = 1; i < POOL; i++) {
+        mu_assert("each worker used", by_seq[i] != by_seq[0]);
+    }
+
+    return 0;
+}
+
+static char *consistent_hash()
+{
+    actor_id_t by_key[2 * KEYS] = {0};
+    int used[POOL] = {0};
+    int used_num = 0;
+
+    run(ROUTER_CONSISTENT_HASH, SENT);
+
+    for (int i = 0; i < SENT; i++) {
+        long key = handled_seq[i];
+
+        if (by_key[key] == 0) {
+            by_key[key] = handled_by[i];
+        }
+
+        mu_assert("key sticks to worker", by_key[key] == handled_by[i]);
+        mu_assert("routed to pool", position(handled_by[i]) >= 0);
+        used[position(handled_by[i])] = 1;
+    }
+
+    for (int i = 0; i < POOL; i++) {
+        used_num += used[i];
+    }
+
+    mu_assert("keys spread", used_num > 1);
+    return 0;
+}
+
+static char *smallest_mailbox()
+{
+    int routed[POOL] = {0};
+
+    run(ROUTER_SMALLEST_MAILBOX, 2 * LEVELLING);
+
+    for (int i = 0; i < handled_num; i++) {
+        if (handled_seq[i] >= 0) {
+            routed[position(handled_by[i])]++;
+        }
+    }
+
+    for (int i = 0; i < POOL; i++) {
+        mu_assert("shortest mailboxes filled", routed[i] == i);
+    }
+
+    return 0;
+}
+
+static void idle(void **stateptr, size_t nbytes, void *data)
+{
+    (void) stateptr; (void) nbytes; (void) data;
+}
+
+static void die(void **stateptr, size_t nbytes, void *data)
+{
+    (void) stateptr; (void) nbytes; (void) data;
+
+    send_message(actor_id_self(), (message_t){.message_type = MSG_GODIE});
+}
+
+static act_t idle_acts[] = {&idle};
+static role_t idle_role = {.nprompts = 1, .prompts = idle_acts};
+static act_t dying_acts[] = {&die};
+static role_t dying_role = {.nprompts = 1, .prompts = dying_acts};
+
+/* Gdy router umiera jako ostatni, a MSG_GODIE wysyła mu wątek spoza puli,
+ * to ten wątek musi obudzić uśpioną pulę, inaczej join nigdy się nie skończy. */
+static char *router_dies_last()
+{
+    actor_system_config_t config = {.pool_size = 2};
+    router_config_t router_config = {.role = &dying_role, .size = POOL};
+    system_stats_t stats;
+    cacti_system_t *sys;
+    actor_id_t first;
+    actor_id_t last;
+
+    mu_assert("create", cacti_system_create(&sys, &first, &idle_role, &config) == 0);
+    mu_assert("router", cacti_router_create(sys, &last, &router_config) == 0);
+    mu_assert("first dies", cacti_send_message(sys, first, (message_t){.message_type = MSG_GODIE}) == 0);
+
+    do {
+        sched_yield();
+        cacti_system_stats(sys, &stats);
+    } while (stats.live_actors > 1);
+
+    // Czekamy, aż wątki puli zasną.
+    nanosleep(&(struct timespec){.tv_nsec = 20000000}, NULL);
+
+    mu_assert("router stopped", cacti_send_message(sys, last, (message_t){.message_type = MSG_GODIE}) == 0);
+    cacti_system_join(sys);
+    cacti_system_free(sys);
+    return 0;
+}
+
+static char *invalid_config()
+{
+    router_config_t empty = {.role = &idle_role, .size = 0};
+    router_config_t no_role = {.size = POOL};
+    actor_id_t ignored;
+
+    mu_assert("empty pool", router_create(&ignored, &empty) == INVALID_ROUTER);
+    mu_assert("no role", router_create(&ignored, &no_role) == INVALID_ROUTER);
+    return 0;
+}
+
+static char *all_tests()
+{
+    mu_run_test(round_robin);
+    mu_run_test(consistent_hash);
+    mu_run_test(smallest_mailbox);
+    mu_run_test(router_dies_last);
+    mu_run_test(invalid_config);
+    return 0;
+}
+
+int main()
+{
+    char *result = all_tests();
+    if (result != 0)
+    {
+        printf(__FILE__ ": %s\n", result);
+    }
+    else
+    {
+        printf(__FILE__ ": ALL TESTS PASSED\n");
+    }
+    printf(__FILE__ ": Tests run: %d\n", tests_run);
+
+    return result != 0;
+}
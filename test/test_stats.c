@@ -0,0 +1,123 @@
+#include "minunit.h"
+#include "cacti.h"
+
+#include <stdio.h>
+
+#define MSG_COUNT (1)
+#define BATCH (100)
+#define POOL (2)
+
+int tests_run = 0;
+
+static int stats_result;
+static actor_stats_t self_stats;
+
+static void hello(void **stateptr, size_t nbytes, void *data)
+{
+    (void) stateptr; (void) nbytes; (void) data;
+
+    message_t batch[BATCH];
+
+    for (long i = 0; i < BATCH; i++) {
+        batch[i] = (message_t){.message_type = MSG_COUNT};
+    }
+
+    batch[BATCH - 1].message_type = MSG_GODIE;
+
+    send_messages(actor_id_self(), batch, BATCH);
+    stats_result = actor_stats(actor_id_self(), &self_stats);
+}
+
+static void count(void **stateptr, size_t nbytes, void *data)
+{
+    (void) stateptr; (void) nbytes; (void) data;
+}
+
+static act_t acts[] = {&hello, &count};
+static role_t role = {.nprompts = 2, .prompts = acts};
+
+static char *actor_counters()
+{
+    actor_system_config_t config = {.stats = true};
+    system_stats_t stats;
+    actor_id_t first;
+
+    mu_assert("create", actor_system_create_ex(&first, &role, &config) == 0);
+    actor_system_join(first);
+    actor_system_stats(&stats);
+
+    mu_assert("stats enabled", stats_result == 0);
+    // MSG_HELLO i cała paczka.
+    mu_assert("enqueued", self_stats.enqueued == BATCH + 1);
+    mu_assert("nothing dropped", self_stats.dropped == 0);
+    // Głębokość obejmuje też stos sterujący, na który trafia MSG_GODIE z paczki.
+    mu_assert("max depth", self_stats.max_depth >= BATCH);
+    mu_assert("workers", stats.workers_num > 0);
+    mu_assert("messages", stats.total.messages == BATCH + 1);
+    mu_assert("no system", actor_stats(first, &self_stats) != 0);
+    return 0;
+}
+
+static char *stats_disabled()
+{
+    actor_id_t first;
+
+    mu_assert("create", actor_system_create(&first, &role) == 0);
+    actor_system_join(first);
+
+    mu_assert("actor counters off", stats_result != 0);
+    return 0;
+}
+
+// Liczniki wątków zakończonego systemu sumują się do liczników całego systemu.
+static char *worker_counters()
+{
+    actor_system_config_t config = {.pool_size = POOL};
+    unsigned long long messages = 0;
+    unsigned long long activations = 0;
+    system_stats_t stats;
+    worker_stats_t worker;
+    actor_id_t first;
+
+    mu_assert("create", actor_system_create_ex(&first, &role, &config) == 0);
+    actor_system_join(first);
+    actor_system_stats(&stats);
+
+    mu_assert("pool", stats.workers_num == POOL);
+
+    for (size_t i = 0; i < POOL; i++) {
+        mu_assert("worker", actor_system_worker_stats(i, &worker) == 0);
+        mu_assert("batch within max", worker.max_batch <= stats.total.max_batch);
+        messages += worker.messages;
+        activations += worker.activations;
+    }
+
+    mu_assert("no such worker", actor_system_worker_stats(POOL, &worker) != 0);
+    mu_assert("messages sum", messages == stats.total.messages && messages == BATCH + 1);
+    mu_assert("activations sum", activations == stats.total.activations);
+    return 0;
+}
+
+static char *all_tests()
+{
+    mu_run_test(actor_counters);
+    mu_run_test(stats_disabled);
+    mu_run_test(worker_counters);
+    return 0;
+}
+
+int main()
+{
+    char *result = all_tests();
+    if (result != 0)
+    {
+        printf(__FILE__ ": %s\n", result);
+    }
+    else
+    {
+        printf(__FILE__ ": ALL TESTS PASSED\n");
+    }
+    printf(__FILE__ ": Tests run: %d\n", tests_run);
+
+    return result != 0;
+}
@@ -0,0 +1,111 @@
+#include "minunit.h"
+#include "cacti.h"
+
+#include <stdatomic.h>
+#include <stdbool.h>
+#include <stdio.h>
+#include <time.h>
+
+#define MSG_READY (1)
+#define MSG_PING (1)
+#define WAIT_NS (500000000ull)
+
+int tests_run = 0;
+
+static atomic_bool pinged;
+static bool waited;
+static actor_id_t child;
+
+static void parent_hello(void **stateptr, size_t nbytes, void *data);
+static void parent_ready(void **stateptr, size_t nbytes, void *data);
+static void child_hello(void **stateptr, size_t nbytes, void *data);
+static void child_ping(void **stateptr, size_t nbytes, void *data);
+
+static act_t parent_acts[] = {&parent_hello, &parent_ready};
+static role_t parent_role = {.nprompts = 2, .prompts = parent_acts};
+static act_t child_acts[] = {&child_hello, &child_ping};
+static role_t child_role = {.nprompts = 2, .prompts = child_acts};
+
+static unsigned long long now()
+{
+    struct timespec ts;
+
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return (unsigned long long) ts.tv_sec * 1000000000ull + (unsigned long long) ts.tv_nsec;
+}
+
+static void parent_hello(void **stateptr, size_t nbytes, void *data)
+{
+    (void) stateptr; (void) nbytes; (void) data;
+
+    send_message(actor_id_self(), (message_t){.message_type = MSG_SPAWN, .data = &child_role});
+}
+
+static void child_hello(void **stateptr, size_t nbytes, void *data)
+{
+    (void) stateptr; (void) nbytes;
+
+    send_message((actor_id_t) data, (message_t){.message_type = MSG_READY, .data = (void *) actor_id_self()});
+}
+
+static void child_ping(void **stateptr, size_t nbytes, void *data)
+{
+    (void) stateptr; (void) nbytes; (void) data;
+
+    pinged = true;
+}
+
+/* Wiadomość do dziecka wstawia je na kolejkę bieżącego wątku, który jest zajęty
+ * aż do jej obsłużenia. Obsłużyć ją może więc tylko drugi wątek, kradnąc
+ * dziecko z cudzej kolejki. */
+static void parent_ready(void **stateptr, size_t nbytes, void *data)
+{
+    (void) stateptr; (void) nbytes;
+    unsigned long long deadline = now() + WAIT_NS;
+
+    child = (actor_id_t) data;
+    send_message(child, (message_t){.message_type = MSG_PING});
+
+    while (!pinged && now() < deadline) {
+    }
+
+    waited = pinged;
+    send_message(child, (message_t){.message_type = MSG_GODIE});
+    send_message(actor_id_self(), (message_t){.message_type = MSG_GODIE});
+}
+
+static char *busy_worker_is_robbed()
+{
+    system_stats_t stats;
+    actor_id_t first;
+
+    mu_assert("create", actor_system_create(&first, &parent_role) == 0);
+    actor_system_join(first);
+    actor_system_stats(&stats);
+
+    mu_assert("handled while owner busy", waited);
+    mu_assert("stolen", stats.total.steals > 0);
+    return 0;
+}
+
+static char *all_tests()
+{
+    mu_run_test(busy_worker_is_robbed);
+    return 0;
+}
+
+int main()
+{
+    char *result = all_tests();
+    if (result != 0)
+    {
+        printf(__FILE__ ": %s\n", result);
+    }
+    else
+    {
+        printf(__FILE__ ": ALL TESTS PASSED\n");
+    }
+    printf(__FILE__ ": Tests run: %d\n", tests_run);
+
+    return result != 0;
+}
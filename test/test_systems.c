@@ -0,0 +1,259 @@
+#include "minunit.h"
+#include "cacti.h"
+
+#include <pthread.h>
+#include <sched.h>
+#include <signal.h>
+#include <stdatomic.h>
+#include <stdio.h>
+#include <time.h>
+
+#define MSG_PING (1)
+#define PINGS (100)
+#define SIGNAL_ROUNDS (100)
+#define GODIE_ROUNDS (200)
+
+int tests_run = 0;
+
+static cacti_system_t *seen_fast;
+static cacti_system_t *seen_batch;
+static int pings_fast;
+static int pings_batch;
+
+static void hello_fast(void **stateptr, size_t nbytes, void *data);
+static void ping_fast(void **stateptr, size_t nbytes, void *data);
+static void hello_batch(void **stateptr, size_t nbytes, void *data);
+static void ping_batch(void **stateptr, size_t nbytes, void *data);
+
+static act_t acts_fast[] = {&hello_fast, &ping_fast};
+static act_t acts_batch[] = {&hello_batch, &ping_batch};
+static role_t role_fast = {.nprompts = 2, .prompts = acts_fast};
+static role_t role_batch = {.nprompts = 2, .prompts = acts_batch};
+
+static void hello_fast(void **stateptr, size_t nbytes, void *data)
+{
+    (void) stateptr; (void) nbytes; (void) data;
+
+    seen_fast = cacti_system_self();
+}
+
+static void hello_batch(void **stateptr, size_t nbytes, void *data)
+{
+    (void) stateptr; (void) nbytes; (void) data;
+
+    seen_batch = cacti_system_self();
+}
+
+// Wysyłka bez uchwytu z wątku systemu trafia do tego samego systemu.
+static void ping_fast(void **stateptr, size_t nbytes, void *data)
+{
+    (void) stateptr; (void) nbytes; (void) data;
+
+    if (++pings_fast == PINGS) {
+        send_message(actor_id_self(), (message_t){.message_type = MSG_GODIE});
+    }
+}
+
+static void ping_batch(void **stateptr, size_t nbytes, void *data)
+{
+    (void) stateptr; (void) nbytes; (void) data;
+
+    if (++pings_batch == PINGS) {
+        send_message(actor_id_self(), (message_t){.message_type = MSG_GODIE});
+    }
+}
+
+static char *systems_are_isolated()
+{
+    actor_system_config_t fast_config = {.pool_size = 1};
+    actor_system_config_t batch_config = {.pool_size = 2};
+    cacti_system_t *fast;
+    cacti_system_t *batch;
+    actor_id_t fast_actor;
+    actor_id_t batch_actor;
+    system_stats_t stats;
+
+    mu_assert("create fast", cacti_system_create(&fast, &fast_actor, &role_fast, &fast_config) == 0);
+    mu_assert("create batch", cacti_system_create(&batch, &batch_actor, &role_batch, &batch_config) == 0);
+    // Numery aktorów są lokalne dla systemu.
+    mu_assert("same first id", fast_actor == batch_actor);
+
+    for (int i = 0; i < PINGS; i++) {
+        mu_assert("ping fast", cacti_send_message(fast, fast_actor, (message_t){.message_type = MSG_PING}) == 0);
+        mu_assert("ping batch", cacti_send_message(batch, batch_actor, (message_t){.message_type = MSG_PING}) == 0);
+    }
+
+    cacti_system_join(fast);
+    cacti_system_join(batch);
+
+    mu_assert("fast got its pings", pings_fast == PINGS);
+    mu_assert("batch got its pings", pings_batch == PINGS);
+    mu_assert("fast handle seen", seen_fast == fast);
+    mu_assert("batch handle seen", seen_batch == batch);
+
+    cacti_system_stats(fast, &stats);
+    mu_assert("fast pool", stats.workers_num == 1);
+    cacti_system_stats(batch, &stats);
+    mu_assert("batch pool", stats.workers_num == 2);
+
+    mu_assert("joined system rejects", cacti_send_message(fast, fast_actor, (message_t){.message_type = MSG_PING}) == -4);
+
+    cacti_system_free(fast);
+    cacti_system_free(batch);
+    return 0;
+}
+
+static char *default_system_is_single()
+{
+    cacti_system_t *other;
+    actor_id_t first;
+    actor_id_t second;
+    actor_id_t other_actor;
+
+    pings_fast = 0;
+    mu_assert("create default", actor_system_create(&first, &role_fast) == 0);
+    mu_assert("second default rejected", actor_system_create(&second, &role_fast) == -3);
+    // Obok domyślnego może działać dowolnie wiele systemów z uchwytem.
+    mu_assert("create other", cacti_system_create(&other, &other_actor, &role_batch, NULL) == 0);
+
+    for (int i = 0; i < PINGS; i++) {
+        mu_assert("ping default", send_message(first, (message_t){.message_type = MSG_PING}) == 0);
+    }
+
+    cacti_send_message(other, other_actor, (message_t){.message_type = MSG_GODIE});
+
+    actor_system_join(first);
+    cacti_system_join(other);
+    cacti_system_free(other);
+
+    mu_assert("default got its pings", pings_fast == PINGS);
+    mu_assert("recreate default", actor_system_create(&first, &role_fast) == 0);
+    send_message(first, (message_t){.message_type = MSG_GODIE});
+    actor_system_join(first);
+    return 0;
+}
+
+static atomic_bool poked;
+
+static void poke(void **stateptr, size_t nbytes, void *data)
+{
+    (void) stateptr; (void) nbytes; (void) data;
+
+    poked = true;
+}
+
+static act_t poke_acts[] = {&hello_batch, &poke};
+static role_t poke_role = {.nprompts = 2, .prompts = poke_acts};
+
+/* Ostatnią wiadomość systemu wysyła wątek spoza puli i budzi nią uśpiony wątek.
+ * Ostatni wątek puli niszczy tablicę aktorów dopiero, gdy wysyłający skończy
+ * z odbiorcą. */
+static char *outside_godie_races_teardown()
+{
+    actor_system_config_t config = {.pool_size = 2, .idle_spins = IDLE_NONE, .idle_yields = IDLE_NONE};
+    cacti_system_t *sys;
+    actor_id_t first;
+
+    for (int i = 0; i < GODIE_ROUNDS; i++) {
+        poked = false;
+        mu_assert("create", cacti_system_create(&sys, &first, &poke_role, &config) == 0);
+        mu_assert("poke", cacti_send_message(sys, first, (message_t){.message_type = MSG_PING}) == 0);
+
+        while (!poked) {
+            sched_yield();
+        }
+
+        mu_assert("godie", cacti_send_message(sys, first, (message_t){.message_type = MSG_GODIE}) == 0);
+        cacti_system_join(sys);
+        cacti_system_free(sys);
+    }
+
+    return 0;
+}
+
+static void spin(void **stateptr, size_t nbytes, void *data)
+{
+    (void) stateptr; (void) nbytes; (void) data;
+
+    send_message(actor_id_self(), (message_t){.message_type = MSG_HELLO});
+}
+
+static act_t spin_acts[] = {&spin};
+static role_t spin_role = {.nprompts = 1, .prompts = spin_acts};
+static pthread_t main_thread;
+static atomic_bool creating;
+
+static void count_interrupt(int sig)
+{
+    (void) sig;
+}
+
+// Wysyła SIGINT głównemu wątkowi, także gdy ten tworzy lub dołącza systemy.
+static void *interrupter(void *arg)
+{
+    (void) arg;
+
+    while (creating) {
+        pthread_kill(main_thread, SIGINT);
+        nanosleep(&(struct timespec){.tv_nsec = 100000}, NULL);
+    }
+
+    return NULL;
+}
+
+/* Aktorzy obu systemów wysyłają sobie wiadomości bez końca, więc systemy kończy
+ * tylko SIGINT. Obsługa sygnału nie bierze mutexów, więc sygnał w trakcie
+ * tworzenia lub dołączania systemu niczego nie blokuje. */
+static char *signal_during_create_and_join()
+{
+    actor_system_config_t config = {.pool_size = 2};
+    struct sigaction counter = {.sa_handler = count_interrupt};
+    cacti_system_t *first;
+    cacti_system_t *second;
+    actor_id_t ignored;
+    pthread_t thread;
+
+    // Sygnał spoza działania systemów trafia do naszej obsługi, a nie kończy procesu.
+    sigaction(SIGINT, &counter, NULL);
+    main_thread = pthread_self();
+    creating = true;
+    mu_assert("interrupter", pthread_create(&thread, NULL, interrupter, NULL) == 0);
+
+    for (int i = 0; i < SIGNAL_ROUNDS; i++) {
+        mu_assert("create first", cacti_system_create(&first, &ignored, &spin_role, &config) == 0);
+        mu_assert("create second", cacti_system_create(&second, &ignored, &spin_role, &config) == 0);
+        cacti_system_join(first);
+        cacti_system_join(second);
+        cacti_system_free(first);
+        cacti_system_free(second);
+    }
+
+    creating = false;
+    pthread_join(thread, NULL);
+    return 0;
+}
+
+static char *all_tests()
+{
+    mu_run_test(systems_are_isolated);
+    mu_run_test(default_system_is_single);
+    mu_run_test(outside_godie_races_teardown);
+    mu_run_test(signal_during_create_and_join);
+    return 0;
+}
+
+int main()
+{
+    char *result = all_tests();
+    if (result != 0)
+    {
+        printf(__FILE__ ": %s\n", result);
+    }
+    else
+    {
+        printf(__FILE__ ": ALL TESTS PASSED\n");
+    }
+    printf(__FILE__ ": Tests run: %d\n", tests_run);
+
+    return result != 0;
+}
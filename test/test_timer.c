@@ -0,0 +1,200 @@
+#include "minunit.h"
+#include "cacti.h"
+
+#include <stdbool.h>
+#include <stdio.h>
+#include <time.h>
+
+#define MSG_ONCE (1)
+#define MSG_TICK (2)
+#define MSG_MANY (3)
+#define DELAY_US (20000)
+#define PERIOD_US (5000)
+#define TICKS (5)
+#define TIMERS (2000)
+#define MSG_DEADLINE (1)
+#define FULL_LIMIT (2)
+#define FULL_TICKS (20)
+
+int tests_run = 0;
+
+static unsigned long long started_ns;
+static unsigned long long once_after_ns;
+static int ticks;
+static int many;
+static int cancel_result;
+static int cancel_again_result;
+static timer_id_t periodic;
+
+static unsigned long long clock_ns()
+{
+    struct timespec ts;
+
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+
+    return (unsigned long long) ts.tv_sec * 1000000000ull + (unsigned long long) ts.tv_nsec;
+}
+
+static void maybe_die()
+{
+    if (once_after_ns != 0 && ticks == TICKS && many == TIMERS) {
+        send_message(actor_id_self(), (message_t){.message_type = MSG_GODIE});
+    }
+}
+
+static void hello(void **stateptr, size_t nbytes, void *data)
+{
+    (void) stateptr; (void) nbytes; (void) data;
+
+    timer_id_t cancelled;
+
+    started_ns = clock_ns();
+    send_message_after(actor_id_self(), (message_t){.message_type = MSG_ONCE}, DELAY_US);
+    periodic = send_message_every(actor_id_self(), (message_t){.message_type = MSG_TICK}, PERIOD_US, PERIOD_US);
+
+    for (long i = 0; i < TIMERS; i++) {
+        send_message_after(actor_id_self(), (message_t){.message_type = MSG_MANY}, (unsigned long long) (i % 50) * 1000);
+    }
+
+    cancelled = send_message_after(actor_id_self(), (message_t){.message_type = MSG_GODIE}, DELAY_US);
+    cancel_result = cancel_timer(cancelled);
+    cancel_again_result = cancel_timer(cancelled);
+}
+
+static void once(void **stateptr, size_t nbytes, void *data)
+{
+    (void) stateptr; (void) nbytes; (void) data;
+
+    once_after_ns = clock_ns() - started_ns;
+    maybe_die();
+}
+
+/* Odpalenie zegara okresowego mogło już czekać w skrzynce w chwili jego usunięcia,
+ * więc takie spóźnione tyknięcia liczymy osobno. */
+static void tick(void **stateptr, size_t nbytes, void *data)
+{
+    (void) stateptr; (void) nbytes; (void) data;
+
+    if (periodic < 0) {
+        return;
+    }
+
+    if (++ticks == TICKS) {
+        cancel_timer(periodic);
+        periodic = -1;
+        maybe_die();
+    }
+}
+
+static void count(void **stateptr, size_t nbytes, void *data)
+{
+    (void) stateptr; (void) nbytes; (void) data;
+
+    many++;
+    maybe_die();
+}
+
+static act_t acts[] = {&hello, &once, &tick, &count};
+static role_t role = {.nprompts = 4, .prompts = acts};
+
+static char *timers()
+{
+    actor_system_config_t config = {.queue_limit = QUEUE_UNLIMITED};
+    actor_id_t first;
+
+    mu_assert("create", actor_system_create_ex(&first, &role, &config) == 0);
+    actor_system_join(first);
+
+    mu_assert("delayed message", once_after_ns >= DELAY_US * 1000ull);
+    mu_assert("periodic stopped", ticks == TICKS);
+    mu_assert("all timers fired", many == TIMERS);
+    mu_assert("cancelled", cancel_result == 0 && cancel_again_result == -1);
+    return 0;
+}
+
+static timer_id_t flooding;
+static timer_id_t deadline;
+static int flood_ticks;
+
+static void flood_hello(void **stateptr, size_t nbytes, void *data)
+{
+    (void) stateptr; (void) nbytes; (void) data;
+
+    flood_ticks = 0;
+    flooding = send_message_every(actor_id_self(), (message_t){.message_type = MSG_TICK}, 1000, 1000);
+    deadline = send_message_after(actor_id_self(), (message_t){.message_type = MSG_DEADLINE}, 500000);
+}
+
+static void flood_deadline(void **stateptr, size_t nbytes, void *data)
+{
+    (void) stateptr; (void) nbytes; (void) data;
+
+    cancel_timer(flooding);
+    send_message(actor_id_self(), (message_t){.message_type = MSG_GODIE});
+}
+
+/* Pierwsze tyknięcie zajmuje aktora na tyle długo, że kolejne trafiają na
+ * pełną skrzynkę. Zegar pomija je i tyka dalej. */
+static void flood_tick(void **stateptr, size_t nbytes, void *data)
+{
+    (void) stateptr; (void) nbytes; (void) data;
+
+    if (flood_ticks++ == 0) {
+        nanosleep(&(struct timespec){.tv_nsec = 20000000}, NULL);
+    }
+
+    if (flood_ticks == FULL_TICKS) {
+        cancel_timer(deadline);
+        flood_deadline(stateptr, nbytes, data);
+    }
+}
+
+static act_t flood_acts[] = {&flood_hello, &flood_deadline, &flood_tick};
+static role_t flood_role = {.nprompts = 3, .prompts = flood_acts, .overflow = OVERFLOW_ERROR};
+
+static char *periodic_survives_full_mailbox()
+{
+    actor_system_config_t config = {.pool_size = 1, .queue_limit = FULL_LIMIT};
+    system_stats_t stats;
+    cacti_system_t *sys;
+    actor_id_t first;
+
+    mu_assert("create", cacti_system_create(&sys, &first, &flood_role, &config) == 0);
+    cacti_system_join(sys);
+    cacti_system_stats(sys, &stats);
+    cacti_system_free(sys);
+
+    mu_assert("ticks rejected", stats.dropped > 0);
+    mu_assert("kept ticking", flood_ticks >= FULL_TICKS);
+    return 0;
+}
+
+static char *no_system()
+{
+    mu_assert("no system", send_message_after(0, (message_t){.message_type = MSG_ONCE}, 0) < 0);
+    return 0;
+}
+
+static char *all_tests()
+{
+    mu_run_test(timers);
+    mu_run_test(periodic_survives_full_mailbox);
+    mu_run_test(no_system);
+    return 0;
+}
+
+int main()
+{
+    char *result = all_tests();
+    if (result != 0)
+    {
+        printf(__FILE__ ": %s\n", result);
+    }
+    else
+    {
+        printf(__FILE__ ": ALL TESTS PASSED\n");
+    }
+    printf(__FILE__ ": Tests run: %d\n", tests_run);
+
+    return result != 0;
+}
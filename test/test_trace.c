@@ -0,0 +1,143 @@
+#include "minunit.h"
+#include "cacti.h"
+
+#include <stdbool.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <unistd.h>
+
+#define TRACE_FILE "test_trace.json"
+
+int tests_run = 0;
+
+static role_t role;
+
+static void hello(void **stateptr, size_t nbytes, void *data)
+{
+    (void) stateptr; (void) nbytes;
+
+    // Pierwszy aktor tworzy jedno dziecko, a każdy aktor od razu kończy pracę.
+    if (data == NULL && actor_id_self() == 0) {
+        send_message(actor_id_self(), (message_t){.message_type = MSG_SPAWN, .data = &role});
+    }
+
+    send_message(actor_id_self(), (message_t){.message_type = MSG_GODIE});
+}
+
+static act_t acts[] = {&hello};
+static role_t role = {.nprompts = 1, .prompts = acts};
+
+static char *read_file(const char *path)
+{
+    FILE *file = fopen(path, "r");
+    char *content;
+    long size;
+
+    if (file == NULL) {
+        return NULL;
+    }
+
+    fseek(file, 0, SEEK_END);
+    size = ftell(file);
+    fseek(file, 0, SEEK_SET);
+
+    content = calloc((size_t) size + 1, 1);
+
+    if (content != NULL && fread(content, 1, (size_t) size, file) != (size_t) size) {
+        free(content);
+        content = NULL;
+    }
+
+    fclose(file);
+    return content;
+}
+
+static char *trace_written()
+{
+    actor_system_config_t config = {.trace_path = TRACE_FILE, .trace_events = 16};
+    actor_id_t first;
+    char *content;
+
+    unlink(TRACE_FILE);
+    unsetenv(TRACE_PATH_ENV);
+
+    mu_assert("create", actor_system_create_ex(&first, &role, &config) == 0);
+    actor_system_join(first);
+
+    content = read_file(TRACE_FILE);
+    mu_assert("trace file", content != NULL);
+    mu_assert("json object", content[0] == '{' && strstr(content, "\"traceEvents\":[") != NULL);
+    mu_assert("activation", strstr(content, "\"name\":\"activation\",\"ph\":\"X\"") != NULL);
+    mu_assert("spawn", strstr(content, "\"name\":\"spawn\"") != NULL);
+    mu_assert("godie", strstr(content, "\"name\":\"godie\"") != NULL);
+    mu_assert("worker thread", strstr(content, "\"name\":\"worker 0\"") != NULL);
+
+    free(content);
+    unlink(TRACE_FILE);
+    return 0;
+}
+
+static int count_matches(const char *content, const char *needle)
+{
+    int found = 0;
+
+    for (const char *it = content; (it = strstr(it, needle)) != NULL; it++) {
+        found++;
+    }
+
+    return found;
+}
+
+static char *systems_as_processes()
+{
+    actor_system_config_t config = {.pool_size = 1, .trace_path = TRACE_FILE, .trace_events = 16};
+    cacti_system_t *systems[2];
+    actor_id_t actors[2];
+    char *content;
+
+    unlink(TRACE_FILE);
+    unsetenv(TRACE_PATH_ENV);
+
+    // Systemy działające naraz trafiają do jednego pliku, każdy jako osobny proces.
+    for (int i = 0; i < 2; i++) {
+        mu_assert("create", cacti_system_create(&systems[i], &actors[i], &role, &config) == 0);
+    }
+
+    for (int i = 0; i < 2; i++) {
+        cacti_system_free(systems[i]);
+    }
+
+    content = read_file(TRACE_FILE);
+    mu_assert("trace file", content != NULL);
+    mu_assert("process per system", count_matches(content, "\"name\":\"process_name\"") == 2);
+    mu_assert("worker per system", count_matches(content, "\"name\":\"worker 0\"") == 2);
+    mu_assert("closed", strstr(content, "\n]}\n") != NULL);
+
+    free(content);
+    unlink(TRACE_FILE);
+    return 0;
+}
+
+static char *all_tests()
+{
+    mu_run_test(trace_written);
+    mu_run_test(systems_as_processes);
+    return 0;
+}
+
+int main()
+{
+    char *result = all_tests();
+    if (result != 0)
+    {
+        printf(__FILE__ ": %s\n", result);
+    }
+    else
+    {
+        printf(__FILE__ ": ALL TESTS PASSED\n");
+    }
+    printf(__FILE__ ": Tests run: %d\n", tests_run);
+
+    return result != 0;
+}
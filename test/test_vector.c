@@ -0,0 +1,108 @@
+#include "minunit.h"
+#include "cacti.h"
+
+#include <stdatomic.h>
+#include <stdio.h>
+
+#define MSG_PING (1)
+// VECTOR_CHUNK_SIZE w cacti.c.
+#define CHUNK (1024)
+#define ACTORS (3 * CHUNK + 2)
+
+int tests_run = 0;
+
+static atomic_long spawned;
+static atomic_long pinged;
+static atomic_long misrouted;
+static atomic_long max_slot;
+static actor_id_t ids[ACTORS];
+
+static void hello(void **stateptr, size_t nbytes, void *data);
+static void ping(void **stateptr, size_t nbytes, void *data);
+
+static act_t acts[] = {&hello, &ping};
+static role_t role = {.nprompts = 2, .prompts = acts};
+
+static void note_slot(actor_id_t id)
+{
+    long slot = id % CAST_LIMIT;
+    long seen = atomic_load(&max_slot);
+
+    while (slot > seen && !atomic_compare_exchange_weak(&max_slot, &seen, slot)) {
+    }
+}
+
+/* Każdy aktor tworzy następnego i wysyła wiadomość swojemu rodzicowi, więc
+ * odczyty tablicy aktorów przeplatają się z jej rozrastaniem o kolejne kawałki.
+ * Aktorzy żyją do końca testu, więc ich miejsca nie są używane ponownie. */
+static void hello(void **stateptr, size_t nbytes, void *data)
+{
+    (void) stateptr; (void) nbytes;
+    actor_id_t self = actor_id_self();
+    long order = atomic_fetch_add(&spawned, 1);
+
+    ids[order] = self;
+    note_slot(self);
+
+    if (order + 1 < ACTORS) {
+        send_message(self, (message_t){.message_type = MSG_SPAWN, .data = &role});
+    }
+
+    // Pierwszy aktor nie ma rodzica, a 'data' jego dziecka to numer 0.
+    if (order > 0) {
+        send_message((actor_id_t) data, (message_t){.message_type = MSG_PING, .data = data});
+    }
+}
+
+// Wiadomość musi trafić do aktora o numerze, pod który ją wysłano.
+static void ping(void **stateptr, size_t nbytes, void *data)
+{
+    (void) stateptr; (void) nbytes;
+
+    if ((actor_id_t) data != actor_id_self()) {
+        misrouted++;
+    }
+
+    // Ostatni aktor nie ma dziecka, więc wiadomości jest o jedną mniej.
+    if (++pinged == ACTORS - 1) {
+        for (int i = 0; i < ACTORS; i++) {
+            send_message(ids[i], (message_t){.message_type = MSG_GODIE});
+        }
+    }
+}
+
+static char *growth_across_chunks()
+{
+    actor_id_t first;
+
+    mu_assert("create", actor_system_create(&first, &role) == 0);
+    actor_system_join(first);
+
+    mu_assert("all spawned", spawned == ACTORS);
+    mu_assert("beyond first chunks", max_slot == ACTORS - 1);
+    mu_assert("all pinged", pinged == ACTORS - 1);
+    mu_assert("lookups hit their actor", misrouted == 0);
+    return 0;
+}
+
+static char *all_tests()
+{
+    mu_run_test(growth_across_chunks);
+    return 0;
+}
+
+int main()
+{
+    char *result = all_tests();
+    if (result != 0)
+    {
+        printf(__FILE__ ": %s\n", result);
+    }
+    else
+    {
+        printf(__FILE__ ": ALL TESTS PASSED\n");
+    }
+    printf(__FILE__ ": Tests run: %d\n", tests_run);
+
+    return result != 0;
+}
@@ -0,0 +1,238 @@
+#define _GNU_SOURCE
+#include <pthread.h>
+#include <stdbool.h>
+#include <stdlib.h>
+#include "thread_cache.h"
+#include "cacti.h"
+#include "err.h"
+
+struct cached_thread {
+    pthread_t thread;
+    pthread_cond_t wake; // Sygnalizowana, gdy wątek dostał zadanie lub ma się zakończyć.
+    pthread_cond_t done; // Sygnalizowana po każdym wykonanym zadaniu.
+    void *(*fn)(void *); // Bieżące zadanie, NULL = wątek czeka.
+    void *arg;
+    unsigned long long started;
+    unsigned long long finished;
+    bool pinned;         // Czy wątek ma zmienione procesory.
+    bool exit;
+    cpu_set_t initial;   // Procesory, na których wątek został utworzony.
+    struct cached_thread *next; // Następny czekający wątek.
+};
+
+typedef struct cached_thread cached_thread_t;
+
+static pthread_mutex_t cache_mutex = PTHREAD_MUTEX_INITIALIZER;
+static cached_thread_t *idle = NULL;
+static size_t idle_num = 0;
+
+static void cache_lock() {
+    int res;
+
+    if ((res = pthread_mutex_lock(&cache_mutex)) != 0) {
+        syserr(res, "Thread cache mutex failed!\n");
+    }
+}
+
+static void cache_unlock() {
+    int res;
+
+    if ((res = pthread_mutex_unlock(&cache_mutex)) != 0) {
+        syserr(res, "Thread cache mutex failed!\n");
+    }
+}
+
+static void *cached_thread_main(void *arg) {
+    cached_thread_t *thread = arg;
+    int res;
+
+    cache_lock();
+
+    while (1) {
+        while (thread->fn == NULL && !thread->exit) {
+            if ((res = pthread_cond_wait(&thread->wake, &cache_mutex)) != 0) {
+                syserr(res, "Thread cache wait failed!\n");
+            }
+        }
+
+        if (thread->exit) {
+            break;
+        }
+
+        void *(*fn)(void *) = thread->fn;
+        void *fn_arg = thread->arg;
+
+        cache_unlock();
+        fn(fn_arg);
+        cache_lock();
+
+        thread->fn = NULL;
+        thread->finished++;
+        thread->next = idle;
+        idle = thread;
+        idle_num++;
+
+        if ((res = pthread_cond_broadcast(&thread->done)) != 0) {
+            syserr(res, "Thread cache signal failed!\n");
+        }
+    }
+
+    cache_unlock();
+
+    return NULL;
+}
+
+// Tworzy nowy wątek, który od razu wykona 'fn', o ile nie jest NULL. Wymaga mutexa.
+static cached_thread_t *spawn_thread(void *(*fn)(void *), void *arg, const cpu_set_t *cpus) {
+    cached_thread_t *thread = malloc(sizeof (cached_thread_t));
+    pthread_attr_t attr;
+    int res;
+
+    if (thread == NULL) {
+        fatal("Thread cache allocation failed!\n");
+    }
+
+    thread->fn = fn;
+    thread->arg = arg;
+    thread->started = fn != NULL ? 1 : 0;
+    thread->finished = 0;
+    thread->pinned = cpus != NULL;
+    thread->exit = false;
+    thread->next = NULL;
+
+    if ((res = pthread_getaffinity_np(pthread_self(), sizeof (cpu_set_t), &thread->initial)) != 0) {
+        syserr(res, "Reading thread affinity failed!\n");
+    }
+
+    if ((res = pthread_cond_init(&thread->wake, NULL)) != 0 ||
+        (res = pthread_cond_init(&thread->done, NULL)) != 0) {
+        syserr(res, "Thread cache cond initialization failed!\n");
+    }
+
+    if ((res = pthread_attr_init(&attr)) != 0) {
+        syserr(res, "Thread attribute initialization failed!\n");
+    }
+
+    if (cpus != NULL && (res = pthread_attr_setaffinity_np(&attr, sizeof (cpu_set_t), cpus)) != 0) {
+        syserr(res, "Setting thread affinity failed!\n");
+    }
+
+    if ((res = pthread_create(&thread->thread, &attr, cached_thread_main, thread)) != 0) {
+        syserr(res, "Thread creation failed!\n");
+    }
+
+    pthread_attr_destroy(&attr);
+
+    return thread;
+}
+
+thread_ticket_t thread_cache_run(void *(*fn)(void *), void *arg, const cpu_set_t *cpus) {
+    cached_thread_t *thread;
+    int res;
+
+    cache_lock();
+
+    if (idle == NULL) {
+        thread = spawn_thread(fn, arg, cpus);
+        cache_unlock();
+
+        return (thread_ticket_t){.thread = thread, .run = 1};
+    }
+
+    thread = idle;
+    idle = thread->next;
+    idle_num--;
+
+    // Wątek czeka na zmiennej warunkowej, więc zmiana procesorów zadziała przed zadaniem.
+    if (cpus != NULL || thread->pinned) {
+        if ((res = pthread_setaffinity_np(thread->thread, sizeof (cpu_set_t),
+                                          cpus != NULL ? cpus : &thread->initial)) != 0) {
+            syserr(res, "Setting thread affinity failed!\n");
+        }
+
+        thread->pinned = cpus != NULL;
+    }
+
+    thread->fn = fn;
+    thread->arg = arg;
+    thread->started++;
+
+    thread_ticket_t ticket = {.thread = thread, .run = thread->started};
+
+    if ((res = pthread_cond_signal(&thread->wake)) != 0) {
+        syserr(res, "Thread cache signal failed!\n");
+    }
+
+    cache_unlock();
+
+    return ticket;
+}
+
+void thread_cache_wait(thread_ticket_t ticket) {
+    int res;
+
+    cache_lock();
+
+    // Po zakończeniu zadania wątek mógł już dostać następne, więc liczymy zadania.
+    while (ticket.thread->finished < ticket.run) {
+        if ((res = pthread_cond_wait(&ticket.thread->done, &cache_mutex)) != 0) {
+            syserr(res, "Thread cache wait failed!\n");
+        }
+    }
+
+    cache_unlock();
+}
+
+size_t thread_cache_warm(size_t threads) {
+    size_t result;
+
+    cache_lock();
+
+    while (idle_num < threads) {
+        cached_thread_t *thread = spawn_thread(NULL, NULL, NULL);
+
+        thread->next = idle;
+        idle = thread;
+        idle_num++;
+    }
+
+    result = idle_num;
+
+    cache_unlock();
+
+    return result;
+}
+
+void thread_cache_release() {
+    cached_thread_t *released;
+    int res;
+
+    cache_lock();
+
+    released = idle;
+    idle = NULL;
+    idle_num = 0;
+
+    for (cached_thread_t *thread = released; thread != NULL; thread = thread->next) {
+        thread->exit = true;
+
+        if ((res = pthread_cond_signal(&thread->wake)) != 0) {
+            syserr(res, "Thread cache signal failed!\n");
+        }
+    }
+
+    cache_unlock();
+
+    while (released != NULL) {
+        cached_thread_t *next = released->next;
+
+        if ((res = pthread_join(released->thread, NULL)) != 0) {
+            syserr(res, "Thread join failed!\n");
+        }
+
+        pthread_cond_destroy(&released->wake);
+        pthread_cond_destroy(&released->done);
+        free(released);
+        released = next;
+    }
+}
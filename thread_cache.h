@@ -0,0 +1,34 @@
+#ifndef CACTI_THREAD_CACHE_H
+#define CACTI_THREAD_CACHE_H
+
+#include <sched.h>
+#include <stddef.h>
+
+/* Wątki wielokrotnego użytku, wspólne dla całego procesu. Wątek, który wykonał
+ * zadanie, nie kończy się, tylko czeka na kolejne, więc pule kolejnych systemów
+ * aktorów nie płacą za tworzenie i niszczenie wątków. Plik włączający ten
+ * nagłówek musi zdefiniować _GNU_SOURCE przed pierwszym nagłówkiem systemowym. */
+
+struct cached_thread;
+
+// Zadanie zlecone wątkowi z pamięci podręcznej, służy do czekania na jego koniec.
+typedef struct thread_ticket {
+    struct cached_thread *thread;
+    unsigned long long run;
+} thread_ticket_t;
+
+/* Wykonuje 'fn(arg)' w czekającym wątku, a gdy takiego nie ma, w nowym. Jeżeli
+ * 'cpus' nie jest NULL, to wątek działa na czas zadania tylko na tych procesorach. */
+thread_ticket_t thread_cache_run(void *(*fn)(void *), void *arg, const cpu_set_t *cpus);
+
+// Czeka na zakończenie zadania, tak jak pthread_join.
+void thread_cache_wait(thread_ticket_t ticket);
+
+// Tworzy wątki, aż czeka ich co najmniej 'threads'. Zwraca liczbę czekających wątków.
+size_t thread_cache_warm(size_t threads);
+
+/* Kończy wszystkie czekające wątki. Nie wolno potem czekać na ich wcześniejsze
+ * zadania, więc wymaga, żeby na wszystkie już poczekano. */
+void thread_cache_release();
+
+#endif //CACTI_THREAD_CACHE_H
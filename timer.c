@@ -0,0 +1,455 @@
+#include <errno.h>
+#include <stdbool.h>
+#include <stdlib.h>
+#include <time.h>
+#include <pthread.h>
+#include "timer.h"
+#include "envelope_pool.h"
+#include "err.h"
+
+#define TIMER_NONE ((size_t) -1)
+#define TIMER_GENERATION_MASK (0x7fffffffu)
+
+/* Zegary leżą w tablicy węzłów i są łączone w listy numerami węzłów, więc
+ * tablicę można powiększać. Id zegara to numer węzła i jego pokolenie,
+ * zmieniane przy każdym ponownym użyciu węzła. */
+typedef struct timer_node {
+    unsigned generation;
+    bool active;
+    size_t level;
+    size_t slot;
+    size_t prev;
+    size_t next;
+    unsigned long long expires; // Numer kroku, w którym zegar ma się odpalić.
+    unsigned long long period;  // Okres w krokach, 0 dla zegarów jednorazowych.
+    actor_id_t actor;
+    message_t message;
+    envelope_loan_t *loan; // Dane na własność zegara okresowego, pożyczane wiadomościom.
+} timer_node_t;
+
+struct timer_wheel {
+    pthread_mutex_t mutex;
+    pthread_cond_t cond;
+    pthread_t thread;
+    bool running;
+    bool stopped;
+    timer_fire_t fire;
+    void *target;
+
+    timer_node_t *nodes;
+    size_t nodes_cap;
+    size_t free_head;
+    size_t timers_num;
+    size_t slots[TIMER_LEVELS][TIMER_SLOTS];
+    unsigned long long current; // Ostatni obsłużony krok.
+    unsigned long long base_ns; // Chwila kroku 0.
+};
+
+static void timer_lock(timer_wheel_t *wheel) {
+    int res;
+
+    if ((res = pthread_mutex_lock(&wheel->mutex)) != 0) {
+        syserr(res, "Timer mutex failed!\n");
+    }
+}
+
+static void timer_unlock(timer_wheel_t *wheel) {
+    int res;
+
+    if ((res = pthread_mutex_unlock(&wheel->mutex)) != 0) {
+        syserr(res, "Timer mutex failed!\n");
+    }
+}
+
+static unsigned long long clock_ns() {
+    struct timespec ts;
+
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+
+    return (unsigned long long) ts.tv_sec * 1000000000ull + (unsigned long long) ts.tv_nsec;
+}
+
+// Zwraca numer kroku, który właśnie trwa.
+static unsigned long long clock_tick(timer_wheel_t *wheel) {
+    return (clock_ns() - wheel->base_ns) / (TIMER_TICK_US * 1000ull);
+}
+
+/* Wstawia węzeł do przegródki odpowiadającej odległości jego terminu od bieżącego
+ * kroku. Zegary dalsze niż zasięg koła trafiają do ostatniego poziomu
+ * i są przekładane, gdy do niego dojdziemy. */
+static void wheel_insert(timer_wheel_t *wheel, size_t index) {
+    timer_node_t *node = &wheel->nodes[index];
+    unsigned long long current = wheel->current;
+    unsigned long long expires = node->expires;
+    unsigned long long delta;
+    size_t level = 0;
+
+    if (expires <= current) {
+        expires = current + 1;
+    }
+
+    delta = expires - current;
+
+    while (level + 1 < TIMER_LEVELS && delta >= 1ull << ((level + 1) * TIMER_SLOT_BITS)) {
+        level++;
+    }
+
+    if (delta >= 1ull << (TIMER_LEVELS * TIMER_SLOT_BITS)) {
+        expires = current + (1ull << (TIMER_LEVELS * TIMER_SLOT_BITS)) - 1;
+    }
+
+    node->level = level;
+    node->slot = (size_t) (expires >> (level * TIMER_SLOT_BITS)) & (TIMER_SLOTS - 1);
+    node->prev = TIMER_NONE;
+    node->next = wheel->slots[level][node->slot];
+
+    if (node->next != TIMER_NONE) {
+        wheel->nodes[node->next].prev = index;
+    }
+
+    wheel->slots[level][node->slot] = index;
+}
+
+static void wheel_remove(timer_wheel_t *wheel, size_t index) {
+    timer_node_t *node = &wheel->nodes[index];
+
+    if (node->prev != TIMER_NONE) {
+        wheel->nodes[node->prev].next = node->next;
+    }
+    else {
+        wheel->slots[node->level][node->slot] = node->next;
+    }
+
+    if (node->next != TIMER_NONE) {
+        wheel->nodes[node->next].prev = node->prev;
+    }
+}
+
+static void node_free(timer_wheel_t *wheel, size_t index) {
+    wheel->nodes[index].active = false;
+    wheel->nodes[index].next = wheel->free_head;
+    wheel->free_head = index;
+    wheel->timers_num--;
+}
+
+/* Oddaje dane na własność zegara, którego wiadomość nie zostanie już wysłana.
+ * Dane zegara okresowego są zwalniane dopiero z ostatnią pożyczającą je kopertą. */
+static void node_drop(timer_node_t *node) {
+    if (node->loan != NULL) {
+        envelope_loan_release(node->loan);
+        node->loan = NULL;
+    }
+    else if (node->message.destroy != NULL) {
+        node->message.destroy(node->message.data);
+    }
+}
+
+static size_t node_alloc(timer_wheel_t *wheel) {
+    if (wheel->free_head == TIMER_NONE) {
+        size_t cap = wheel->nodes_cap == 0 ? 64 : wheel->nodes_cap * 2;
+        timer_node_t *grown = realloc(wheel->nodes, sizeof (timer_node_t) * cap);
+
+        if (grown == NULL) {
+            fatal("Memory allocation failure!\n");
+        }
+
+        for (size_t i = cap; i-- > wheel->nodes_cap;) {
+            grown[i].generation = 0;
+            grown[i].active = false;
+            grown[i].next = wheel->free_head;
+            wheel->free_head = i;
+        }
+
+        wheel->nodes = grown;
+        wheel->nodes_cap = cap;
+    }
+
+    size_t index = wheel->free_head;
+    timer_node_t *node = &wheel->nodes[index];
+
+    wheel->free_head = node->next;
+    node->generation = (node->generation + 1) & TIMER_GENERATION_MASK;
+
+    if (node->generation == 0) {
+        node->generation = 1;
+    }
+
+    node->active = true;
+    wheel->timers_num++;
+
+    return index;
+}
+
+// Przekłada zegary z przegródki wyższego poziomu na niższe poziomy.
+static void wheel_cascade(timer_wheel_t *wheel, size_t level, size_t slot) {
+    size_t index = wheel->slots[level][slot];
+
+    wheel->slots[level][slot] = TIMER_NONE;
+
+    while (index != TIMER_NONE) {
+        size_t next = wheel->nodes[index].next;
+
+        wheel_insert(wheel, index);
+        index = next;
+    }
+}
+
+/* Wysyła kolejną wiadomość zegara okresowego. Zwraca, czy zegar ma działać dalej:
+ * przy pełnej skrzynce tylko to odpalenie przepada, a zegar jest usuwany dopiero
+ * wtedy, gdy aktor nie żyje lub nie istnieje. */
+static bool wheel_fire_periodic(timer_wheel_t *wheel, timer_node_t *node) {
+    int err = wheel->fire(wheel->target, node->actor, node->message, node->loan);
+
+    return err == 0 || err == MAILBOX_FULL;
+}
+
+// Przesuwa koło o jeden krok, odpalając zegary, których termin właśnie minął.
+static void wheel_advance(timer_wheel_t *wheel) {
+    unsigned long long current = ++wheel->current;
+
+    for (size_t level = 1; level < TIMER_LEVELS; level++) {
+        if ((current & ((1ull << (level * TIMER_SLOT_BITS)) - 1)) != 0) {
+            break;
+        }
+
+        wheel_cascade(wheel, level, (size_t) (current >> (level * TIMER_SLOT_BITS)) & (TIMER_SLOTS - 1));
+    }
+
+    size_t slot = (size_t) current & (TIMER_SLOTS - 1);
+    size_t index = wheel->slots[0][slot];
+
+    wheel->slots[0][slot] = TIMER_NONE;
+
+    while (index != TIMER_NONE) {
+        timer_node_t *node = &wheel->nodes[index];
+        size_t next = node->next;
+
+        /* Zegar jednorazowy oddaje dane na własność odbiorcy (lub wysyłce, która
+         * je zwolni), a okresowy pożycza je wiadomości, bez 'destroy'. */
+        if (node->expires > current) {
+            // Zegar przełożony z ostatniego poziomu, którego termin jest jeszcze dalej.
+            wheel_insert(wheel, index);
+        }
+        else if (node->period == 0) {
+            wheel->fire(wheel->target, node->actor, node->message, NULL);
+            node_free(wheel, index);
+        }
+        else if (wheel_fire_periodic(wheel, node)) {
+            node->expires += node->period;
+            wheel_insert(wheel, index);
+        }
+        else {
+            node_drop(node);
+            node_free(wheel, index);
+        }
+
+        index = next;
+    }
+}
+
+static void *timer_worker(void *arg) {
+    timer_wheel_t *wheel = arg;
+    struct timespec deadline;
+    int res;
+
+    timer_lock(wheel);
+
+    while (!wheel->stopped) {
+        unsigned long long target = clock_tick(wheel);
+
+        if (wheel->timers_num == 0 && wheel->current < target) {
+            wheel->current = target;
+        }
+
+        while (wheel->current < target && wheel->timers_num > 0) {
+            wheel_advance(wheel);
+        }
+
+        if (wheel->timers_num == 0) {
+            res = pthread_cond_wait(&wheel->cond, &wheel->mutex);
+        }
+        else {
+            unsigned long long wake = wheel->base_ns + (wheel->current + 1) * TIMER_TICK_US * 1000ull;
+
+            deadline.tv_sec = (time_t) (wake / 1000000000ull);
+            deadline.tv_nsec = (long) (wake % 1000000000ull);
+            res = pthread_cond_timedwait(&wheel->cond, &wheel->mutex, &deadline);
+        }
+
+        if (res != 0 && res != ETIMEDOUT) {
+            syserr(res, "Timer wait failed!\n");
+        }
+    }
+
+    timer_unlock(wheel);
+
+    envelope_pool_flush();
+
+    return NULL;
+}
+
+timer_wheel_t *timer_wheel_create(timer_fire_t fire, void *target) {
+    timer_wheel_t *wheel = malloc(sizeof (timer_wheel_t));
+    pthread_condattr_t attr;
+    int res;
+
+    if (wheel == NULL) {
+        fatal("Memory allocation failure!\n");
+    }
+
+    if ((res = pthread_mutex_init(&wheel->mutex, NULL)) != 0) {
+        syserr(res, "Timer mutex initialization failure!\n");
+    }
+
+    if ((res = pthread_condattr_init(&attr)) != 0 ||
+        (res = pthread_condattr_setclock(&attr, CLOCK_MONOTONIC)) != 0 ||
+        (res = pthread_cond_init(&wheel->cond, &attr)) != 0) {
+        syserr(res, "Timer conditional initialization failure!\n");
+    }
+
+    pthread_condattr_destroy(&attr);
+
+    for (size_t level = 0; level < TIMER_LEVELS; level++) {
+        for (size_t slot = 0; slot < TIMER_SLOTS; slot++) {
+            wheel->slots[level][slot] = TIMER_NONE;
+        }
+    }
+
+    wheel->running = false;
+    wheel->stopped = false;
+    wheel->fire = fire;
+    wheel->target = target;
+    wheel->nodes = NULL;
+    wheel->nodes_cap = 0;
+    wheel->free_head = TIMER_NONE;
+    wheel->timers_num = 0;
+    wheel->base_ns = clock_ns();
+    wheel->current = 0;
+
+    return wheel;
+}
+
+timer_id_t timer_add(timer_wheel_t *wheel, actor_id_t actor, message_t message,
+                     unsigned long long delay_us, unsigned long long period_us) {
+    unsigned long long tick_us = TIMER_TICK_US;
+    timer_id_t id;
+    int res;
+
+    timer_lock(wheel);
+
+    if (wheel->stopped) {
+        timer_unlock(wheel);
+        return -1;
+    }
+
+    if (!wheel->running) {
+        if ((res = pthread_create(&wheel->thread, NULL, timer_worker, wheel)) != 0) {
+            syserr(res, "Timer thread creation failed!\n");
+        }
+
+        wheel->running = true;
+    }
+
+    size_t index = node_alloc(wheel);
+    timer_node_t *node = &wheel->nodes[index];
+    unsigned long long deadline_ns = clock_ns() - wheel->base_ns + delay_us * 1000ull;
+
+    // Termin zaokrąglamy w górę, żeby zegar nie odpalił się przed czasem.
+    node->expires = (deadline_ns + tick_us * 1000ull - 1) / (tick_us * 1000ull);
+    node->period = period_us == 0 ? 0 : (period_us + tick_us - 1) / tick_us;
+    node->actor = actor;
+    node->message = message;
+    node->loan = NULL;
+
+    if (node->period > 0 && message.destroy != NULL) {
+        node->loan = envelope_loan_create(message.data, message.destroy);
+        node->message.destroy = NULL;
+    }
+
+    wheel_insert(wheel, index);
+
+    id = (timer_id_t) (((unsigned long) node->generation << 32) | index);
+
+    if ((res = pthread_cond_signal(&wheel->cond)) != 0) {
+        syserr(res, "Timer signal failed!\n");
+    }
+
+    timer_unlock(wheel);
+
+    return id;
+}
+
+int timer_cancel(timer_wheel_t *wheel, timer_id_t timer) {
+    size_t index = (size_t) ((unsigned long) timer & 0xffffffffu);
+    unsigned generation = (unsigned) ((unsigned long) timer >> 32);
+    int result = -1;
+
+    timer_lock(wheel);
+
+    if (timer > 0 && index < wheel->nodes_cap && wheel->nodes[index].active &&
+        wheel->nodes[index].generation == generation) {
+        wheel_remove(wheel, index);
+        node_drop(&wheel->nodes[index]);
+        node_free(wheel, index);
+        result = 0;
+    }
+
+    timer_unlock(wheel);
+
+    return result;
+}
+
+void timer_shutdown(timer_wheel_t *wheel) {
+    bool join;
+    int res;
+
+    timer_lock(wheel);
+
+    join = wheel->running;
+    wheel->stopped = true;
+    wheel->running = false;
+
+    if ((res = pthread_cond_signal(&wheel->cond)) != 0) {
+        syserr(res, "Timer signal failed!\n");
+    }
+
+    timer_unlock(wheel);
+
+    if (join && (res = pthread_join(wheel->thread, NULL)) != 0) {
+        syserr(res, "Timer thread join failed!\n");
+    }
+
+    timer_lock(wheel);
+
+    for (size_t i = 0; i < wheel->nodes_cap; i++) {
+        if (wheel->nodes[i].active) {
+            node_drop(&wheel->nodes[i]);
+        }
+    }
+
+    free(wheel->nodes);
+    wheel->nodes = NULL;
+    wheel->nodes_cap = 0;
+    wheel->free_head = TIMER_NONE;
+    wheel->timers_num = 0;
+
+    timer_unlock(wheel);
+}
+
+void timer_wheel_destroy(timer_wheel_t *wheel) {
+    int res;
+
+    if (wheel != NULL) {
+        timer_shutdown(wheel);
+
+        if ((res = pthread_cond_destroy(&wheel->cond)) != 0) {
+            syserr(res, "Destroying timer cond failed!\n");
+        }
+
+        if ((res = pthread_mutex_destroy(&wheel->mutex)) != 0) {
+            syserr(res, "Destroying timer mutex failed!\n");
+        }
+
+        free(wheel);
+    }
+}
@@ -0,0 +1,49 @@
+#ifndef CACTI_TIMER_H
+#define CACTI_TIMER_H
+
+#include "cacti.h"
+#include "envelope_pool.h"
+
+/* Opóźnione i okresowe wysyłanie wiadomości. Zegary są trzymane w hierarchicznym
+ * kole czasowym (TIMER_LEVELS poziomów po TIMER_SLOTS przegródek, z krokiem
+ * TIMER_TICK_US), więc dodanie, usunięcie i odpalenie zegara kosztuje O(1),
+ * niezależnie od liczby zegarów. Każdy system aktorów ma własne koło, obsługiwane
+ * przez jeden wątek, uruchamiany przy dodaniu pierwszego zegara. */
+
+#define TIMER_LEVELS (4)
+#define TIMER_SLOT_BITS (6)
+#define TIMER_SLOTS (1 << TIMER_SLOT_BITS)
+
+struct timer_wheel;
+
+typedef struct timer_wheel timer_wheel_t;
+
+/* Wysyła wiadomość zegara do aktora systemu 'target'. Zwraca 0 jeżeli się udało,
+ * lub kod błędu wysyłki, np. MAILBOX_FULL. Koperta wiadomości bierze odwołanie do pożyczki 'loan', jeżeli nie jest NULL. */
+typedef int (*timer_fire_t)(void *target, actor_id_t actor, message_t message, envelope_loan_t *loan);
+
+// Tworzy puste koło, które wysyła wiadomości przez 'fire' z argumentem 'target'.
+timer_wheel_t *timer_wheel_create(timer_fire_t fire, void *target);
+
+/* Dodaje zegar, który po 'delay_us' mikrosekundach, a potem co 'period_us'
+ * (jeżeli nie 0) wyśle 'message' do 'actor'. Zegar okresowy jest usuwany, gdy
+ * aktor nie przyjmuje już wiadomości, a odpalenie odrzucone przez pełną
+ * skrzynkę po prostu przepada. Dane na własność zegar jednorazowy przekazuje
+ * wysyłanej wiadomości, a okresowy pożycza je każdej wysłanej wiadomości, więc
+ * są zwalniane po usunięciu zegara i obsłużeniu (lub porzuceniu) wszystkich
+ * jego wiadomości. Zwraca id zegara, lub -1 gdy koło jest zatrzymane (wtedy
+ * dane zwalnia wywołujący). */
+timer_id_t timer_add(timer_wheel_t *wheel, actor_id_t actor, message_t message,
+                     unsigned long long delay_us, unsigned long long period_us);
+
+// Usuwa zegar. Zwraca 0, lub -1 gdy zegar już się odpalił, lub nie istnieje.
+int timer_cancel(timer_wheel_t *wheel, timer_id_t timer);
+
+/* Zatrzymuje wątek koła i usuwa wszystkie zegary, oddając ich dane na własność.
+ * Potem timer_add zwraca -1. */
+void timer_shutdown(timer_wheel_t *wheel);
+
+// Zatrzymuje koło, o ile nie jest już zatrzymane, i zwalnia je.
+void timer_wheel_destroy(timer_wheel_t *wheel);
+
+#endif //CACTI_TIMER_H
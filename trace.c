@@ -0,0 +1,306 @@
+#define _GNU_SOURCE
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <stdbool.h>
+#include <stdatomic.h>
+#include <time.h>
+#include <pthread.h>
+#include "trace.h"
+#include "err.h"
+
+typedef struct trace_event {
+    unsigned long long ts;
+    unsigned long long dur;
+    long actor;
+    long arg;
+    trace_kind_t kind;
+} trace_event_t;
+
+typedef struct trace_buffer {
+    pthread_t owner;
+    long worker;           // Numer wątku puli, -1 dla wątków spoza puli.
+    size_t recorded;       // Ile zdarzeń zapisano od początku (także nadpisanych).
+    trace_event_t *events;
+    struct trace_buffer *next;
+} trace_buffer_t;
+
+struct trace {
+    unsigned long serial;  // Numer śladu w procesie, zarazem numer procesu w pliku.
+    char *path;
+    size_t events;
+    unsigned long long base;
+    pthread_mutex_t mutex; // Chroni listę buforów.
+    trace_buffer_t *buffers;
+    struct trace *next;    // Lista zakończonych śladów, chroniona 'closed_mutex'.
+};
+
+static pthread_mutex_t closed_mutex = PTHREAD_MUTEX_INITIALIZER;
+static trace_t *closed = NULL;
+static atomic_ulong trace_serial = 0;
+
+/* Bufor ostatnio używanego śladu. Ślad rozpoznajemy po numerze, bo pod adresem
+ * zwolnionego śladu może już być inny. */
+static __thread trace_buffer_t *local_buffer = NULL;
+static __thread unsigned long local_serial = 0;
+
+static const char *kind_names[] = {
+    [TRACE_SCHEDULE] = "schedule",
+    [TRACE_ACTIVATION] = "activation",
+    [TRACE_SPAWN] = "spawn",
+    [TRACE_GODIE] = "godie",
+    [TRACE_IDLE] = "idle",
+    [TRACE_WAKE] = "wake"
+};
+
+static const char *arg_names[] = {
+    [TRACE_SCHEDULE] = "worker",
+    [TRACE_ACTIVATION] = "messages",
+    [TRACE_SPAWN] = "child",
+    [TRACE_GODIE] = "unused",
+    [TRACE_IDLE] = "notified",
+    [TRACE_WAKE] = "worker"
+};
+
+static void trace_lock(pthread_mutex_t *mutex) {
+    int res;
+
+    if ((res = pthread_mutex_lock(mutex)) != 0) {
+        syserr(res, "Trace mutex failed!\n");
+    }
+}
+
+static void trace_unlock(pthread_mutex_t *mutex) {
+    int res;
+
+    if ((res = pthread_mutex_unlock(mutex)) != 0) {
+        syserr(res, "Trace mutex failed!\n");
+    }
+}
+
+static unsigned long long trace_now() {
+    struct timespec ts;
+
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+
+    return (unsigned long long) ts.tv_sec * 1000000000ull + (unsigned long long) ts.tv_nsec;
+}
+
+/* Zwraca bufor bieżącego wątku w śladzie 'trace', tworząc go przy pierwszym
+ * zdarzeniu wątku w tym śladzie. Wątek pamięta tylko bufor ostatniego śladu,
+ * więc po zapisie do innego systemu szuka swojego bufora na liście. */
+static trace_buffer_t *local_trace_buffer(trace_t *trace) {
+    trace_buffer_t *buffer;
+    pthread_t self = pthread_self();
+
+    if (local_buffer != NULL && local_serial == trace->serial) {
+        return local_buffer;
+    }
+
+    trace_lock(&trace->mutex);
+
+    for (buffer = trace->buffers; buffer != NULL; buffer = buffer->next) {
+        if (pthread_equal(buffer->owner, self)) {
+            break;
+        }
+    }
+
+    if (buffer == NULL) {
+        if ((buffer = malloc(sizeof (trace_buffer_t))) == NULL ||
+            (buffer->events = malloc(sizeof (trace_event_t) * trace->events)) == NULL) {
+            fatal("Memory allocation failure!\n");
+        }
+
+        buffer->owner = self;
+        buffer->worker = -1;
+        buffer->recorded = 0;
+        buffer->next = trace->buffers;
+        trace->buffers = buffer;
+    }
+
+    trace_unlock(&trace->mutex);
+
+    local_buffer = buffer;
+    local_serial = trace->serial;
+
+    return buffer;
+}
+
+static void trace_record(trace_t *trace, trace_kind_t kind, long actor, long arg,
+                         unsigned long long ts, unsigned long long dur) {
+    trace_buffer_t *buffer = local_trace_buffer(trace);
+    trace_event_t *event = &buffer->events[buffer->recorded++ % trace->events];
+
+    event->ts = ts;
+    event->dur = dur;
+    event->actor = actor;
+    event->arg = arg;
+    event->kind = kind;
+}
+
+trace_t *trace_create(const char *path, size_t events) {
+    trace_t *trace = malloc(sizeof (trace_t));
+    int res;
+
+    if (trace == NULL || (trace->path = strdup(path)) == NULL) {
+        fatal("Memory allocation failure!\n");
+    }
+
+    if ((res = pthread_mutex_init(&trace->mutex, NULL)) != 0) {
+        syserr(res, "Trace mutex init failed!\n");
+    }
+
+    trace->serial = atomic_fetch_add(&trace_serial, 1) + 1;
+    trace->events = events;
+    trace->base = trace_now();
+    trace->buffers = NULL;
+    trace->next = NULL;
+
+    return trace;
+}
+
+void trace_register_worker(trace_t *trace, size_t index) {
+    local_trace_buffer(trace)->worker = (long) index;
+}
+
+void trace_instant(trace_t *trace, trace_kind_t kind, long actor, long arg) {
+    trace_record(trace, kind, actor, arg, trace_now(), 0);
+}
+
+void trace_complete(trace_t *trace, trace_kind_t kind, long actor, long arg, unsigned long long start) {
+    trace_record(trace, kind, actor, arg, start, trace_now() - start);
+}
+
+void trace_close(trace_t *trace) {
+    trace_lock(&closed_mutex);
+    trace->next = closed;
+    closed = trace;
+    trace_unlock(&closed_mutex);
+}
+
+// Zapisuje zdarzenia jednego bufora śladu 'trace', jako wątek 'tid'.
+static void write_buffer(FILE *file, trace_t *trace, trace_buffer_t *buffer, long tid,
+                         unsigned long long base) {
+    size_t from = buffer->recorded > trace->events ? buffer->recorded - trace->events : 0;
+
+    if (buffer->worker >= 0) {
+        fprintf(file, ",\n{\"name\":\"thread_name\",\"ph\":\"M\",\"pid\":%lu,\"tid\":%ld,"
+                      "\"args\":{\"name\":\"worker %ld\"}}", trace->serial, tid, buffer->worker);
+    }
+    else {
+        fprintf(file, ",\n{\"name\":\"thread_name\",\"ph\":\"M\",\"pid\":%lu,\"tid\":%ld,"
+                      "\"args\":{\"name\":\"external %ld\"}}", trace->serial, tid, tid);
+    }
+
+    for (size_t i = from; i < buffer->recorded; i++) {
+        trace_event_t *event = &buffer->events[i % trace->events];
+        double ts = (double) (event->ts - base) / 1000.0;
+
+        if (event->kind == TRACE_ACTIVATION || event->kind == TRACE_IDLE) {
+            fprintf(file, ",\n{\"name\":\"%s\",\"ph\":\"X\",\"ts\":%.3f,\"dur\":%.3f,\"pid\":%lu,\"tid\":%ld,",
+                    kind_names[event->kind], ts, (double) event->dur / 1000.0, trace->serial, tid);
+        }
+        else {
+            fprintf(file, ",\n{\"name\":\"%s\",\"ph\":\"i\",\"s\":\"t\",\"ts\":%.3f,\"pid\":%lu,\"tid\":%ld,",
+                    kind_names[event->kind], ts, trace->serial, tid);
+        }
+
+        fprintf(file, "\"args\":{\"actor\":%ld,\"%s\":%ld}}", event->actor, arg_names[event->kind], event->arg);
+    }
+}
+
+/* Zapisuje jeden system jako osobny proces. Wątki puli mają w śladzie swoje
+ * numery, a pozostałe kolejne numery za nimi. */
+static void write_trace(FILE *file, trace_t *trace, unsigned long long base, bool *first) {
+    long external = 0;
+    long workers = 0;
+
+    for (trace_buffer_t *buffer = trace->buffers; buffer != NULL; buffer = buffer->next) {
+        if (buffer->worker >= workers) {
+            workers = buffer->worker + 1;
+        }
+    }
+
+    fprintf(file, "%s\n{\"name\":\"process_name\",\"ph\":\"M\",\"pid\":%lu,"
+                  "\"args\":{\"name\":\"system %lu\"}}", *first ? "" : ",", trace->serial, trace->serial);
+
+    *first = false;
+
+    for (trace_buffer_t *buffer = trace->buffers; buffer != NULL; buffer = buffer->next) {
+        write_buffer(file, trace, buffer, buffer->worker >= 0 ? buffer->worker : workers + external++, base);
+    }
+}
+
+static void trace_free(trace_t *trace) {
+    int res;
+
+    while (trace->buffers != NULL) {
+        trace_buffer_t *next = trace->buffers->next;
+
+        free(trace->buffers->events);
+        free(trace->buffers);
+        trace->buffers = next;
+    }
+
+    if ((res = pthread_mutex_destroy(&trace->mutex)) != 0) {
+        syserr(res, "Trace mutex destroy failed!\n");
+    }
+
+    free(trace->path);
+    free(trace);
+}
+
+void trace_flush() {
+    trace_lock(&closed_mutex);
+
+    // Każdy plik zbiera wszystkie ślady o swojej ścieżce, z czasem liczonym od najwcześniejszego.
+    while (closed != NULL) {
+        const char *path = closed->path;
+        unsigned long long base = closed->base;
+        bool first = true;
+        FILE *file;
+
+        for (trace_t *trace = closed; trace != NULL; trace = trace->next) {
+            if (strcmp(trace->path, path) == 0 && trace->base < base) {
+                base = trace->base;
+            }
+        }
+
+        if ((file = fopen(path, "w")) == NULL) {
+            fprintf(stderr, "cacti: cannot write trace to %s\n", path);
+        }
+        else {
+            fprintf(file, "{\"displayTimeUnit\":\"ns\",\"traceEvents\":[");
+        }
+
+        trace_t *head = closed;
+
+        for (trace_t **it = &closed; *it != NULL;) {
+            trace_t *trace = *it;
+
+            if (strcmp(trace->path, path) != 0) {
+                it = &trace->next;
+                continue;
+            }
+
+            *it = trace->next;
+
+            if (file != NULL) {
+                write_trace(file, trace, base, &first);
+            }
+
+            if (trace != head) {
+                trace_free(trace);
+            }
+        }
+
+        if (file != NULL) {
+            fprintf(file, "\n]}\n");
+            fclose(file);
+        }
+
+        trace_free(head);
+    }
+
+    trace_unlock(&closed_mutex);
+}
@@ -0,0 +1,46 @@
+#ifndef CACTI_TRACE_H
+#define CACTI_TRACE_H
+
+#include <stddef.h>
+
+/* Zapis przebiegu szeregowania w formacie Chrome trace (JSON), który można
+ * otworzyć w chrome://tracing lub w Perfetto. Każdy system ma własny ślad,
+ * a w nim każdy wątek zapisuje zdarzenia do własnego bufora cyklicznego, bez
+ * żadnej synchronizacji, więc przy przepełnieniu zostają tylko najnowsze
+ * zdarzenia. Ślady zakończonych systemów są zapisywane do plików dopiero wtedy,
+ * gdy skończy się ostatni działający system, a każdy system jest w pliku
+ * osobnym procesem. */
+
+typedef enum trace_kind {
+    TRACE_SCHEDULE,   // Aktor trafił do kolejki wątku.
+    TRACE_ACTIVATION, // Przetwarzanie aktora (zdarzenie z czasem trwania).
+    TRACE_SPAWN,
+    TRACE_GODIE,
+    TRACE_IDLE,       // Wątek spał z braku pracy (zdarzenie z czasem trwania).
+    TRACE_WAKE        // Wątek obudził uśpiony wątek 'arg'.
+} trace_kind_t;
+
+typedef struct trace trace_t;
+
+/* Tworzy ślad jednego systemu, z buforami po 'events' zdarzeń na wątek,
+ * który trace_flush zapisze do pliku 'path'. */
+trace_t *trace_create(const char *path, size_t events);
+
+// Ustala numer wątku puli, który bieżący wątek ma w śladzie 'trace'.
+void trace_register_worker(trace_t *trace, size_t index);
+
+// Zapisuje zdarzenie chwilowe.
+void trace_instant(trace_t *trace, trace_kind_t kind, long actor, long arg);
+
+// Zapisuje zdarzenie trwające od chwili 'start' (w ns zegara CLOCK_MONOTONIC) do teraz.
+void trace_complete(trace_t *trace, trace_kind_t kind, long actor, long arg, unsigned long long start);
+
+/* Kończy ślad systemu. Żaden wątek nie może już do niego zapisywać zdarzeń,
+ * a ślad czeka na zapisanie przez trace_flush. */
+void trace_close(trace_t *trace);
+
+/* Zapisuje zakończone ślady do plików, ślady o tej samej ścieżce do jednego
+ * pliku, i zwalnia je. */
+void trace_flush();
+
+#endif //CACTI_TRACE_H